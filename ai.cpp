@@ -1,4 +1,5 @@
 #include "ai.h"
+#include "danger.h"
 #include "util.h"
 
 #include "ai_shiraitodai.h"
@@ -83,6 +84,11 @@ Ai *Ai::create(Who who, Girl::Id id)
 
 void Ai::onActivated(Table &table)
 {
+    mStart = Clock::now();
+    mDeadline = mTimeLimit > 0 ? mStart + std::chrono::milliseconds(mTimeLimit)
+                               : Clock::time_point::max();
+    mStats = Stats();
+
     TableView view(table.getView(mSelf));
 
     Action decision;
@@ -100,14 +106,53 @@ void Ai::onActivated(Table &table)
 #endif
 
     assert(decision.act() != ActCode::NOTHING);
+    auto spent = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - mStart);
+    mStats.micros = spent.count();
     table.action(mSelf, decision);
 }
 
+///
+/// \brief Set a soft per-decision latency budget, 0 for unlimited
+///
+/// The greedy decision is always completed, the limit only bounds
+/// how long search-based subclasses keep refining on top of it.
+///
+void Ai::setTimeLimit(int millis)
+{
+    assert(millis >= 0);
+    mTimeLimit = millis;
+}
+
+int Ai::timeLimit() const
+{
+    return mTimeLimit;
+}
+
+const Ai::Stats &Ai::lastStats() const
+{
+    return mStats;
+}
+
 Ai::Ai(Who who)
     : TableOperator(who)
 {
 }
 
+///
+/// \brief Whether refining should stop and return the best-so-far
+///
+/// Only meaningful within think() and its callees
+///
+bool Ai::timeUp() const
+{
+    return Clock::now() >= mDeadline;
+}
+
+void Ai::addIterations(int ct)
+{
+    mStats.iterations += ct;
+}
+
 Action Ai::forward(const TableView &view)
 {
     (void) view;
@@ -191,7 +236,7 @@ Action Ai::thinkDrawnAttack(const TableView &view, Limits &limits)
         return riichi;
 
     if (!limits.noAnkan())
-        for (T34 t : view.myChoices().drawn().ankans)
+        for (T34 t : view.myChoices().drawn().ankans())
             if (!view.myHand().hasEffA(t))
                 return Action(AC::ANKAN, t);
 
@@ -235,7 +280,7 @@ Action Ai::thinkBarkAttack(const TableView &view, Limits &limits)
     int rw = view.getRoundWind();
 
     if (hand.hasEffA(pick) && (barked || pick.isYakuhai(sw, rw)))
-        return thinkAttackStep(view, listCp(hand, mode, pick));
+        return thinkAttackCp(view, listCpOptions(hand, mode, pick));
 
     return Action(AC::PASS);
 }
@@ -272,6 +317,57 @@ Action Ai::thinkAttackStep(const TableView &view, const util::Stactor<Action, MA
     if (minSteps.size() == 1)
         return minSteps[0];
 
+    bool allDiscard = util::all(minSteps, [](const Action &a) { return a.isDiscard(); });
+    if (allDiscard && view.myHand().hasDrawn()
+            && view.myHand().peekDiscard(minSteps[0], &Hand::step) <= 1)
+        return thinkAttackEv(view, minSteps);
+
+    return thinkAttackEff(view, minSteps);
+}
+
+///
+/// rief Choose among same-step discards near tenpai by DiscardEv
+///
+/// Prefer the higher expected gain, then the higher tenpai rate.
+/// Remaining ties fall back to thinkAttackEff().
+///
+template<size_t MAX>
+Action Ai::thinkAttackEv(const TableView &view, const util::Stactor<Action, MAX> &outs)
+{
+    assert(!outs.empty());
+    assert(util::all(outs, [](const Action &a) { return a.isDiscard(); }));
+
+    auto happy = [&](const Action &action) {
+        DiscardEv::Ev ev = mDiscardEv.evaluate(view, action);
+        return 1 + 1000 * static_cast<int>(ev.gain) + static_cast<int>(999 * ev.tenpai);
+    };
+
+    auto maxHappys = outs.maxs(happy, 0);
+    if (maxHappys.size() == 1)
+        return maxHappys[0];
+
+    return thinkAttackEff(view, maxHappys);
+}
+
+///
+/// \brief Same as thinkAttackStep() on the actions, using the known steps
+///
+Action Ai::thinkAttackCp(const TableView &view, const util::Stactor<CpOption, 44> &opts)
+{
+    assert(!opts.empty());
+
+    int minStep = Hand::STEP_INF;
+    for (const CpOption &opt : opts)
+        minStep = std::min(minStep, opt.step);
+
+    util::Stactor<Action, 44> minSteps;
+    for (const CpOption &opt : opts)
+        if (opt.step == minStep)
+            minSteps.pushBack(opt.act);
+
+    if (minSteps.size() == 1)
+        return minSteps[0];
+
     return thinkAttackEff(view, minSteps);
 }
 
@@ -281,11 +377,13 @@ Action Ai::thinkAttackEff(const TableView &view, const util::Stactor<Action, MAX
     assert(!outs.empty());
     assert(util::all(outs, [](const Action &a) { return a.isDiscard() || a.isCp(); }));
 
+    TileCount remain = view.visibleRemain();
+
     auto happy = [&](const Action &action) {
         const T37 &out = view.myHand().outFor(action);
         auto effA = action.isDiscard() ? view.myHand().peekDiscard(action, &Hand::effA)
                                        : view.myHand().peekCp(view.getFocusTile(), action, &Hand::effA);
-        int remainEffA = view.visibleRemain().ct(effA);
+        int remainEffA = remain.ct(effA);
         int floatTrash = (5 - (view.getDrids() % out + out.isAka5()))
                 + 2 * (view.getRiver(mSelf).size() < 6 ? out.isYao() : !out.isYao());
 
@@ -303,12 +401,11 @@ Action Ai::thinkDefendChance(const TableView &view, const util::Stactor<Action,
     assert(!outs.empty());
     assert(util::all(outs, [](const Action &a) { return a.isDiscard() || a.isCp(); }));
 
+    DangerMap danger(view, threats);
+
     auto happy = [&](const Action &action) {
         const T37 &out = view.myHand().outFor(action);
-        int cc = 0;
-        for (Who who : threats)
-            cc = std::max(cc, chance(view, who, out));
-        int safe = 20 - cc;
+        int safe = 20 - danger.maxChance(out);
         return 100 * safe + 10 * (view.getDrids() % out + out.isAka5()) + (34 - out.id34());
     };
 
@@ -326,11 +423,7 @@ bool Ai::afraid(const TableView &view, util::Stactor<Who, 3> &threats)
             Who who(w);
             if (who == mSelf)
                 continue;
-            int riverCt = view.getRiver(who).size();
-            int barkCt = view.getBarks(who).size();
-            if (view.riichiEstablished(who)
-                    || (riverCt > 5 && barkCt >= 2)
-                    || (riverCt > 12 && barkCt >= 1))
+            if (view.waitEstimate().tenpaiRate(who) >= 500)
                 threats.pushBack(who);
         }
 
@@ -362,40 +455,6 @@ bool Ai::testRiichi(const TableView &view, Limits &limits, Action &riichi)
     return est < 7000;
 }
 
-int Ai::chance(const TableView &view, Who tar, T34 t)
-{
-    // 'min' because it is ok if one of rule or logic gives a reason
-    return std::min(ruleChance(view, tar, t), logicChance(view, t));
-}
-
-int Ai::ruleChance(const TableView &view, Who tar, T34 t)
-{
-    if (view.genbutsu(tar, t))
-        return 0;
-
-    return 19; // 19 is maximum chance
-}
-
-int Ai::logicChance(const TableView &view, T34 t)
-{
-    util::Stactor<T34, 5> waiters;
-
-    waiters.pushBack(t); // bibump and isoride cases
-
-    if (t.isNum()) { // all possible neighbors
-        if (t.val() > 1)
-            waiters.pushBack(t.prev());
-        if (t.val() > 2)
-            waiters.pushBack(t.pprev());
-        if (t.val() < 8)
-            waiters.pushBack(t.nnext());
-        if (t.val() < 9)
-            waiters.pushBack(t.next());
-    }
-
-    return view.visibleRemain().ct(waiters);
-}
-
 util::Stactor<Action, 14> Ai::listOuts(const TableView &view, const Limits &limits)
 {
     util::Stactor<Action, 14> res;
@@ -419,10 +478,10 @@ util::Stactor<Action, 14> Ai::listRiichisAsOut(const Hand &hand, const Choices::
     util::Stactor<Action, 14> res;
 
     assert(hand.hasDrawn());
-    if (!limits.noOut(hand.drawn()) && mode.spinRiichi)
+    if (!limits.noOut(hand.drawn()) && mode.spinRiichi())
         res.pushBack(Action(ActCode::SPIN_OUT));
 
-    for (const T37 &t : mode.swapRiichis)
+    for (const T37 &t : mode.swapRiichis())
         if (!limits.noOut(t))
             res.pushBack(Action(ActCode::SWAP_OUT, t));
 
@@ -432,36 +491,96 @@ util::Stactor<Action, 14> Ai::listRiichisAsOut(const Hand &hand, const Choices::
 util::Stactor<Action, 44> Ai::listCp(const Hand &hand, const Choices::ModeBark &mode,
                                      const T37 &pick, bool noChii)
 {
+    using AC = ActCode;
+
     util::Stactor<Action, 44> res;
 
+    // the calls themselves do not depend on the out tile
+    bool l = !noChii && mode.chiiL && hand.canChiiAsLeft(pick);
+    bool m = !noChii && mode.chiiM && hand.canChiiAsMiddle(pick);
+    bool r = !noChii && mode.chiiR && hand.canChiiAsRight(pick);
+    bool p = mode.pon && hand.canPon(pick);
+    if (!(l || m || r || p))
+        return res;
+
     for (const T37 &out : tiles37::ORDER37) {
         if (hand.closed().ct(out) >= 1) {
-            if (!noChii) {
-                if (mode.chiiL) {
-                    Action act(ActCode::CHII_AS_LEFT, 2, out);
-                    if (hand.canCp(pick, act))
-                        res.pushBack(act);
-                }
-
-                if (mode.chiiM) {
-                    Action act(ActCode::CHII_AS_MIDDLE, 2, out);
-                    if (hand.canCp(pick, act))
-                        res.pushBack(act);
-                }
-
-                if (mode.chiiR) {
-                    Action act(ActCode::CHII_AS_RIGHT, 2, out);
-                    if (hand.canCp(pick, act))
-                        res.pushBack(act);
-                }
+            for (AC ac : { AC::CHII_AS_LEFT, AC::CHII_AS_MIDDLE, AC::CHII_AS_RIGHT, AC::PON }) {
+                bool on = ac == AC::CHII_AS_LEFT ? l
+                        : ac == AC::CHII_AS_MIDDLE ? m
+                        : ac == AC::CHII_AS_RIGHT ? r : p;
+                Action act(ac, 2, out);
+                if (on && hand.canCpOut(pick, act))
+                    res.pushBack(act);
             }
+        }
+    }
 
-            if (mode.pon) {
-                Action act(ActCode::PON, 2, out);
-                if (hand.canCp(pick, act))
-                    res.pushBack(act);
+    return res;
+}
+
+///
+/// \brief listCp() with the step after each call
+///
+/// Calls leaving the same closed tiles share one step computation,
+/// and no peek guard is involved.
+///
+util::Stactor<Ai::CpOption, 44> Ai::listCpOptions(const Hand &hand, const Choices::ModeBark &mode,
+                                                  const T37 &pick, bool noChii)
+{
+    using AC = ActCode;
+
+    util::Stactor<CpOption, 44> res;
+    util::Stactor<std::array<int, 3>, 44> removeds; // sorted id34s leaving the hand
+    util::Stactor<int, 44> steps;
+
+    int barkCt = static_cast<int>(hand.barks().size()) + 1;
+    TileCount closed(hand.closed());
+
+    for (const Action &act : listCp(hand, mode, pick, noChii)) {
+        T34 p(pick);
+        std::array<int, 3> removed;
+        switch (act.act()) {
+        case AC::CHII_AS_LEFT:
+            removed = { p.next().id34(), p.nnext().id34(), act.t37().id34() };
+            break;
+        case AC::CHII_AS_MIDDLE:
+            removed = { p.prev().id34(), p.next().id34(), act.t37().id34() };
+            break;
+        case AC::CHII_AS_RIGHT:
+            removed = { p.pprev().id34(), p.prev().id34(), act.t37().id34() };
+            break;
+        default:
+            removed = { p.id34(), p.id34(), act.t37().id34() };
+            break;
+        }
+
+        std::sort(removed.begin(), removed.end());
+
+        int step = Hand::STEP_INF;
+        for (size_t i = 0; i < removeds.size(); i++)
+            if (removeds[i] == removed)
+                step = steps[i];
+
+        if (step == Hand::STEP_INF) {
+            util::Stactor<T37, 3> taken;
+            for (int id34 : removed) {
+                T37 t(id34);
+                if (closed.ct(t) == 0)
+                    t = t.toAka5();
+                closed.inc(t, -1);
+                taken.pushBack(t);
             }
+
+            step = closed.step(barkCt);
+            for (const T37 &t : taken)
+                closed.inc(t, 1);
+
+            removeds.pushBack(removed);
+            steps.pushBack(step);
         }
+
+        res.pushBack(CpOption { act, step });
     }
 
     return res;
@@ -2,8 +2,10 @@
 #define SAKI_AI_H
 
 #include "table.h"
+#include "discard_ev.h"
 
 #include <functional>
+#include <chrono>
 
 
 
@@ -44,6 +46,24 @@ public:
         std::bitset<34> mNoOut34s;
     };
 
+    ///
+    /// \brief Cost of the latest decision, for latency monitoring
+    ///
+    struct Stats
+    {
+        long long micros = 0; ///< wall time spent in the decision
+        int iterations = 0; ///< search steps done by refining AIs, 0 for greedy
+    };
+
+    ///
+    /// \brief A legal chii or pon with the step of the hand after it
+    ///
+    struct CpOption
+    {
+        Action act;
+        int step;
+    };
+
     static Ai *create(Who who, Girl::Id id);
 
     virtual ~Ai() = default;
@@ -53,9 +73,16 @@ public:
 
     void onActivated(Table &table) final;
 
+    void setTimeLimit(int millis);
+    int timeLimit() const;
+    const Stats &lastStats() const;
+
 protected:
     Ai(Who who);
 
+    bool timeUp() const;
+    void addIterations(int ct);
+
     Action maxHappy(const TableView &view);
     virtual Action forward(const TableView &view);
     virtual Action think(const TableView &view, Limits &limits);
@@ -76,24 +103,34 @@ protected:
 
     template<size_t MAX>
     Action thinkAttackStep(const TableView &view, const util::Stactor<Action, MAX> &outs);
+    Action thinkAttackCp(const TableView &view, const util::Stactor<CpOption, 44> &opts);
     template<size_t MAX>
     Action thinkAttackEff(const TableView &view, const util::Stactor<Action, MAX> &outs);
     template<size_t MAX>
+    Action thinkAttackEv(const TableView &view, const util::Stactor<Action, MAX> &outs);
+    template<size_t MAX>
     Action thinkDefendChance(const TableView &view, const util::Stactor<Action, MAX> &outs,
                                     const util::Stactor<Who, 3> &threats);
 
     bool afraid(const TableView &view, util::Stactor<Who, 3> &threats);
     bool testRiichi(const TableView &view, Limits &limits, Action &riichi);
 
-    int chance(const TableView &view, Who tar, T34 t);
-    int ruleChance(const TableView &view, Who tar, T34 t);
-    int logicChance(const TableView &view, T34 t);
-
     util::Stactor<Action, 14> listOuts(const TableView &view, const Limits &limits);
     util::Stactor<Action, 14> listRiichisAsOut(const Hand &hand, const Choices::ModeDrawn &mode,
                                                const Limits &limits);
     util::Stactor<Action, 44> listCp(const Hand &hand, const Choices::ModeBark &mode,
                                      const T37 &pick, bool noChii = false);
+    util::Stactor<CpOption, 44> listCpOptions(const Hand &hand, const Choices::ModeBark &mode,
+                                              const T37 &pick, bool noChii = false);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int mTimeLimit = 0;
+    Clock::time_point mStart;
+    Clock::time_point mDeadline;
+    Stats mStats;
+    DiscardEv mDiscardEv { 1 };
 };
 
 
@@ -0,0 +1,226 @@
+#include "ai_rollout.h"
+#include "util_parallel.h"
+
+#include <climits>
+
+
+
+namespace saki
+{
+
+
+
+AiRollout::AiRollout(Who who)
+    : Ai(who)
+{
+    setTimeLimit(200);
+}
+
+AiRollout::AiRollout(Who who, const Budget &budget)
+    : Ai(who)
+    , mBudget(budget)
+{
+    setTimeLimit(200);
+}
+
+Action AiRollout::think(const TableView &view, Limits &limits)
+{
+    Action greedy = Ai::think(view, limits);
+
+    const Choices &choices = view.myChoices();
+    if (choices.mode() != Choices::Mode::DRAWN || choices.forwardAny()
+            || view.riichiEstablished(mSelf))
+        return greedy;
+
+    if (!(greedy.isDiscard() || greedy.isRiichi()))
+        return greedy; // tsumo, ryuukyoku, ankan, etc.
+
+    auto cands = listCandidates(view, limits, greedy);
+    if (cands.size() <= 1)
+        return greedy;
+
+    const size_t n = cands.size();
+    std::vector<long long> sums(n, 0);
+    std::vector<int> cts(n, 0);
+    std::vector<int> deltas(n);
+    uint32_t salt = static_cast<uint32_t>(mSelf.index() + 4 * view.getRound());
+    for (int w = 0; w < 4; w++)
+        salt = salt * 31 + static_cast<uint32_t>(view.getRiver(Who(w)).size());
+
+    // one rollout per candidate per pass, so all of them progress evenly
+    for (int pass = 0; pass < mBudget.maxRollouts && !timeUp(); pass++) {
+        auto job = [&](size_t c) {
+            deltas[c] = INT_MIN;
+            if (timeUp())
+                return;
+            size_t i = pass * n + c;
+            uint32_t seed = static_cast<uint32_t>((i + 1) * 2654435761u) ^ (salt * 40503u);
+            seed = 1 + seed % 2147483646u; // minstd_rand rejects 0
+            deltas[c] = rollout(view, cands[c], seed);
+        };
+
+        util::parallelFor(n, mBudget.threads, job);
+
+        for (size_t c = 0; c < n; c++) {
+            if (deltas[c] != INT_MIN) {
+                sums[c] += deltas[c];
+                cts[c]++;
+                addIterations(1);
+            }
+        }
+    }
+
+    size_t best = 0; // greedy wins ties since it is listed first
+    for (size_t c = 0; c < n; c++) {
+        if (cts[c] < mBudget.minRollouts)
+            return greedy;
+        if (sums[c] * cts[best] > sums[best] * cts[c])
+            best = c;
+    }
+
+    return cands[best];
+}
+
+///
+/// \brief Discards and riichis worth simulating, 'greedy' comes first
+///
+/// Candidates more than one step behind the best are dropped
+///
+util::Stactor<Action, 28> AiRollout::listCandidates(const TableView &view, const Limits &limits,
+                                                    const Action &greedy)
+{
+    util::Stactor<Action, 28> all;
+    for (const Action &out : listOuts(view, limits))
+        all.pushBack(out);
+
+    const Choices &choices = view.myChoices();
+    if (!limits.noRiichi()
+            && (choices.can(ActCode::SWAP_RIICHI) || choices.can(ActCode::SPIN_RIICHI)))
+        for (const Action &out : listRiichisAsOut(view.myHand(), view.myChoices().drawn(), limits))
+            all.pushBack(out.toRiichi());
+
+    const Hand &hand = view.myHand();
+    auto stepOf = [&hand](const Action &act) {
+        Action out = act.act() == ActCode::SPIN_RIICHI ? Action(ActCode::SPIN_OUT)
+                   : act.act() == ActCode::SWAP_RIICHI ? Action(ActCode::SWAP_OUT, act.t37())
+                   : act;
+        return hand.peekDiscard(out, &Hand::step);
+    };
+
+    int minStep = Hand::STEP_INF;
+    for (const Action &act : all)
+        minStep = std::min(minStep, stepOf(act));
+
+    util::Stactor<Action, 28> res;
+    res.pushBack(greedy);
+    for (const Action &act : all)
+        if (!(act == greedy) && stepOf(act) <= minStep + 1)
+            res.pushBack(act);
+
+    return res;
+}
+
+///
+/// \brief Play the round out once from 'first'
+/// \return point delta of self at the end of the round
+///
+int AiRollout::rollout(const TableView &view, const Action &first, uint32_t seed) const
+{
+    RolloutOp op0(Who(0)), op1(Who(1)), op2(Who(2)), op3(Who(3));
+    std::array<TableOperator*, 4> ops { &op0, &op1, &op2, &op3 };
+    std::vector<TableObserver*> obs;
+
+    Table future(view, ops, obs, seed);
+    int before = future.getPoints()[mSelf.index()];
+    future.action(mSelf, first);
+    return future.getPoints()[mSelf.index()] - before;
+}
+
+
+
+void RolloutOp::onActivated(Table &table)
+{
+    TableView view(table.getView(mSelf));
+    Action decision = think(view);
+
+    if (decision.act() == ActCode::NOTHING)
+        return; // halt the future table
+
+    if (!table.check(mSelf, decision))
+        decision = view.mySweep();
+
+    if (decision.act() != ActCode::NOTHING)
+        table.action(mSelf, decision);
+}
+
+Action RolloutOp::think(const TableView &view) const
+{
+    using AC = ActCode;
+    const Choices &choices = view.myChoices();
+
+    if (choices.forwardAny())
+        return view.mySweep();
+
+    switch (choices.mode()) {
+    case Choices::Mode::END:
+        return Action(); // one round is enough
+    case Choices::Mode::BARK:
+        return Action(choices.can(AC::RON) ? AC::RON : AC::PASS);
+    case Choices::Mode::DRAWN:
+        break;
+    default:
+        return view.mySweep();
+    }
+
+    if (choices.can(AC::TSUMO))
+        return Action(AC::TSUMO);
+
+    const Choices::ModeDrawn &mode = choices.drawn();
+    if (mode.spinRiichi())
+        return Action(AC::SPIN_RIICHI);
+    if (!mode.swapRiichis().empty())
+        return Action(AC::SWAP_RIICHI, mode.swapRiichis()[0]);
+
+    if (!choices.can(AC::SWAP_OUT))
+        return Action(AC::SPIN_OUT);
+
+    // throw an isolated tile, honors first, or just throw the drawn one
+    const Hand &hand = view.myHand();
+    TileCount all(hand.closed());
+    all.inc(hand.drawn(), 1);
+
+    auto isolated = [&all](T34 t) {
+        if (all.ct(t) != 1)
+            return false;
+        if (!t.isNum())
+            return true;
+        for (int d = -2; d <= 2; d++) {
+            int v = t.val() + d;
+            if (d != 0 && 1 <= v && v <= 9 && all.ct(T34(t.suit(), v)) > 0)
+                return false;
+        }
+        return true;
+    };
+
+    if (isolated(hand.drawn()) && hand.drawn().isZ())
+        return Action(AC::SPIN_OUT);
+
+    Action num;
+    for (const T37 &t : hand.closed().t37s13()) {
+        if (isolated(t)) {
+            if (t.isZ())
+                return Action(AC::SWAP_OUT, t);
+            if (num.act() == AC::NOTHING)
+                num = Action(AC::SWAP_OUT, t);
+        }
+    }
+
+    if (isolated(hand.drawn()) || num.act() == AC::NOTHING)
+        return Action(AC::SPIN_OUT);
+
+    return num;
+}
+
+
+
+} // namespace saki
@@ -0,0 +1,76 @@
+#ifndef SAKI_AI_ROLLOUT_H
+#define SAKI_AI_ROLLOUT_H
+
+#include "ai.h"
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Monte Carlo AI, decides discards by playing the round out
+///
+/// For each candidate discard, the hidden tiles are redealt from the
+/// viewer's unseen tiles (see Table's view-forking constructor) and the
+/// round is played to the end by cheap default policies.
+/// The candidate with the best mean point delta is chosen.
+/// Other decisions, and the case of running out of time before every
+/// candidate got its minimum rollouts, fall back to the greedy Ai.
+///
+/// Rollouts run in passes of one per candidate until the time limit
+/// (see Ai::setTimeLimit, 200ms by default) or the rollout cap is hit.
+///
+/// Unlike Ai, the output depends on the time budget, thus is not
+/// reproducible. Do not use it where prediction skills are involved.
+///
+class AiRollout : public Ai
+{
+public:
+    struct Budget
+    {
+        int minRollouts = 8; ///< per candidate, otherwise greedy fallback
+        int maxRollouts = 256; ///< per candidate
+        int threads = 0; ///< 0 for hardware concurrency
+    };
+
+    explicit AiRollout(Who who);
+    explicit AiRollout(Who who, const Budget &budget);
+
+protected:
+    Action think(const TableView &view, Limits &limits) override;
+
+private:
+    util::Stactor<Action, 28> listCandidates(const TableView &view, const Limits &limits,
+                                             const Action &greedy);
+    int rollout(const TableView &view, const Action &first, uint32_t seed) const;
+
+private:
+    Budget mBudget;
+};
+
+
+
+///
+/// \brief Default policy inside rollouts, cheap and never thinks twice
+///
+class RolloutOp : public TableOperator
+{
+public:
+    explicit RolloutOp(Who self) : TableOperator(self) { }
+
+    void onActivated(Table &table) override;
+
+private:
+    Action think(const TableView &view) const;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_AI_ROLLOUT_H
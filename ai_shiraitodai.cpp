@@ -55,9 +55,9 @@ Action AiSeiko::think(const TableView &view, Limits &limits)
                 return Action(ac);
 
         if (choices.can(AC::PON)) {
-            auto list = listCp(view.myHand(), view.myChoices().bark(),
-                               view.getFocusTile(), true);
-            return Ai::thinkAttackStep(view, list);
+            auto list = listCpOptions(view.myHand(), view.myChoices().bark(),
+                                      view.getFocusTile(), true);
+            return Ai::thinkAttackCp(view, list);
         }
 
         return Action(ActCode::PASS);
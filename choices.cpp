@@ -11,6 +11,112 @@ namespace saki
 
 
 
+Choices::ModeDrawn::ModeDrawn(const Hand &hand, const PointInfo &info, const RuleInfo &rule,
+                              bool riichiOk, bool kanOk, bool riichiEstablished)
+    : mHand(hand)
+    , mInfo(info)
+    , mRule(rule)
+    , mRiichiEstablished(riichiEstablished)
+{
+    assert(hand.hasDrawn());
+    // the wait mask is of the closed part, so this is step() == -1
+    mMayTsumo = (mHand.waitMask() >> hand.drawn().id34()) & 1;
+    mMayRiichi = riichiOk && hand.isMenzen() && hand.step() <= 0;
+    mMayKan = kanOk;
+}
+
+bool Choices::ModeDrawn::mayTsumo() const
+{
+    return mMayTsumo;
+}
+
+bool Choices::ModeDrawn::mayRiichi() const
+{
+    return mMayRiichi;
+}
+
+bool Choices::ModeDrawn::mayKan() const
+{
+    return mMayKan;
+}
+
+bool Choices::ModeDrawn::tsumo() const
+{
+    if (!mMayTsumo)
+        return false;
+
+    if (!mTsumoSolved) {
+        mTsumo = mHand.canTsumo(mInfo, mRule);
+        mTsumoSolved = true;
+    }
+
+    return mTsumo;
+}
+
+bool Choices::ModeDrawn::spinRiichi() const
+{
+    solveRiichi();
+    return mSpinRiichi;
+}
+
+const util::Stactor<T37, 13> &Choices::ModeDrawn::swapRiichis() const
+{
+    solveRiichi();
+    return mSwapRiichis;
+}
+
+const util::Stactor<T34, 3> &Choices::ModeDrawn::ankans() const
+{
+    solveKan();
+    return mAnkans;
+}
+
+const util::Stactor<int, 3> &Choices::ModeDrawn::kakans() const
+{
+    solveKan();
+    return mKakans;
+}
+
+void Choices::ModeDrawn::banTsumo()
+{
+    mMayTsumo = false;
+}
+
+void Choices::ModeDrawn::banRiichi()
+{
+    mMayRiichi = false;
+    mRiichiSolved = true;
+    mSpinRiichi = false;
+    mSwapRiichis.clear();
+}
+
+void Choices::ModeDrawn::solveRiichi() const
+{
+    if (mRiichiSolved)
+        return;
+
+    if (mMayRiichi)
+        mHand.canRiichi(mSwapRiichis, mSpinRiichi);
+
+    mRiichiSolved = true;
+}
+
+void Choices::ModeDrawn::solveKan() const
+{
+    if (mKanSolved)
+        return;
+
+    // must be able to maintain king-14, and forbid 5th kan
+    if (mMayKan) {
+        mHand.canAnkan(mAnkans, mRiichiEstablished);
+        mHand.canKakan(mKakans);
+    }
+
+    mKanSolved = true;
+}
+
+
+
 bool Choices::ModeBark::any() const
 {
     return chiiL || chiiM || chiiR || pon || dmk || ron;
@@ -48,17 +154,17 @@ bool Choices::can(ActCode act) const
         case AC::SPIN_OUT:
             return true;
         case AC::SWAP_RIICHI:
-            return !mModeDrawn.swapRiichis.empty();
+            return !mModeDrawn.swapRiichis().empty();
         case AC::SPIN_RIICHI:
-            return mModeDrawn.spinRiichi;
+            return mModeDrawn.spinRiichi();
         case AC::TSUMO:
-            return mModeDrawn.tsumo;
+            return mModeDrawn.tsumo();
         case AC::RYUUKYOKU:
             return mModeDrawn.kskp;
         case AC::ANKAN:
-            return !mModeDrawn.ankans.empty();
+            return !mModeDrawn.ankans().empty();
         case AC::KAKAN:
-            return !mModeDrawn.kakans.empty();
+            return !mModeDrawn.kakans().empty();
         default:
             return false;
         }
@@ -115,12 +221,12 @@ bool Choices::spinOnly() const
     return mMode == Mode::DRAWN
             && !forwardAny()
             && !mModeDrawn.swapOut
-            && !mModeDrawn.spinRiichi
-            && !mModeDrawn.tsumo
             && !mModeDrawn.kskp
-            && mModeDrawn.ankans.empty()
-            && mModeDrawn.kakans.empty()
-            && mModeDrawn.swapRiichis.empty();
+            && !mModeDrawn.tsumo()
+            && !mModeDrawn.spinRiichi()
+            && mModeDrawn.swapRiichis().empty()
+            && mModeDrawn.ankans().empty()
+            && mModeDrawn.kakans().empty();
 }
 
 Action Choices::sweep() const
@@ -2,6 +2,7 @@
 #define SAKI_CHOICES_H
 
 #include "action.h"
+#include "hand.h"
 #include "util_stactor.h"
 
 
@@ -18,15 +19,58 @@ public:
         WATCH, CUT, DICE, DRAWN, BARK, END
     };
 
-    struct ModeDrawn
+    ///
+    /// \brief Choices after a draw, the costly ones solved on first query
+    ///
+    /// Keeps a copy of the hand at draw time, so the answers are the same
+    /// as if they were computed eagerly by Table::tryDraw().
+    /// The may*() flags are cheap necessary conditions.
+    ///
+    class ModeDrawn
     {
+    public:
+        ModeDrawn() = default;
+        explicit ModeDrawn(const Hand &hand, const PointInfo &info, const RuleInfo &rule,
+                           bool riichiOk, bool kanOk, bool riichiEstablished);
+
+        bool mayTsumo() const;
+        bool mayRiichi() const;
+        bool mayKan() const;
+
+        bool tsumo() const;
+        bool spinRiichi() const;
+        const util::Stactor<T37, 13> &swapRiichis() const;
+        const util::Stactor<T34, 3> &ankans() const;
+        const util::Stactor<int, 3> &kakans() const;
+
+        void banTsumo();
+        void banRiichi();
+
+    public:
         bool swapOut = false;
-        bool spinRiichi = false;
-        bool tsumo = false;
         bool kskp = false;
-        util::Stactor<T34, 3> ankans;
-        util::Stactor<int, 3> kakans;
-        util::Stactor<T37, 13> swapRiichis;
+
+    private:
+        void solveRiichi() const;
+        void solveKan() const;
+
+    private:
+        mutable Hand mHand; // peeked by the solvers
+        PointInfo mInfo;
+        RuleInfo mRule;
+        bool mRiichiEstablished = false;
+        bool mMayTsumo = false;
+        bool mMayRiichi = false;
+        bool mMayKan = false;
+
+        mutable bool mTsumoSolved = false;
+        mutable bool mRiichiSolved = false;
+        mutable bool mKanSolved = false;
+        mutable bool mTsumo = false;
+        mutable bool mSpinRiichi = false;
+        mutable util::Stactor<T37, 13> mSwapRiichis;
+        mutable util::Stactor<T34, 3> mAnkans;
+        mutable util::Stactor<int, 3> mKakans;
     };
 
     struct ModeBark
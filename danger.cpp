@@ -0,0 +1,117 @@
+#include "danger.h"
+
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+DangerMap::DangerMap(const TableView &view, const util::Stactor<Who, 3> &threats)
+    : mRows(static_cast<int>(threats.size()))
+{
+    // one recount for all cells
+    TileCount remain = view.visibleRemain();
+
+    for (int ti = 0; ti < 34; ti++) {
+        T34 t(ti);
+        int sum = remain.ct(t); // bibump and isoride cases
+        if (t.isNum()) { // all possible neighbors
+            if (t.val() > 1)
+                sum += remain.ct(t.prev());
+            if (t.val() > 2)
+                sum += remain.ct(t.pprev());
+            if (t.val() < 8)
+                sum += remain.ct(t.nnext());
+            if (t.val() < 9)
+                sum += remain.ct(t.next());
+        }
+
+        mWaiterRemains[ti] = static_cast<int8_t>(sum);
+    }
+
+    for (int r = 0; r < mRows; r++) {
+        Who who = threats[r];
+        for (int ti = 0; ti < 34; ti++)
+            mGenbutsus[r][ti] = view.genbutsu(who, T34(ti));
+
+        for (int ti = 0; ti < 34; ti++) {
+            T34 t(ti);
+            int logic = mWaiterRemains[ti];
+            if (t.isNum()) {
+                // a genbutsu three tiles away cuts the ryanmen on that side,
+                // whose outer tile then waits on 't' no more
+                bool lowCut = t.val() >= 4 && mGenbutsus[r][ti - 3];
+                bool highCut = t.val() <= 6 && mGenbutsus[r][ti + 3];
+                if (lowCut)
+                    logic -= remain.ct(t.pprev());
+                if (highCut)
+                    logic -= remain.ct(t.nnext());
+                mSujis[r][ti] = (t.val() <= 3 || lowCut) && (t.val() >= 7 || highCut);
+            }
+
+            // 'min' because it is ok if one of rule or logic gives a reason
+            int rule = mGenbutsus[r][ti] ? 0 : MAX_CHANCE;
+            mChances[r][ti] = static_cast<int8_t>(std::min(rule, logic));
+        }
+    }
+}
+
+///
+/// \brief Visible remaining waiters on 't' that the threat at 'row' may use
+///
+/// Zero for genbutsu. Ryanmen waits cut by suji are not counted,
+/// so a suji tile is safer than its plain neighbors.
+///
+int DangerMap::chance(int row, T34 t) const
+{
+    assert(0 <= row && row < mRows);
+    return mChances[row][t.id34()];
+}
+
+///
+/// \return the highest chance among all threats, 0 if there is none
+///
+int DangerMap::maxChance(T34 t) const
+{
+    int res = 0;
+    for (int r = 0; r < mRows; r++)
+        res = std::max(res, int(mChances[r][t.id34()]));
+    return res;
+}
+
+///
+/// \brief Visible remaining count of tiles that can wait on 't'
+///
+int DangerMap::waiterRemain(T34 t) const
+{
+    return mWaiterRemains[t.id34()];
+}
+
+bool DangerMap::genbutsu(int row, T34 t) const
+{
+    assert(0 <= row && row < mRows);
+    return mGenbutsus[row].test(t.id34());
+}
+
+///
+/// \brief Whether the tile is suji against the threat at 'row'
+///
+/// Only number tiles can be suji. A 4, 5, or 6 needs both sides.
+///
+bool DangerMap::suji(int row, T34 t) const
+{
+    assert(0 <= row && row < mRows);
+    return mSujis[row].test(t.id34());
+}
+
+int DangerMap::rows() const
+{
+    return mRows;
+}
+
+
+
+} // namespace saki
@@ -0,0 +1,54 @@
+#ifndef SAKI_DANGER_H
+#define SAKI_DANGER_H
+
+#include "tableview.h"
+
+#include <bitset>
+#include <array>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Per-turn danger of each tile kind against up to three threats
+///
+/// Built once from the viewer's visible remaining counts, the threats'
+/// genbutsu flags and the suji relations among them, then shared by
+/// defense and skill code. A row is a threat, in the order given to
+/// the constructor.
+///
+class DangerMap
+{
+public:
+    static const int MAX_CHANCE = 19;
+
+    explicit DangerMap(const TableView &view, const util::Stactor<Who, 3> &threats);
+    DangerMap(const DangerMap &copy) = default;
+    DangerMap &operator=(const DangerMap &assign) = default;
+
+    int chance(int row, T34 t) const;
+    int maxChance(T34 t) const;
+    int waiterRemain(T34 t) const;
+    bool genbutsu(int row, T34 t) const;
+    bool suji(int row, T34 t) const;
+    int rows() const;
+
+private:
+    std::array<std::array<int8_t, 34>, 3> mChances;
+    std::array<int8_t, 34> mWaiterRemains;
+    std::array<std::bitset<34>, 3> mGenbutsus;
+    std::array<std::bitset<34>, 3> mSujis;
+    int mRows;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_DANGER_H
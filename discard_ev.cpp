@@ -0,0 +1,231 @@
+#include "discard_ev.h"
+#include "form.h"
+
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+DiscardEv::DiscardEv(int maxDepth)
+    : mMaxDepth(maxDepth)
+{
+    assert(maxDepth >= 0);
+}
+
+///
+/// \brief Evaluate discarding 'out' from the viewer's drawn hand
+///
+DiscardEv::Ev DiscardEv::evaluate(const TableView &view, const Action &out)
+{
+    const Hand &hand = view.myHand();
+    assert(hand.hasDrawn());
+    assert(out.isDiscard());
+
+    uint64_t ctx = mCtx;
+    setContext(view);
+    if (mCtx != ctx)
+        mTable.clear();
+
+    TileCount closed(hand.closed());
+    closed.inc(hand.drawn(), 1);
+    closed.inc(hand.outFor(out), -1);
+
+    int depth = std::min(mMaxDepth, view.wallRemain() / 4);
+    return value(closed, depth);
+}
+
+///
+/// \brief Drop the transposition table and the hit count
+///
+void DiscardEv::reset()
+{
+    mTable.clear();
+    mHits = 0;
+}
+
+size_t DiscardEv::tableSize() const
+{
+    return mTable.size();
+}
+
+long long DiscardEv::hits() const
+{
+    return mHits;
+}
+
+bool DiscardEv::Key::operator==(const Key &that) const
+{
+    return lo == that.lo && hi == that.hi;
+}
+
+size_t DiscardEv::KeyHash::operator()(const Key &key) const
+{
+    uint64_t h = key.lo * 0x9e3779b97f4a7c15ull;
+    h ^= key.hi + 0x7f4a7c159e3779b9ull + (h << 6) + (h >> 2);
+    return static_cast<size_t>(h);
+}
+
+void DiscardEv::setContext(const TableView &view)
+{
+    // FNV-1a over everything a value depends on besides the hand
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](int v) {
+        h ^= static_cast<uint64_t>(v + 1);
+        h *= 0x100000001b3ull;
+    };
+
+    TileCount remain = view.visibleRemain();
+    mRemainSum = 0;
+    for (int ti = 0; ti < 34; ti++) {
+        mRemains[ti] = remain.ct(T34(ti));
+        mRemainSum += mRemains[ti];
+        mix(mRemains[ti]);
+    }
+
+    mBarks = view.myHand().barks();
+    for (const M37 &m : mBarks) {
+        mix(static_cast<int>(m.type()));
+        for (const T37 &t : m.tiles())
+            mix(t.id34() + 34 * t.isAka5());
+    }
+
+    mDrids = view.getDrids();
+    mix(-1);
+    for (const T37 &t : mDrids)
+        mix(t.id34() + 34 * t.isAka5());
+
+    mInfo = PointInfo();
+    mInfo.selfWind = view.getSelfWind(view.self());
+    mInfo.roundWind = view.getRoundWind();
+    mix(mInfo.selfWind);
+    mix(mInfo.roundWind);
+
+    mRule = view.getRuleInfo();
+    mCtx = h;
+}
+
+///
+/// \param closed 13 minus 3 * barks tiles, modified but restored
+/// \param depth number of own draws to look ahead
+///
+DiscardEv::Ev DiscardEv::value(TileCount &closed, int depth)
+{
+    Key key = keyOf(closed, depth);
+    auto it = mTable.find(key);
+    if (it != mTable.end()) {
+        mHits++;
+        return it->second;
+    }
+
+    int barkCt = static_cast<int>(mBarks.size());
+    int step = closed.step(barkCt);
+
+    Ev res;
+    if (step == 0)
+        res.tenpai = 1.0;
+
+    if (depth > 0 && step <= depth && mRemainSum > 0) {
+        Ev thrown = value(closed, depth - 1);
+        Ev sum;
+
+        for (int ti = 0; ti < 34; ti++) {
+            if (mRemains[ti] == 0)
+                continue;
+
+            T34 t(ti);
+            double p = static_cast<double>(mRemains[ti]) / mRemainSum;
+            Ev child = thrown;
+
+            if (closed.hasEffA(barkCt, t)) {
+                if (step == 0) {
+                    int gain = gainOf(closed, t);
+                    if (gain > 0) {
+                        child.tenpai = 1.0;
+                        child.agari = 1.0;
+                        child.gain = gain;
+                    }
+                } else {
+                    T37 in(ti);
+                    closed.inc(in, 1);
+                    for (int xi = 0; xi < 34; xi++) {
+                        T34 x(xi);
+                        if (closed.ct(x) == 0)
+                            continue;
+                        T37 out(xi);
+                        if (closed.ct(out) == 0)
+                            out = out.toAka5();
+                        closed.inc(out, -1);
+                        if (closed.step(barkCt) == step - 1) {
+                            Ev next = value(closed, depth - 1);
+                            if (better(next, child))
+                                child = next;
+                        }
+                        closed.inc(out, 1);
+                    }
+                    closed.inc(in, -1);
+                }
+            }
+
+            sum.tenpai += p * child.tenpai;
+            sum.agari += p * child.agari;
+            sum.gain += p * child.gain;
+        }
+
+        if (step != 0)
+            res.tenpai = sum.tenpai;
+        res.agari = sum.agari;
+        res.gain = sum.gain;
+    }
+
+    if (mTable.size() >= MAX_ENTRIES)
+        mTable.clear();
+
+    mTable.emplace(key, res);
+    return res;
+}
+
+DiscardEv::Key DiscardEv::keyOf(const TileCount &closed, int depth) const
+{
+    Key key;
+    key.lo = 0;
+    key.hi = 0;
+    for (int ti = 0; ti < 21; ti++)
+        key.lo |= static_cast<uint64_t>(closed.ct(T34(ti))) << (3 * ti);
+    for (int ti = 21; ti < 34; ti++)
+        key.hi |= static_cast<uint64_t>(closed.ct(T34(ti))) << (3 * (ti - 21));
+    for (int s = 0; s < 3; s++)
+        key.hi |= static_cast<uint64_t>(closed.ct(T37(Suit(s), 5).toAka5())) << (39 + s);
+    key.hi |= static_cast<uint64_t>(depth) << 42;
+    return key;
+}
+
+///
+/// \return gain of tsumo by 'pick', 0 if no yaku
+///
+int DiscardEv::gainOf(const TileCount &closed, T34 pick) const
+{
+    Hand full(closed, mBarks);
+    full.draw(T37(pick.id34()));
+    Form form(full, mInfo, mRule, mDrids);
+    return form.hasYaku() ? form.gain() : 0;
+}
+
+///
+/// \brief Compare by expected gain, then agari rate, then tenpai rate
+///
+bool DiscardEv::better(const Ev &a, const Ev &b)
+{
+    if (a.gain != b.gain)
+        return a.gain > b.gain;
+    if (a.agari != b.agari)
+        return a.agari > b.agari;
+    return a.tenpai > b.tenpai;
+}
+
+
+
+} // namespace saki
@@ -0,0 +1,96 @@
+#ifndef SAKI_DISCARD_EV_H
+#define SAKI_DISCARD_EV_H
+
+#include "tableview.h"
+#include "pointinfo.h"
+
+#include <unordered_map>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Multi-draw expected value of discards, by memoized DP
+///
+/// For a candidate discard, compute the rates of reaching tenpai and
+/// agari within the next few own draws, and the expected Form::gain,
+/// assuming every later discard is chosen to maximize the expected gain.
+///
+/// Draws are taken from the viewer's visible-remaining tiles with
+/// replacement. Draws that do not lower the step are thrown at once.
+/// Agari is valued as tsumo without riichi. Depth is the smaller of
+/// 'maxDepth' and the number of own draws left.
+///
+/// Evaluated states are kept in a transposition table for one decision,
+/// shared among its candidates and among draw orders reaching one state.
+/// Values depend on the visible-remaining tiles, which change with every
+/// draw and discard, so the table is dropped whenever the digest of the
+/// context (remaining tiles, barks, doras, winds) changes.
+///
+class DiscardEv
+{
+public:
+    struct Ev
+    {
+        double tenpai = 0.0;
+        double agari = 0.0;
+        double gain = 0.0; ///< expected, counting no-agari as 0
+    };
+
+    explicit DiscardEv(int maxDepth = 3);
+
+    DiscardEv(const DiscardEv &copy) = delete;
+    DiscardEv &operator=(const DiscardEv &assign) = delete;
+
+    Ev evaluate(const TableView &view, const Action &out);
+    void reset();
+
+    size_t tableSize() const;
+    long long hits() const;
+
+private:
+    struct Key
+    {
+        uint64_t lo;
+        uint64_t hi;
+        bool operator==(const Key &that) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
+    void setContext(const TableView &view);
+    Ev value(TileCount &closed, int depth);
+    Key keyOf(const TileCount &closed, int depth) const;
+    int gainOf(const TileCount &closed, T34 pick) const;
+    static bool better(const Ev &a, const Ev &b);
+
+private:
+    static const size_t MAX_ENTRIES = 1 << 20;
+
+    const int mMaxDepth;
+    std::unordered_map<Key, Ev, KeyHash> mTable;
+    long long mHits = 0;
+
+    uint64_t mCtx = 0;
+    std::array<int, 34> mRemains;
+    int mRemainSum = 0;
+    util::Stactor<M37, 4> mBarks;
+    util::Stactor<T37, 5> mDrids;
+    PointInfo mInfo;
+    RuleInfo mRule;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_DISCARD_EV_H
@@ -12,9 +12,9 @@ namespace saki
 
 
 
-Explain4::Explain4(const std::vector<T34> &heads, Wait wait, T34 pair,
+Explain4::Explain4(const std::array<T34, 4> &heads, Wait wait, T34 pair,
                    int o3Ct, int c3Ct, int o4Ct, int c4Ct)
-    : mHeads { heads[0], heads[1], heads[2], heads[3] }
+    : mHeads(heads)
     , mWait(wait)
     , mPair(pair)
     , mO3b(4 - (o3Ct + c3Ct + o4Ct + c4Ct))
@@ -22,56 +22,35 @@ Explain4::Explain4(const std::vector<T34> &heads, Wait wait, T34 pair,
     , mO4b(mC3b + c3Ct)
     , mC4b(mO4b + o4Ct)
 {
-    assert(heads.size() == 4);
     assert(0 <= mO3b && mO3b <= mC3b && mC3b <= mO4b && mO4b <= mC4b && mC4b <= 4);
 }
 
-std::vector<Explain4> Explain4::make(const TileCount &count, const util::Stactor<M37, 4> &barks,
-                                     T34 pick, bool ron)
+Explain4::Explains Explain4::make(const TileCount &count, const util::Stactor<M37, 4> &barks,
+                                 T34 pick, bool ron)
 {
-    std::vector<Explain4> res;
-
-    std::vector<TileCount::Explain4Closed> expCloseds = count.explain4(pick);
-
-    for (TileCount::Explain4Closed &exp : expCloseds) {
-        assert(exp.sequences.size() + exp.triplets.size() + barks.size() == 4);
-
-        auto insertSequence = [&exp](T34 head) {
-            auto &tar = exp.sequences;
-            auto it = std::find_if_not(tar.begin(), tar.end(),
-                                       [head](T34 t) { return t < head; });
-            tar.insert(it, head);
-        };
-
-        std::vector<T34> o3Heads;
-        std::vector<T34> o4Heads;
-        std::vector<T34> c4Heads;
-
-        // include barks
-        for (const M37 &m : barks) {
-            switch (m.type()) {
-            case M37::Type::CHII:
-                insertSequence(m[0]); // keep sequences ordered
-                break;
-            case M37::Type::PON:
-                o3Heads.push_back(m[0]);
-                break;
-            case M37::Type::DAIMINKAN:
-            case M37::Type::KAKAN:
-                o4Heads.push_back(m[0]);
-                break;
-            case M37::Type::ANKAN:
-                c4Heads.push_back(m[0]);
-                break;
-            }
-        }
+    Explains res;
+    makeTo(ron ? &res : nullptr, ron ? nullptr : &res, count.explain4(pick), barks, pick);
+    return res;
+}
 
-        mapWait(res, pick, ron, exp.pair,
-                exp.sequences, o3Heads, exp.triplets, o4Heads, c4Heads);
-    }
+///
+/// \brief Explain for both ron and tsumo, decomposing the hand only once
+///
+void Explain4::make(const TileCount &count, const util::Stactor<M37, 4> &barks,
+                    T34 pick, Explains &ron, Explains &tsumo)
+{
+    makeTo(&ron, &tsumo, count.explain4(pick), barks, pick);
+}
 
-    assert(!res.empty());
-    return res;
+///
+/// \brief Explain for both ron and tsumo, from closed explanations at hand
+/// \param closeds TileCount::explain4() of the closed part with the pick
+///
+void Explain4::make(const TileCount::Explain4Closeds &closeds,
+                    const util::Stactor<M37, 4> &barks,
+                    T34 pick, Explains &ron, Explains &tsumo)
+{
+    makeTo(&ron, &tsumo, closeds, barks, pick);
 }
 
 const std::array<T34, 4> &Explain4::heads() const
@@ -179,58 +158,101 @@ int Explain4::numC4() const
     return c4e() - c4b();
 }
 
-void Explain4::mapWait(std::vector<Explain4> &res, T34 pick, bool ron, T34 pair,
-                       const std::vector<T34> &sHeads,
-                       const std::vector<T34> &o3Heads,
-                       const std::vector<T34> &c3Heads,
-                       const std::vector<T34> &o4Heads,
-                       const std::vector<T34> &c4Heads)
-{
-    if (pick == pair) {
-        std::vector<T34> heads(sHeads); // copy
-        heads.insert(heads.end(), o3Heads.begin(), o3Heads.end());
-        heads.insert(heads.end(), c3Heads.begin(), c3Heads.end());
-        heads.insert(heads.end(), o4Heads.begin(), o4Heads.end());
-        heads.insert(heads.end(), c4Heads.begin(), c4Heads.end());
-        res.emplace_back(heads, Wait::ISORIDE, pair,
-                         o3Heads.size(), c3Heads.size(),
-                         o4Heads.size(), c4Heads.size());
+void Explain4::makeTo(Explains *ron, Explains *tsumo, TileCount::Explain4Closeds closeds,
+                      const util::Stactor<M37, 4> &barks, T34 pick)
+{
+    util::Stactor<T34, 4> o3Heads;
+    util::Stactor<T34, 4> o4Heads;
+    util::Stactor<T34, 4> c4Heads;
+    util::Stactor<T34, 4> chiiHeads;
+
+    // barks are the same for every closed explanation
+    for (const M37 &m : barks) {
+        switch (m.type()) {
+        case M37::Type::CHII:
+            chiiHeads.pushBack(m[0]);
+            break;
+        case M37::Type::PON:
+            o3Heads.pushBack(m[0]);
+            break;
+        case M37::Type::DAIMINKAN:
+        case M37::Type::KAKAN:
+            o4Heads.pushBack(m[0]);
+            break;
+        case M37::Type::ANKAN:
+            c4Heads.pushBack(m[0]);
+            break;
+        }
     }
 
-    for (size_t i = 0; i < c3Heads.size(); i++) {
+    for (TileCount::Explain4Closed &exp : closeds) {
+        assert(exp.sequences.size() + exp.triplets.size() + barks.size() == 4);
+
+        // keep sequences ordered
+        for (T34 head : chiiHeads) {
+            auto &tar = exp.sequences;
+            tar.pushBack(head);
+            for (auto it = tar.end() - 1; it != tar.begin() && head < *(it - 1); --it)
+                std::iter_swap(it, it - 1);
+        }
+
+        if (ron != nullptr)
+            mapWait(*ron, pick, true, exp.pair,
+                    exp.sequences, o3Heads, exp.triplets, o4Heads, c4Heads);
+        if (tsumo != nullptr)
+            mapWait(*tsumo, pick, false, exp.pair,
+                    exp.sequences, o3Heads, exp.triplets, o4Heads, c4Heads);
+    }
+
+    assert(ron == nullptr || !ron->empty());
+    assert(tsumo == nullptr || !tsumo->empty());
+}
+
+void Explain4::mapWait(Explains &res, T34 pick, bool ron, T34 pair,
+                       const util::Stactor<T34, 4> &sHeads,
+                       const util::Stactor<T34, 4> &o3Heads,
+                       const util::Stactor<T34, 4> &c3Heads,
+                       const util::Stactor<T34, 4> &o4Heads,
+                       const util::Stactor<T34, 4> &c4Heads)
+{
+    // [ sequences | open 3 | closed 3 | open 4 | closed 4 ]
+    std::array<T34, 4> heads;
+    auto it = std::copy(sHeads.begin(), sHeads.end(), heads.begin());
+    it = std::copy(o3Heads.begin(), o3Heads.end(), it);
+    auto c3b = it;
+    it = std::copy(c3Heads.begin(), c3Heads.end(), it);
+    it = std::copy(o4Heads.begin(), o4Heads.end(), it);
+    it = std::copy(c4Heads.begin(), c4Heads.end(), it);
+    assert(it == heads.end());
+
+    int o3Ct = static_cast<int>(o3Heads.size());
+    int c3Ct = static_cast<int>(c3Heads.size());
+    int o4Ct = static_cast<int>(o4Heads.size());
+    int c4Ct = static_cast<int>(c4Heads.size());
+
+    if (pick == pair)
+        res.pushBack(Explain4(heads, Wait::ISORIDE, pair, o3Ct, c3Ct, o4Ct, c4Ct));
+
+    for (int i = 0; i < c3Ct; i++) {
         if (c3Heads[i] == pick) {
             /// create bi-bump, mind open/closed by 'ron'
-            std::vector<T34> heads(sHeads); // copy
-            heads.insert(heads.end(), o3Heads.begin(), o3Heads.end());
             if (ron) {
-                heads.push_back(c3Heads[i]); // one more open-3
-                // filter-out one closed-3
-                for (size_t j = 0; j < c3Heads.size(); j++)
-                    if (i != j)
-                        heads.push_back(c3Heads[j]);
+                // rotate the picked one to be the last open-3
+                std::array<T34, 4> bumped(heads);
+                auto b = bumped.begin() + (c3b - heads.begin());
+                std::rotate(b, b + i, b + i + 1);
+                res.pushBack(Explain4(bumped, Wait::BIBUMP, pair,
+                                      o3Ct + 1, c3Ct - 1, o4Ct, c4Ct));
             } else {
-                heads.insert(heads.end(), c3Heads.begin(), c3Heads.end());
+                res.pushBack(Explain4(heads, Wait::BIBUMP, pair, o3Ct, c3Ct, o4Ct, c4Ct));
             }
-            heads.insert(heads.end(), o4Heads.begin(), o4Heads.end());
-            heads.insert(heads.end(), c4Heads.begin(), c4Heads.end());
-            res.emplace_back(heads, Wait::BIBUMP, pair,
-                             o3Heads.size() + ron, c3Heads.size() - ron,
-                             o4Heads.size(), c4Heads.size());
         }
     }
 
-    for (size_t i = 0; i < sHeads.size(); i++) {
-        Wait wait = sHeads[i].waitAsSequence(pick);
-        if (wait != Wait::NONE) {
-            std::vector<T34> heads(sHeads); // copy
-            heads.insert(heads.end(), o3Heads.begin(), o3Heads.end());
-            heads.insert(heads.end(), c3Heads.begin(), c3Heads.end());
-            heads.insert(heads.end(), o4Heads.begin(), o4Heads.end());
-            heads.insert(heads.end(), c4Heads.begin(), c4Heads.end());
-            res.emplace_back(heads, wait, pair,
-                             o3Heads.size(), c3Heads.size(),
-                             o4Heads.size(), c4Heads.size());
-        }
+    for (T34 s : sHeads) {
+        Wait wait = s.waitAsSequence(pick);
+        if (wait != Wait::NONE)
+            res.pushBack(Explain4(heads, wait, pair, o3Ct, c3Ct, o4Ct, c4Ct));
     }
 }
 
@@ -28,11 +28,21 @@ namespace saki
 class Explain4
 {
 public:
-    explicit Explain4(const std::vector<T34> &heads, Wait wait, T34 pair,
+    /// max number of explanations of a hand, by enumerating all hands
+    static const size_t MAX_EXPLAINS = 12;
+    using Explains = util::Stactor<Explain4, MAX_EXPLAINS>;
+
+    Explain4() = default;
+    explicit Explain4(const std::array<T34, 4> &heads, Wait wait, T34 pair,
                       int o3Ct, int c3Ct, int o4Ct, int c4Ct);
 
-    static std::vector<Explain4> make(const TileCount &count, const util::Stactor<M37, 4> &barks,
-                                      T34 pick, bool ron);
+    static Explains make(const TileCount &count, const util::Stactor<M37, 4> &barks,
+                         T34 pick, bool ron);
+    static void make(const TileCount &count, const util::Stactor<M37, 4> &barks,
+                     T34 pick, Explains &ron, Explains &tsumo);
+    static void make(const TileCount::Explain4Closeds &closeds,
+                     const util::Stactor<M37, 4> &barks,
+                     T34 pick, Explains &ron, Explains &tsumo);
 
     const std::array<T34, 4> &heads() const;
     Wait wait() const;
@@ -61,10 +71,14 @@ public:
     int numC4() const;
 
 private:
-    static void mapWait(std::vector<Explain4> &res, T34 pick, bool ron, T34 pair,
-                        const std::vector<T34> &sHeads,
-                        const std::vector<T34> &o3Heads, const std::vector<T34> &c3Heads,
-                        const std::vector<T34> &o4Heads, const std::vector<T34> &c4Heads);
+    static void makeTo(Explains *ron, Explains *tsumo, TileCount::Explain4Closeds closeds,
+                       const util::Stactor<M37, 4> &barks, T34 pick);
+    static void mapWait(Explains &res, T34 pick, bool ron, T34 pair,
+                        const util::Stactor<T34, 4> &sHeads,
+                        const util::Stactor<T34, 4> &o3Heads,
+                        const util::Stactor<T34, 4> &c3Heads,
+                        const util::Stactor<T34, 4> &o4Heads,
+                        const util::Stactor<T34, 4> &c4Heads);
 
 private:
     std::array<T34, 4> mHeads;
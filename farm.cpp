@@ -0,0 +1,231 @@
+#include "farm.h"
+#include "util.h"
+
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+void FarmOp::onActivated(Table &table)
+{
+    mFarm.mPendings.push_back(Farm::Pending { &table, mSelf });
+}
+
+
+
+Farm::Farm(int tableCt, const RuleInfo &rule, const std::array<int, 4> &girlIds)
+{
+    std::array<int, 4> points { 25000, 25000, 25000, 25000 };
+    std::vector<TableObserver*> obs;
+
+    for (int i = 0; i < tableCt; i++) {
+        std::array<TableOperator*, 4> ops;
+        for (int w = 0; w < 4; w++) {
+            mOps.emplace_back(new FarmOp(Who(w), *this));
+            ops[w] = mOps.back().get();
+        }
+
+        mTables.emplace_back(new Table(points, girlIds, ops, obs, rule, Who(0)));
+    }
+}
+
+///
+/// \brief Play all tables to the end
+///
+void Farm::run()
+{
+    for (auto &table : mTables)
+        table->start();
+
+    std::vector<Pending> batch;
+    std::vector<Action> actions;
+    while (!mPendings.empty()) {
+        batch.swap(mPendings);
+        mPendings.clear();
+
+        decide(batch, actions);
+        mStats.batches++;
+        mStats.decisions += batch.size();
+
+        // a table resumes only after its last pending player acts,
+        // so the rest of the batch stays valid meanwhile
+        for (size_t i = 0; i < batch.size(); i++)
+            batch[i].table->action(batch[i].who, actions[i]);
+    }
+}
+
+const Table &Farm::table(int i) const
+{
+    return *mTables[i];
+}
+
+size_t Farm::size() const
+{
+    return mTables.size();
+}
+
+const Farm::Stats &Farm::stats() const
+{
+    return mStats;
+}
+
+void Farm::decide(const std::vector<Pending> &pendings, std::vector<Action> &actions)
+{
+    using AC = ActCode;
+
+    struct Drawn
+    {
+        size_t pending;
+        util::Stactor<Action, 14> outs;
+        util::Stactor<int, 14> rows;
+        TileCount remain;
+    };
+
+    actions.assign(pendings.size(), Action());
+    std::vector<Drawn> drawns;
+
+    // pass 1: one row per discard candidate
+    mBatch.clear();
+    for (size_t i = 0; i < pendings.size(); i++) {
+        TableView view(pendings[i].table->getView(pendings[i].who));
+        const Choices &choices = view.myChoices();
+        if (choices.mode() != Choices::Mode::DRAWN || choices.forwardAny()) {
+            actions[i] = decideOther(view);
+            continue;
+        }
+
+        if (choices.can(AC::TSUMO)) {
+            actions[i] = Action(AC::TSUMO);
+            continue;
+        }
+
+        const Hand &hand = view.myHand();
+        int barkCt = static_cast<int>(hand.barks().size());
+        TileCount full(hand.closed());
+        full.inc(hand.drawn(), 1);
+
+        Drawn d;
+        d.pending = i;
+        d.remain = view.visibleRemain();
+
+        if (choices.can(AC::SPIN_OUT))
+            d.outs.pushBack(Action(AC::SPIN_OUT));
+        if (choices.can(AC::SWAP_OUT))
+            for (const T37 &t : hand.closed().t37s13())
+                d.outs.pushBack(Action(AC::SWAP_OUT, t));
+
+        for (const Action &out : d.outs) {
+            const T37 &t = hand.outFor(out);
+            full.inc(t, -1);
+            d.rows.pushBack(mBatch.add(full, barkCt));
+            full.inc(t, 1);
+        }
+
+        drawns.push_back(d);
+    }
+
+    mBatch.evaluate();
+    mStats.rows += mBatch.size();
+
+    // keep only the minimum-step candidates
+    std::vector<util::Stactor<int, 14>> ties(drawns.size()); // indices into outs
+    std::vector<int> baseSteps(drawns.size());
+    for (size_t di = 0; di < drawns.size(); di++) {
+        const Drawn &d = drawns[di];
+        int minStep = Hand::STEP_INF;
+        for (int row : d.rows)
+            minStep = std::min(minStep, mBatch.step(row));
+        for (size_t c = 0; c < d.rows.size(); c++)
+            if (mBatch.step(d.rows[c]) == minStep)
+                ties[di].pushBack(static_cast<int>(c));
+        baseSteps[di] = minStep;
+    }
+
+    // pass 2: one row per tied candidate and drawable tile, for effA
+    StepBatch drawBatch;
+    std::vector<std::vector<std::pair<int, int>>> drawRows(drawns.size()); // (row, remain)
+    for (size_t di = 0; di < drawns.size(); di++) {
+        if (ties[di].size() <= 1)
+            continue;
+
+        const Drawn &d = drawns[di];
+        for (int c : ties[di]) {
+            TileCount base = mBatch.count(d.rows[c]);
+            int barkCt = static_cast<int>(pendings[d.pending].table->getHand(pendings[d.pending].who)
+                                          .barks().size());
+            int baseRow = drawBatch.add(base, barkCt);
+            for (int ti = 0; ti < 34; ti++) {
+                int remain = d.remain.ct(T34(ti));
+                if (remain > 0 && base.ct(T34(ti)) < 4)
+                    drawRows[di].emplace_back(drawBatch.addDraw(baseRow, T34(ti)), remain);
+            }
+
+            drawRows[di].emplace_back(-1, c); // candidate separator
+        }
+    }
+
+    drawBatch.evaluate();
+    mStats.rows += drawBatch.size();
+
+    for (size_t di = 0; di < drawns.size(); di++) {
+        const Drawn &d = drawns[di];
+        const Pending &p = pendings[d.pending];
+
+        int best = ties[di][0];
+        if (ties[di].size() > 1) {
+            int bestEffA = -1;
+            int effA = 0;
+            for (const auto &pr : drawRows[di]) {
+                if (pr.first >= 0) {
+                    // a draw onto a 13-tile hand is effective if the 14-tile
+                    // hand has a lower step than the 13-tile one
+                    if (drawBatch.step(pr.first) < baseSteps[di])
+                        effA += pr.second;
+                } else {
+                    if (effA > bestEffA) {
+                        bestEffA = effA;
+                        best = pr.second;
+                    }
+                    effA = 0;
+                }
+            }
+        }
+
+        Action act = d.outs[best];
+        const Choices::ModeDrawn &mode = p.table->getChoices(p.who).drawn();
+        if (act.act() == AC::SPIN_OUT && mode.spinRiichi())
+            act = Action(AC::SPIN_RIICHI);
+        else if (act.act() == AC::SWAP_OUT && util::has(mode.swapRiichis(), act.t37()))
+            act = Action(AC::SWAP_RIICHI, act.t37());
+
+        actions[d.pending] = act;
+    }
+}
+
+Action Farm::decideOther(const TableView &view) const
+{
+    using AC = ActCode;
+    const Choices &choices = view.myChoices();
+
+    if (choices.forwardAny())
+        return view.mySweep();
+
+    switch (choices.mode()) {
+    case Choices::Mode::DICE:
+        return Action(AC::DICE);
+    case Choices::Mode::BARK:
+        return Action(choices.can(AC::RON) ? AC::RON : AC::PASS);
+    case Choices::Mode::END:
+        return Action(choices.can(AC::END_TABLE) ? AC::END_TABLE : AC::NEXT_ROUND);
+    default:
+        return view.mySweep();
+    }
+}
+
+
+
+} // namespace saki
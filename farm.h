@@ -0,0 +1,96 @@
+#ifndef SAKI_FARM_H
+#define SAKI_FARM_H
+
+#include "table.h"
+#include "step_batch.h"
+
+#include <memory>
+
+
+
+namespace saki
+{
+
+
+
+class Farm;
+
+///
+/// \brief Operator that only reports activations to its Farm
+///
+/// Returning from onActivated() without acting leaves the table
+/// waiting, the Farm acts for it later in a batch.
+///
+class FarmOp : public TableOperator
+{
+public:
+    explicit FarmOp(Who self, Farm &farm) : TableOperator(self), mFarm(farm) { }
+
+    void onActivated(Table &table) override;
+
+private:
+    Farm &mFarm;
+};
+
+
+
+///
+/// \brief Run many tables with batched greedy decisions
+///
+/// All tables proceed until every one of them is waiting for some
+/// player. Pending decisions are then gathered, the candidate hands of
+/// all drawn-mode decisions go through one StepBatch, and actions are
+/// dispatched back, which runs the tables until they wait again.
+///
+/// The policy is step-then-effA greedy, close to Ai without skills or
+/// defense: tsumo and ron when possible, riichi when the best discard
+/// allows it, never calls.
+///
+class Farm
+{
+public:
+    struct Stats
+    {
+        long long decisions = 0;
+        long long batches = 0;
+        long long rows = 0; ///< hands evaluated through StepBatch
+    };
+
+    explicit Farm(int tableCt, const RuleInfo &rule, const std::array<int, 4> &girlIds);
+
+    Farm(const Farm &copy) = delete;
+    Farm &operator=(const Farm &assign) = delete;
+
+    void run();
+
+    const Table &table(int i) const;
+    size_t size() const;
+    const Stats &stats() const;
+
+private:
+    friend class FarmOp;
+
+    struct Pending
+    {
+        Table *table;
+        Who who;
+    };
+
+    void decide(const std::vector<Pending> &pendings, std::vector<Action> &actions);
+    Action decideOther(const TableView &view) const;
+
+private:
+    std::vector<std::unique_ptr<FarmOp>> mOps;
+    std::vector<std::unique_ptr<Table>> mTables;
+    std::vector<Pending> mPendings;
+    StepBatch mBatch;
+    Stats mStats;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_FARM_H
@@ -3,9 +3,6 @@
 #include "util.h"
 #include "rand.h"
 
-#include <algorithm>
-#include <numeric>
-#include <sstream>
 #include <cassert>
 
 
@@ -53,6 +50,133 @@ std::array<const char *, NUM_YAKUS> YAKU_UNIQUES {
 
 
 
+namespace
+{
+
+///
+/// \brief Yaku set when all bits of 'mask' are sequence heads
+///
+struct SeqRule
+{
+    uint32_t mask;
+    Yaku menzen;
+    Yaku open;
+};
+
+///
+/// \brief Yaku set when all bits of 'mask' are triplet or quad heads
+///
+struct X34Rule
+{
+    uint64_t mask;
+    Yaku yaku;
+};
+
+const uint32_t ITTSUU = 0x49; // 1, 4, 7
+const uint64_t SANSHOKU = 1 | 1 << 9 | 1 << 18;
+const uint64_t FS = uint64_t(0xf) << 27;
+const uint64_t YS = uint64_t(0x7) << 31;
+const uint64_t NUM19S = 0x101 | 0x101 << 9 | 0x101 << 18;
+
+const std::array<SeqRule, 10> SEQ_RULES {{
+    { ITTSUU, Yaku::IKTK, Yaku::IKTK_K },
+    { ITTSUU << 9, Yaku::IKTK, Yaku::IKTK_K },
+    { ITTSUU << 18, Yaku::IKTK, Yaku::IKTK_K },
+    { SANSHOKU, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 1, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 2, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 3, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 4, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 5, Yaku::SSKDJ, Yaku::SSKDJ_K },
+    { SANSHOKU << 6, Yaku::SSKDJ, Yaku::SSKDJ_K },
+}};
+
+const std::array<X34Rule, 12> X34_RULES {{
+    { SANSHOKU, Yaku::SSKDK },
+    { SANSHOKU << 1, Yaku::SSKDK },
+    { SANSHOKU << 2, Yaku::SSKDK },
+    { SANSHOKU << 3, Yaku::SSKDK },
+    { SANSHOKU << 4, Yaku::SSKDK },
+    { SANSHOKU << 5, Yaku::SSKDK },
+    { SANSHOKU << 6, Yaku::SSKDK },
+    { SANSHOKU << 7, Yaku::SSKDK },
+    { SANSHOKU << 8, Yaku::SSKDK },
+    { uint64_t(1) << 31, Yaku::YKH1Y },
+    { uint64_t(1) << 32, Yaku::YKH2Y },
+    { uint64_t(1) << 33, Yaku::YKH3Y },
+}};
+
+int ctBits(uint64_t mask)
+{
+    return static_cast<int>(std::bitset<64>(mask).count());
+}
+
+static_assert(NUM_YAKUS <= 64, "Form::Digest::yakus is 64 bits");
+
+///
+/// \brief Text output into a fixed buffer, truncating like snprintf
+///
+class Pen
+{
+public:
+    Pen(char *buf, size_t size)
+        : mBuf(buf)
+        , mSize(size)
+    {
+    }
+
+    Pen &operator<<(const char *str)
+    {
+        while (*str != '\0')
+            put(*str++);
+        return *this;
+    }
+
+    Pen &operator<<(int i)
+    {
+        char digits[12];
+        int ct = 0;
+        unsigned u = i < 0 ? 0u - static_cast<unsigned>(i) : static_cast<unsigned>(i);
+        do {
+            digits[ct++] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u > 0);
+
+        if (i < 0)
+            put('-');
+        while (ct > 0)
+            put(digits[--ct]);
+        return *this;
+    }
+
+    ///
+    /// \brief Terminate the text and return its untruncated length
+    ///
+    size_t end()
+    {
+        if (mSize > 0)
+            mBuf[mLen < mSize ? mLen : mSize - 1] = '\0';
+        return mLen;
+    }
+
+private:
+    void put(char c)
+    {
+        if (mLen + 1 < mSize)
+            mBuf[mLen] = c;
+        mLen++;
+    }
+
+private:
+    char *mBuf;
+    size_t mSize;
+    size_t mLen = 0;
+};
+
+} // namespace
+
+
+
 Form::Form(const Hand &ready, const T37 &pick, const PointInfo &info, const RuleInfo &rule,
            const util::Stactor<T37, 5> &drids, const util::Stactor<T37, 5> &urids)
     : mDealerWin(info.selfWind == 1)
@@ -93,6 +217,91 @@ Form::Form(const Hand &full, const PointInfo &info, const RuleInfo &rule,
     }
 }
 
+Form::Form(const Digest &digest)
+    : mType(static_cast<Type>(digest.type))
+    , mYakus(digest.yakus)
+    , mYakuman(digest.yakuman)
+    , mDealerWin(digest.dealerWin)
+    , mRon(digest.ron)
+    , mFu(digest.fu)
+    , mHan(digest.han)
+    , mExtraRound(digest.extraRound)
+    , mBase(digest.base)
+    , mDora(digest.dora)
+    , mUradora(digest.uradora)
+    , mAkadora(digest.akadora)
+{
+}
+
+///
+/// \brief Uninitialized form, to be completed by the init functions
+///
+Form::Form(const PointInfo &info, bool ron)
+    : mDealerWin(info.selfWind == 1)
+    , mRon(ron)
+    , mExtraRound(info.extraRound)
+{
+}
+
+///
+/// \brief Form of a ready hand on each wait, for both ron and tsumo
+///
+/// Same as constructing Form(ready, pick, ...) and Form(full, ...) for
+/// every tile of the wait mask. The step checks are done once on the
+/// 13-tile hand, and so is its 4-meld decomposition. Each pick only
+/// completes the splits that wait on it, and the result is shared by
+/// ron and tsumo.
+///
+std::vector<Form::WaitScore> Form::scoreWaits(const Hand &ready, const PointInfo &info,
+                                              const RuleInfo &rule,
+                                              const util::Stactor<T37, 5> &drids,
+                                              const util::Stactor<T37, 5> &urids)
+{
+    assert(!ready.hasDrawn());
+
+    std::vector<WaitScore> res;
+    uint64_t mask = ready.waitMask();
+
+    // kokushi cannot wait in any other form at the same time
+    bool orphans = ready.step13() == 0;
+    TileCount::Wait4Splits splits;
+    if (!orphans)
+        splits = ready.closed().splitWait4(static_cast<int>(ready.barks().size()));
+
+    for (int ti = 0; ti < 34; ti++) {
+        if (!((mask >> ti) & 1))
+            continue;
+
+        T37 pick(ti);
+        WaitScore ws { T34(ti), Form(info, true), Form(info, false) };
+        ws.ron.initDora(drids, urids, ready, pick);
+        ws.tsumo.initDora(drids, urids, ready, pick);
+
+        TileCount::Explain4Closeds closeds;
+        if (!orphans)
+            closeds = TileCount::explain4(pick, splits);
+
+        if (orphans) {
+            ws.ron.init13(info, ready.closed(), pick);
+            ws.tsumo.init13(info, ready.closed(), pick);
+        } else if (!closeds.empty()) {
+            Explain4::Explains ronExps;
+            Explain4::Explains tsumoExps;
+            Explain4::make(closeds, ready.barks(), pick, ronExps, tsumoExps);
+            ws.ron.init4(info, rule, ready, pick, ronExps);
+            ws.tsumo.init4(info, rule, ready, pick, tsumoExps);
+        } else {
+            assert(ready.peekPickStep7(pick) == -1);
+            ws.ron.init7(info, rule, ready.closed());
+            ws.tsumo.init7(info, rule, ready.closed());
+        }
+
+        res.push_back(ws);
+    }
+
+    return res;
+}
+
 bool Form::isPrototypalYakuman() const
 {
     return mYakuman;
@@ -205,126 +414,150 @@ int Form::gain() const
 
 std::string Form::spell() const
 {
-    std::ostringstream oss;
+    char buf[SPELL_BUF];
+    size_t len = spell(buf, SPELL_BUF);
+    assert(len < SPELL_BUF);
+    return std::string(buf, len);
+}
+
+std::string Form::charge() const
+{
+    char buf[CHARGE_BUF];
+    size_t len = charge(buf, CHARGE_BUF);
+    assert(len < CHARGE_BUF);
+    return std::string(buf, len);
+}
+
+///
+/// \brief Write spell() into 'buf' without allocating
+/// \return Length of the whole text, truncated if not less than 'size'
+///
+size_t Form::spell(char *buf, size_t size) const
+{
+    Pen pen(buf, size);
 
     if (mYakuman) {
         // forgot why I even append spaces at the end
         // maybe it does or does not matter for the gui layout
         for (int i = Yaku::KKSMS; i < NUM_YAKUS; i++)
             if (mYakus[i])
-                oss << YAKU_STRS[i] << "  ";
+                pen << YAKU_STRS[i] << "  ";
     } else {
         Yakus copy = mYakus;
         if (copy[Yaku::RSKH]) {
             copy.reset(Yaku::RSKH);
-            oss << "Rns";
+            pen << "Rns";
             if (copy.count() > 1)
-                oss << "Kah";
+                pen << "Kah";
         }
 
         if (copy[Yaku::HTRY_T]) {
             copy.reset(Yaku::HTRY_T);
-            oss << "Hai";
+            pen << "Hai";
             if (copy.count() > 1)
-                oss << "Rye";
+                pen << "Rye";
         }
 
         if (copy[Yaku::DBRRC]) {
             copy.reset(Yaku::DBRRC);
-            oss << "Wri";
+            pen << "Wri";
         }
 
         if (copy[Yaku::RC] && copy[Yaku::TYC] && copy[Yaku::PF]) {
             copy.reset(Yaku::RC);
             copy.reset(Yaku::TYC);
             copy.reset(Yaku::PF);
-            oss << "Mtp";
+            pen << "Mtp";
         }
 
         if (copy[Yaku::RC] && copy[Yaku::PF]) {
             copy.reset(Yaku::RC);
             copy.reset(Yaku::PF);
-            oss << "Mpn";
+            pen << "Mpn";
         }
 
         if (copy[Yaku::RC] && copy[Yaku::TYC]) {
             copy.reset(Yaku::RC);
             copy.reset(Yaku::TYC);
-            oss << "Mtn";
+            pen << "Mtn";
         }
 
         if (copy[Yaku::TYC] && copy[Yaku::PF]) {
             copy.reset(Yaku::TYC);
             copy.reset(Yaku::PF);
-            oss << "Tpn";
+            pen << "Tpn";
         }
 
         if (copy[Yaku::RC] && copy[Yaku::MZCTMH]) {
             copy.reset(Yaku::RC);
             copy.reset(Yaku::MZCTMH);
-            oss << "Rtm";
+            pen << "Rtm";
         }
 
         if (copy[Yaku::PF] && copy[Yaku::MZCTMH]) {
             copy.reset(Yaku::PF);
             copy.reset(Yaku::MZCTMH);
-            oss << "Ptm";
+            pen << "Ptm";
         }
 
         if (copy[Yaku::TYC] && copy[Yaku::MZCTMH]) {
             copy.reset(Yaku::TYC);
             copy.reset(Yaku::MZCTMH);
-            oss << "Ttm";
+            pen << "Ttm";
         }
 
         if (copy[Yaku::JKZ1F] && copy[Yaku::BKZ1F]) {
             copy.reset(Yaku::JKZ1F);
             copy.reset(Yaku::BKZ1F);
-            oss << "W1f";
+            pen << "W1f";
         }
 
         if (copy[Yaku::JKZ2F] && copy[Yaku::BKZ2F]) {
             copy.reset(Yaku::JKZ2F);
             copy.reset(Yaku::BKZ2F);
-            oss << "W2f";
+            pen << "W2f";
         }
 
         if (copy[Yaku::JKZ3F] && copy[Yaku::BKZ3F]) {
             copy.reset(Yaku::JKZ3F);
             copy.reset(Yaku::BKZ3F);
-            oss << "W3f";
+            pen << "W3f";
         }
 
         if (copy[Yaku::JKZ4F] && copy[Yaku::BKZ4F]) {
             copy.reset(Yaku::JKZ4F);
             copy.reset(Yaku::BKZ4F);
-            oss << "W4f";
+            pen << "W4f";
         }
 
         for (int i = 0; i < Yaku::KKSMS; i++)
             if (copy[i])
-                oss << YAKU_STRS[i];
+                pen << YAKU_STRS[i];
 
         int d = mDora;
         int u = mUradora;
         int a = mAkadora;
 
         if (d == 0 && u > 0 && a == 0)
-            oss << "Ura" << u;
+            pen << "Ura" << u;
         else if (d == 0 && u == 0 && a > 0)
-            oss << "Aka" << a;
+            pen << "Aka" << a;
         else if (d + u + a > 0)
-            oss << "Dra" << (d + u + a);
+            pen << "Dra" << (d + u + a);
         else if (mYakus.count() == 1)
-            oss << "Nmi";
+            pen << "Nmi";
     }
 
-    return oss.str();
+    return pen.end();
 }
 
-std::string Form::charge() const
+///
+/// \brief Write charge() into 'buf' without allocating
+/// \return Length of the whole text, truncated if not less than 'size'
+///
+size_t Form::charge(char *buf, size_t size) const
 {
-    std::ostringstream oss;
+    Pen pen(buf, size);
 
     const std::array<const char *, 6> manganName = {
         "", "Mg", "Hnm", "Bm", "Sbm", "Kzeykm"
@@ -332,24 +565,42 @@ std::string Form::charge() const
 
     if (mYakuman) {
         if (mExtraRound != 0)
-            oss << mExtraRound << "Hb   ";
-        oss << "Ykm ";
+            pen << mExtraRound << "Hb   ";
+        pen << "Ykm ";
     } else {
-        oss << mFu << "Fu ";
-        oss << mHan << "Han";
+        pen << mFu << "Fu ";
+        pen << mHan << "Han";
         if (mExtraRound != 0)
-            oss << " " << mExtraRound << "Hb";
-        oss << "   " << manganName[manganType()];
+            pen << " " << mExtraRound << "Hb";
+        pen << "   " << manganName[manganType()];
     }
 
     if (mRon)
-        oss << gain();
+        pen << gain();
     else if (mDealerWin)
-        oss << loss(false) << "All";
+        pen << loss(false) << "All";
     else
-        oss << loss(false) << "Dot" << loss(true);
+        pen << loss(false) << "Dot" << loss(true);
+
+    return pen.end();
+}
 
-    return oss.str();
+Form::Digest Form::digest() const
+{
+    Digest res;
+    res.yakus = mYakus.to_ullong();
+    res.base = mBase;
+    res.fu = static_cast<int16_t>(mFu);
+    res.extraRound = static_cast<int16_t>(mExtraRound);
+    res.han = static_cast<int8_t>(mHan);
+    res.dora = static_cast<int8_t>(mDora);
+    res.uradora = static_cast<int8_t>(mUradora);
+    res.akadora = static_cast<int8_t>(mAkadora);
+    res.type = static_cast<uint8_t>(mType);
+    res.yakuman = mYakuman;
+    res.dealerWin = mDealerWin;
+    res.ron = mRon;
+    return res;
 }
 
 void Form::init13(const PointInfo &info, const TileCount &ready, T34 last)
@@ -368,13 +619,22 @@ void Form::init13(const PointInfo &info, const TileCount &ready, T34 last)
 
 void Form::init4(const PointInfo &info, const RuleInfo &rule,
                  const Hand &hand, const T37 &last)
+{
+    init4(info, rule, hand, last, Explain4::make(hand.closed(), hand.barks(), last, mRon));
+}
+
+///
+/// \param hand The hand excluding 'last', drawn or not does not matter
+/// \param exps Explanations of 'hand' + 'last', matching mRon
+///
+void Form::init4(const PointInfo &info, const RuleInfo &rule,
+                 const Hand &hand, const T37 &last, const Explain4::Explains &exps)
 {
     mType = Type::F4;
-    std::vector<Explain4> exps = Explain4::make(hand.closed(), hand.barks(),
-                                                last, mRon);
 
     for (const Explain4 &exp : exps) {
-        Yakus ykms = calcYakuman4(info, exp, hand.closed(), last);
+        Feature4 f(exp);
+        Yakus ykms = calcYakuman4(info, exp, f, hand.closed(), last);
         if (ykms.any()) {
             mYakuman = true;
             mYakus = ykms;
@@ -382,7 +642,7 @@ void Form::init4(const PointInfo &info, const RuleInfo &rule,
             break; // assume (?) yakumans are equivalently explained
         }
 
-        Yakus ys = calcYaku4(info, rule, hand.isMenzen(), exp);
+        Yakus ys = calcYaku4(info, rule, hand.isMenzen(), f);
         int tempFu = calcFu(info, exp, hand.isMenzen());
         int tempHan = calcHan(ys);
         int tempBase = calcBase(tempFu, tempHan);
@@ -484,6 +744,45 @@ void Form::initDora(const util::Stactor<T37, 5> &drids, const util::Stactor<T37,
     mAkadora = ready.ctAka5() + last.isAka5();
 }
 
+Form::Feature4::Feature4(const Explain4 &exp)
+    : numS(exp.numS())
+    , numX34(exp.numX34())
+    , numAnkous(exp.numC3() + exp.numC4())
+    , numKans(exp.numO4() + exp.numC4())
+    , wait(exp.wait())
+    , pair(exp.pair())
+{
+    auto addSuit = [this](T34 t) {
+        if (t.isZ())
+            hasZ = true;
+        else
+            numSuits |= 1 << static_cast<int>(t.suit());
+    };
+
+    addSuit(pair);
+    yaos += pair.isYao();
+
+    for (auto it = exp.sb(); it != exp.se(); ++it) {
+        seqs |= uint32_t(1) << it->id34();
+        addSuit(*it);
+        yaos += it->val() == 1 || it->val() == 7;
+        cups += it + 1 != exp.se() && *it == *(it + 1);
+    }
+
+    // sequences are sorted, so ryanpeikou is 0 == 1 and 2 == 3
+    const auto &h = exp.heads();
+    if (numS == 4 && cups >= 2 && h[0] == h[1] && h[2] == h[3])
+        cups = 2;
+    else
+        cups = cups > 0;
+
+    for (auto it = exp.x34b(); it != exp.x34e(); ++it) {
+        x34s |= uint64_t(1) << it->id34();
+        addSuit(*it);
+        yaos += it->isYao();
+    }
+}
+
 void Form::checkPick(Yakus &ys, const PointInfo &info) const
 {
     if (info.duringKan)
@@ -507,200 +806,97 @@ void Form::checkTsumo(Form::Yakus &ys, bool menzen) const
         ys.set(Yaku::MZCTMH);
 }
 
-void Form::checkAge4(Form::Yakus &ys, const Explain4 &exp, bool menzen) const
+void Form::checkAge4(Form::Yakus &ys, const Feature4 &f, bool menzen) const
 {
-    // init by pair's age
-    bool all = exp.pair().isYao();
-    bool none = !exp.pair().isYao();
-    bool hasZ = exp.pair().isZ();
-
-    for (auto it = exp.sb(); it != exp.se(); ++it) {
-        bool yao = it->val() == 1 || it->val() == 7;
-        all = all && yao;
-        none = none && !yao;
-        if (!all && !none) // mixture, no more hope
-            return;
-    }
-
-    for (auto it = exp.x34b(); it != exp.x34e(); ++it) {
-        bool yao = it->isYao();
-        all = all && yao;
-        none = none && !yao;
-        if (!all && !none) // mixture, no more hope
-            return;
-        hasZ = hasZ || it->isZ();
-    }
-
-    if (none) {
+    if (f.yaos == 0) {
         ys.set(Yaku::TYC);
-    } else if (all) {
-        if (exp.numX34() == 4) {
-            assert(hasZ); // yakuman already checked
+    } else if (f.yaos == 5) {
+        if (f.numX34 == 4) {
+            assert(f.hasZ); // yakuman already checked
             ys.set(Yaku::HRT); // implies toitoi but does not care
         } else if (menzen) {
-            ys.set(hasZ ? Yaku::HCTYC : Yaku::JCTYC);
+            ys.set(f.hasZ ? Yaku::HCTYC : Yaku::JCTYC);
         } else {
-            ys.set(hasZ ? Yaku::HCTYC_K : Yaku::JCTYC_K);
+            ys.set(f.hasZ ? Yaku::HCTYC_K : Yaku::JCTYC_K);
         }
     }
 }
 
 void Form::checkPinfu4(Form::Yakus &ys, const PointInfo &info,
-                       const Explain4 &exp, bool menzen) const
+                       const Feature4 &f, bool menzen) const
 {
-    if (menzen && exp.numS() == 4 && exp.wait() == Wait::BIFACE
-            && !exp.pair().isYakuhai(info.selfWind, info.roundWind)) {
+    if (menzen && f.numS == 4 && f.wait == Wait::BIFACE
+            && !f.pair.isYakuhai(info.selfWind, info.roundWind)) {
         ys.set(Yaku::PF);
     }
 }
 
-void Form::checkDye4(Form::Yakus &ys, const Explain4 &exp, bool menzen) const
+void Form::checkDye4(Form::Yakus &ys, const Feature4 &f, bool menzen) const
 {
-    bool hasZ = exp.pair().isZ();
-    std::array<bool, 3> hasNum { false, false, false };
-    if (exp.pair().isNum())
-        hasNum[static_cast<int>(exp.pair().suit())] = true;
-
-    for (T34 t : exp.heads()) {
-        if (t.isZ())
-            hasZ = true;
-        else
-            hasNum[static_cast<int>(t.suit())] = true;
-    }
-
-    if (std::accumulate(hasNum.begin(), hasNum.end(), 0) == 1) {
+    if (ctBits(f.numSuits) == 1) {
         if (menzen)
-            ys.set(hasZ ? Yaku::HIS : Yaku::CIS);
+            ys.set(f.hasZ ? Yaku::HIS : Yaku::CIS);
         else
-            ys.set(hasZ ? Yaku::HIS_K : Yaku::CIS_K);
+            ys.set(f.hasZ ? Yaku::HIS_K : Yaku::CIS_K);
     }
 }
 
-void Form::checkCup4(Form::Yakus &ys, const Explain4 &exp, bool menzen) const
+void Form::checkCup4(Form::Yakus &ys, const Feature4 &f, bool menzen) const
 {
     if (!menzen)
         return;
-    if (exp.numS() == 4
-            && exp.heads().at(0) == exp.heads().at(1)
-            && exp.heads().at(2) == exp.heads().at(3)) {
+    if (f.cups == 2)
         ys.set(Yaku::RPK);
-    } else if (exp.numS() >= 2) {
-        for (auto it = exp.sb(); it + 1 != exp.se(); ++it) {
-            if (*it == *(it + 1)) {
-                ys.set(Yaku::IPK);
-                break;
-            }
-        }
-    }
+    else if (f.cups == 1)
+        ys.set(Yaku::IPK);
 }
 
-void Form::checkYakuhai4(Form::Yakus &ys, const PointInfo &info, const Explain4 &exp) const
+void Form::checkYakuhai4(Form::Yakus &ys, const PointInfo &info, const Feature4 &f) const
 {
-    for (auto it = exp.x34b(); it != exp.x34e(); ++it) {
-        if (it->suit() == Suit::Y) {
-            const std::array<Yaku, 3> Y { Yaku::YKH1Y, Yaku::YKH2Y, Yaku::YKH3Y };
-            ys.set(Y.at(it->val() - 1));
-        } else {
-            if (it->suit() == Suit::F && it->val() == info.selfWind) {
-                const std::array<Yaku, 4> J {
-                    Yaku::JKZ1F, Yaku::JKZ2F, Yaku::JKZ3F, Yaku::JKZ4F,
-                };
-                ys.set(J.at(it->val() - 1));
-            }
-
-            if (it->suit() == Suit::F && it->val() == info.roundWind) {
-                const std::array<Yaku, 4> B {
-                    Yaku::BKZ1F, Yaku::BKZ2F, Yaku::BKZ3F, Yaku::BKZ4F,
-                };
-                ys.set(B.at(it->val() - 1));
-            }
-        }
-    }
-}
+    // dragons are in X34_RULES
+    const std::array<Yaku, 4> J { Yaku::JKZ1F, Yaku::JKZ2F, Yaku::JKZ3F, Yaku::JKZ4F };
+    const std::array<Yaku, 4> B { Yaku::BKZ1F, Yaku::BKZ2F, Yaku::BKZ3F, Yaku::BKZ4F };
 
-void Form::checkIttsuu4(Form::Yakus &ys, const Explain4 &exp, bool menzen) const
-{
-    auto check = [](T34 l, T34 m, T34 r) -> bool {
-        return l.suit() == r.suit() && l.val() == 1 && m.val() == 4 && r.val() == 7;
-    };
+    if (1 <= info.selfWind && info.selfWind <= 4
+            && (f.x34s >> T34(Suit::F, info.selfWind).id34()) & 1)
+        ys.set(J[info.selfWind - 1]);
 
-    const auto &h = exp.heads(); // save typing
-
-    if (exp.numS() == 3) {
-        if (check(h[0], h[1], h[2]))
-            ys.set(menzen ? Yaku::IKTK : Yaku::IKTK_K);
-    } else if (exp.numS() == 4) {
-        if (check(h[0], h[1], h[2])
-                || check(h[0], h[1], h[3])
-                || check(h[0], h[2], h[3])
-                || check(h[1], h[2], h[3]))
-            ys.set(menzen ? Yaku::IKTK : Yaku::IKTK_K);
-    }
+    if (1 <= info.roundWind && info.roundWind <= 4
+            && (f.x34s >> T34(Suit::F, info.roundWind).id34()) & 1)
+        ys.set(B[info.roundWind - 1]);
 }
 
-void Form::checkSanshoku4(Form::Yakus &ys, const Explain4 &exp, bool menzen) const
+void Form::checkSeqs4(Form::Yakus &ys, const Feature4 &f, bool menzen) const
 {
-    auto check = [](T34 l, T34 m, T34 r) -> bool {
-        // inequality is transitive when it is sorted
-        return l.suit() != m.suit() && m.suit() != r.suit()
-                && l.val() == m.val() && m.val() == r.val();
-    };
+    if (f.numS < 3)
+        return;
 
-    const auto &h = exp.heads(); // save typing
-
-    if (exp.numS() == 3) {
-        if (check(h[0], h[1], h[2]))
-            ys.set(menzen ? Yaku::SSKDJ : Yaku::SSKDJ_K);
-    } else if (exp.numS() == 4) {
-        if (check(h[0], h[1], h[2])
-                || check(h[0], h[1], h[3])
-                || check(h[0], h[2], h[3])
-                || check(h[1], h[2], h[3]))
-            ys.set(menzen ? Yaku::SSKDJ : Yaku::SSKDJ_K);
-    }
+    for (const SeqRule &r : SEQ_RULES)
+        if ((f.seqs & r.mask) == r.mask)
+            ys.set(menzen ? r.menzen : r.open);
 }
 
-void Form::checkX34s4(Form::Yakus &ys, const Explain4 &exp) const
+void Form::checkX34s4(Form::Yakus &ys, const Feature4 &f) const
 {
-    if (exp.numX34() == 4)
+    if (f.numX34 == 4)
         ys.set(Yaku::TTH);
-    if (exp.numC3() + exp.numC4() == 3)
+    if (f.numAnkous == 3)
         ys.set(Yaku::S3AK);
-    if (exp.numO4() + exp.numC4() == 3)
+    if (f.numKans == 3)
         ys.set(Yaku::S3KT);
-}
-
-void Form::checkSanshokudoukou4(Form::Yakus &ys, const Explain4 &exp) const
-{
-    auto check = [](T34 l, T34 m, T34 r) -> bool {
-        // suits must different (except vertical overflow bug)
-        return l.isNum() && m.isNum() && r.isNum()
-                && l.val() == m.val() && m.val() == r.val();
-    };
 
-    const auto &h = exp.heads(); // save typing
-
-    if (exp.numX34() == 3) {
-        if (check(h[1], h[2], h[3])) // X34 lays from the back
-            ys.set(Yaku::SSKDK);
-    } else if (exp.numX34() == 4) {
-        if (check(h[0], h[1], h[2])
-                || check(h[0], h[1], h[3])
-                || check(h[0], h[2], h[3])
-                || check(h[1], h[2], h[3]))
-            ys.set(Yaku::SSKDK);
-    }
+    for (const X34Rule &r : X34_RULES)
+        if ((f.x34s & r.mask) == r.mask)
+            ys.set(r.yaku);
 }
 
-void Form::checkShousangen(Form::Yakus &ys, const Explain4 &exp) const
+void Form::checkShousangen(Form::Yakus &ys, const Feature4 &f) const
 {
-    int ct = std::count_if(exp.x34b(), exp.x34e(),
-                           [](T34 t) { return t.suit() == Suit::Y; });
-    if (exp.pair().suit() == Suit::Y && ct == 2)
+    if (f.pair.suit() == Suit::Y && ctBits(f.x34s & YS) == 2)
         ys.set(Yaku::SSG);
 }
 
-Form::Yakus Form::calcYakuman4(const PointInfo &info, const Explain4 &exp,
+Form::Yakus Form::calcYakuman4(const PointInfo &info, const Explain4 &exp, const Feature4 &f,
                                const TileCount &closed, const T37 &last) const
 {
     Yakus res;
@@ -712,31 +908,26 @@ Form::Yakus Form::calcYakuman4(const PointInfo &info, const Explain4 &exp,
         anyWait = true;
     }
 
-    const std::array<T34, 4> &heads = exp.heads();
-    if (util::all(heads, [](T34 h) { return h.isZ(); }) && exp.pair().isZ())
+    if (f.numSuits == 0)
         res.set(Yaku::TIS);
 
     // Suuankou
-    if (exp.numC3() + exp.numC4() == 4)
-        res.set(exp.wait() == Wait::ISORIDE || anyWait ? Yaku::S4AK_A : Yaku::S4AK);
+    if (f.numAnkous == 4)
+        res.set(f.wait == Wait::ISORIDE || anyWait ? Yaku::S4AK_A : Yaku::S4AK);
 
     // Daisangen
-    int yCt = std::count_if(exp.x34b(), exp.x34e(),
-                            [](T34 t) { return t.suit() == Suit::Y; });
-    if (yCt == 3)
+    if ((f.x34s & YS) == YS)
         res.set(Yaku::DSG);
 
     // Shousuushii Daisuushii
-    int fCt = std::count_if(exp.x34b(), exp.x34e(),
-                            [](T34 t) { return t.suit() == Suit::F; });
+    int fCt = ctBits(f.x34s & FS);
     if (fCt == 4)
         res.set(Yaku::DSS);
-    else if (fCt == 3 && exp.pair().suit() == Suit::F)
+    else if (fCt == 3 && f.pair.suit() == Suit::F)
         res.set(Yaku::SSS);
 
     // Chinroutou
-    if (exp.numX34() == 4 && util::all(heads, [](T34 t) { return t.isNum19(); })
-            && exp.pair().isNum19())
+    if (f.numX34 == 4 && (f.x34s & ~NUM19S) == 0 && f.pair.isNum19())
         res.set(Yaku::CRT);
 
     // Ryuuiisou
@@ -749,15 +940,15 @@ Form::Yakus Form::calcYakuman4(const PointInfo &info, const Explain4 &exp,
         return val == 2 || val == 3 || val == 4 || val == 6 || val == 8;
     };
     auto greenSeq = [](T34 t) { return t == T34(2, Suit::S); };
-    if (green(exp.pair())
+    if (green(f.pair)
             && util::all(exp.sb(), exp.se(), greenSeq)
             && util::all(exp.x34b(), exp.x34e(), green))
         res.set(Yaku::RIS);
 
     // Chuurenpoutou
-    if (exp.pair().isNum()) {
+    if (f.pair.isNum() && f.numSuits == 1u << static_cast<int>(f.pair.suit()) && !f.hasZ) {
         int_fast32_t totalLook = 0, waitLook = 0;
-        Suit suit = exp.pair().suit();
+        Suit suit = f.pair.suit();
 
         for (int val = 1; val <= 9; val++) {
             T34 t(suit, val);
@@ -776,30 +967,28 @@ Form::Yakus Form::calcYakuman4(const PointInfo &info, const Explain4 &exp,
 
 
     // Suukantsu
-    if (exp.numO4() + exp.numC4() == 4)
+    if (f.numKans == 4)
         res.set(Yaku::S4KT);
 
     return res;
 }
 
 Form::Yakus Form::calcYaku4(const PointInfo &info, const RuleInfo &rule,
-                            bool menzen, const Explain4 &exp) const
+                            bool menzen, const Feature4 &f) const
 {
     Yakus res;
 
     checkPick(res, info);
     checkRiichi(res, info, rule);
     checkTsumo(res, menzen);
-    checkAge4(res, exp, menzen);
-    checkPinfu4(res, info, exp, menzen);
-    checkDye4(res, exp, menzen);
-    checkCup4(res, exp, menzen);
-    checkYakuhai4(res, info, exp);
-    checkIttsuu4(res, exp, menzen);
-    checkSanshoku4(res, exp, menzen);
-    checkX34s4(res, exp);
-    checkSanshokudoukou4(res, exp);
-    checkShousangen(res, exp);
+    checkAge4(res, f, menzen);
+    checkPinfu4(res, info, f, menzen);
+    checkDye4(res, f, menzen);
+    checkCup4(res, f, menzen);
+    checkYakuhai4(res, info, f);
+    checkSeqs4(res, f, menzen);
+    checkX34s4(res, f);
+    checkShousangen(res, f);
 
     return res;
 }
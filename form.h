@@ -47,6 +47,12 @@ public:
 
     using Yakus = std::bitset<Yaku::NUM_YAKUS>;
 
+    struct WaitScore;
+    struct Digest;
+
+    static const size_t SPELL_BUF = 128; ///< enough for any spell() and its '\0'
+    static const size_t CHARGE_BUF = 64; ///< enough for any charge() and its '\0'
+
     Form(const Hand &ready, const T37 &pick, const PointInfo &info, const RuleInfo &rule,
          const util::Stactor<T37, 5> &drids = util::Stactor<T37, 5>(),
          const util::Stactor<T37, 5> &urids = util::Stactor<T37, 5>());
@@ -54,8 +60,17 @@ public:
          const util::Stactor<T37, 5> &drids = util::Stactor<T37, 5>(),
          const util::Stactor<T37, 5> &urids = util::Stactor<T37, 5>());
 
+    explicit Form(const Digest &digest);
+
     ~Form() = default;
 
+    static std::vector<WaitScore> scoreWaits(const Hand &ready, const PointInfo &info,
+                                             const RuleInfo &rule,
+                                             const util::Stactor<T37, 5> &drids
+                                                 = util::Stactor<T37, 5>(),
+                                             const util::Stactor<T37, 5> &urids
+                                                 = util::Stactor<T37, 5>());
+
     bool isPrototypalYakuman() const;
     int fu() const;
     int han() const;
@@ -74,10 +89,38 @@ public:
     int gain() const;
     std::string spell() const;
     std::string charge() const;
+    size_t spell(char *buf, size_t size) const;
+    size_t charge(char *buf, size_t size) const;
+    Digest digest() const;
 
 private:
+    ///
+    /// \brief Features of an Explain4, extracted once for all yaku checks
+    ///
+    struct Feature4
+    {
+        explicit Feature4(const Explain4 &exp);
+
+        uint32_t seqs = 0; ///< bit id34 set for each sequence head
+        uint64_t x34s = 0; ///< bit id34 set for each triplet or quad
+        unsigned numSuits = 0; ///< bit i set if Suit(i) appears, m/p/s only
+        bool hasZ = false;
+        int yaos = 0; ///< pair and melds having a terminal or an honor
+        int cups = 0; ///< 1 for iipeikou, 2 for ryanpeikou
+        int numS;
+        int numX34;
+        int numAnkous; ///< closed triplets and quads
+        int numKans;
+        Wait wait;
+        T34 pair;
+    };
+
+    explicit Form(const PointInfo &info, bool ron);
+
     void init13(const PointInfo &info, const TileCount &ready, T34 last);
     void init4(const PointInfo &info, const RuleInfo &rule, const Hand &hand, const T37 &last);
+    void init4(const PointInfo &info, const RuleInfo &rule, const Hand &hand, const T37 &last,
+               const Explain4::Explains &exps);
     void init7(const PointInfo &info, const RuleInfo &rule, const TileCount &ready);
 
     void init7Dye(const TileCount &ready);
@@ -90,21 +133,19 @@ private:
     void checkPick(Yakus &ys, const PointInfo &info) const;
     void checkRiichi(Yakus &ys, const PointInfo &info, const RuleInfo &rule) const;
     void checkTsumo(Yakus &ys, bool menzen) const;
-    void checkAge4(Yakus &ys, const Explain4 &exp, bool menzen) const;
-    void checkPinfu4(Yakus &ys, const PointInfo &info, const Explain4 &exp, bool menzen) const;
-    void checkDye4(Yakus &ys, const Explain4 &exp, bool menzen) const;
-    void checkCup4(Yakus &ys, const Explain4 &exp, bool menzen) const;
-    void checkYakuhai4(Yakus &ys, const PointInfo &info, const Explain4 &exp) const;
-    void checkIttsuu4(Yakus &ys, const Explain4 &exp, bool menzen) const;
-    void checkSanshoku4(Yakus &ys, const Explain4 &exp, bool menzen) const;
-    void checkX34s4(Yakus &ys, const Explain4 &exp) const;
-    void checkSanshokudoukou4(Yakus &ys, const Explain4 &exp) const;
-    void checkShousangen(Yakus &ys, const Explain4 &exp) const;
-
-    Yakus calcYakuman4(const PointInfo &info, const Explain4 &exp,
+    void checkAge4(Yakus &ys, const Feature4 &f, bool menzen) const;
+    void checkPinfu4(Yakus &ys, const PointInfo &info, const Feature4 &f, bool menzen) const;
+    void checkDye4(Yakus &ys, const Feature4 &f, bool menzen) const;
+    void checkCup4(Yakus &ys, const Feature4 &f, bool menzen) const;
+    void checkYakuhai4(Yakus &ys, const PointInfo &info, const Feature4 &f) const;
+    void checkSeqs4(Yakus &ys, const Feature4 &f, bool menzen) const;
+    void checkX34s4(Yakus &ys, const Feature4 &f) const;
+    void checkShousangen(Yakus &ys, const Feature4 &f) const;
+
+    Yakus calcYakuman4(const PointInfo &info, const Explain4 &exp, const Feature4 &f,
                        const TileCount &closed, const T37 &last) const;
     Yakus calcYaku4(const PointInfo &info, const RuleInfo &rule,
-                    bool menzen, const Explain4 &exp) const;
+                    bool menzen, const Feature4 &f) const;
     int calcFu(const PointInfo &info, const Explain4 &exp, bool menzen) const;
     int calcHan(const Yakus &ys) const;
     int calcBase(int fu, int han) const;
@@ -124,6 +165,38 @@ private:
     int mAkadora;
 };
 
+///
+/// \brief Ron and tsumo results of a ready hand on one of its waits
+///
+struct Form::WaitScore
+{
+    T34 pick;
+    Form ron;
+    Form tsumo;
+};
+
+///
+/// \brief Compact copy of a Form's results, for storing many of them
+///
+/// Keeps what spell(), charge() and the point getters read, so that the
+/// text can be made when needed by Form(digest) instead of when scored.
+///
+struct Form::Digest
+{
+    uint64_t yakus;
+    int32_t base;
+    int16_t fu;
+    int16_t extraRound;
+    int8_t han;
+    int8_t dora;
+    int8_t uradora;
+    int8_t akadora;
+    uint8_t type;
+    bool yakuman;
+    bool dealerWin;
+    bool ron;
+};
+
 
 
 } // namepace saki
@@ -8,6 +8,106 @@ namespace saki
 
 
 
+namespace
+{
+
+FormGb::FanSet::Bits maskOf(std::initializer_list<Fan> fans)
+{
+    FormGb::FanSet::Bits res;
+    for (Fan f : fans)
+        res.set(f);
+    return res;
+}
+
+} // namespace
+
+
+
+void FormGb::FanSet::add(Fan f)
+{
+    mBits.set(f);
+    mCts[f]++;
+    mFan += valueOf(f);
+}
+
+bool FormGb::FanSet::has(Fan f) const
+{
+    return mBits.test(f);
+}
+
+///
+/// \brief Check if any fan in 'mask' is in the set
+///
+bool FormGb::FanSet::any(const Bits &mask) const
+{
+    return (mBits & mask).any();
+}
+
+int FormGb::FanSet::ct(Fan f) const
+{
+    return mCts[f];
+}
+
+bool FormGb::FanSet::empty() const
+{
+    return mBits.none();
+}
+
+int FormGb::FanSet::fan() const
+{
+    return mFan;
+}
+
+const FormGb::FanSet::Bits &FormGb::FanSet::bits() const
+{
+    return mBits;
+}
+
+///
+/// \brief Fans in enum order, a fan counted n times appears n times
+///
+FormGb::Fans FormGb::FanSet::list() const
+{
+    Fans res;
+    for (int f = 0; f < Fan::NUM_FANS; f++)
+        res.insert(res.end(), mCts[f], static_cast<Fan>(f));
+    return res;
+}
+
+int FormGb::FanSet::valueOf(Fan f)
+{
+    if (Fan::DSY88 <= f && f <= Fan::SSY88)
+        return 88;
+    else if (Fan::QYJ64 <= f && f <= Fan::YSSLH64)
+        return 64;
+    else if (Fan::YSSTS48 <= f && f <= Fan::YSSJG48)
+        return 48;
+    else if (Fan::YSSBG32 <= f && f <= Fan::HYJ32)
+        return 32;
+    else if (Fan::Q7D24 <= f && f <= Fan::QX24)
+        return 24;
+    else if (Fan::QL16 <= f && f <= Fan::SAK16)
+        return 16;
+    else if (Fan::DYW12 <= f && f <= Fan::SFK12)
+        return 12;
+    else if (Fan::HL8 <= f && f <= Fan::QGH8)
+        return 8;
+    else if (Fan::PPH6 <= f && f <= Fan::SJK6)
+        return 6;
+    else if (f == Fan::MAG5)
+        return 5;
+    else if (Fan::QDY4 <= f && f <= Fan::HJZ4)
+        return 4;
+    else if (Fan::JK2 <= f && f <= Fan::DY2)
+        return 2;
+    else if (Fan::YBG1 <= f && f <= Fan::ZM1)
+        return 1;
+    else
+        unreached("FormGb::FanSet::valueOf");
+}
+
+
+
 FormGb::FormGb(const Hand &ready, const T37 &pick, const PointInfo &info, bool juezhang)
     : mDianpao(true)
 {
@@ -15,30 +115,28 @@ FormGb::FormGb(const Hand &ready, const T37 &pick, const PointInfo &info, bool j
         init13(info);
     } else {
         if (ready.peekPickStep4(pick) == -1) {
-            std::vector<Explain4> exps = Explain4::make(ready.closed(), ready.barks(),
-                                                        pick, mDianpao);
+            Explain4::Explains exps = Explain4::make(ready.closed(), ready.barks(),
+                                                     pick, mDianpao);
+            bool single = isSingleWait(ready);
 
             for (const Explain4 &exp : exps) {
-                Fans fs = calcFansF4(info, ready, pick, exp, juezhang);
-                int tempFan = calcFan(fs);
-                if (tempFan > mFan) {
-                    mFans = fs;
-                    mFan = tempFan;
-                }
+                FanSet fs = calcFansF4(info, ready, pick, exp, juezhang, single);
+                if (fs.fan() > mFanSet.fan())
+                    mFanSet = fs;
             }
         }
 
         if (ready.peekPickStep7Gb(pick) == -1) {
-            Fans fs = calcFansF7(info, ready);
-            int tempFan = calcFan(fs);
-            if (tempFan > mFan) {
-                mFans = fs;
-                mFan = tempFan;
-            }
+            FanSet fs = calcFansF7(info, ready);
+            if (fs.fan() > mFanSet.fan())
+                mFanSet = fs;
         }
 
-        assert(mFan > 0);
+        assert(mFanSet.fan() > 0);
     }
+
+    mFan = mFanSet.fan();
+    mFans = mFanSet.list();
 }
 
 FormGb::FormGb(const Hand &full, const PointInfo &info, bool juezhang)
@@ -50,30 +148,28 @@ FormGb::FormGb(const Hand &full, const PointInfo &info, bool juezhang)
         init13(info);
     } else {
         if (full.step4() == -1) {
-            std::vector<Explain4> exps = Explain4::make(full.closed(), full.barks(),
-                                                        full.drawn(), mDianpao);
+            Explain4::Explains exps = Explain4::make(full.closed(), full.barks(),
+                                                     full.drawn(), mDianpao);
+            bool single = isSingleWait(full);
 
             for (const Explain4 &exp : exps) {
-                Fans fs = calcFansF4(info, full, full.drawn(), exp, juezhang);
-                int tempFan = calcFan(fs);
-                if (tempFan > mFan) {
-                    mFans = fs;
-                    mFan = tempFan;
-                }
+                FanSet fs = calcFansF4(info, full, full.drawn(), exp, juezhang, single);
+                if (fs.fan() > mFanSet.fan())
+                    mFanSet = fs;
             }
         }
 
         if (full.step7Gb() == -1) {
-            Fans fs = calcFansF7(info, full);
-            int tempFan = calcFan(fs);
-            if (tempFan > mFan) {
-                mFans = fs;
-                mFan = tempFan;
-            }
+            FanSet fs = calcFansF7(info, full);
+            if (fs.fan() > mFanSet.fan())
+                mFanSet = fs;
         }
 
-        assert(mFan > 0);
+        assert(mFanSet.fan() > 0);
     }
+
+    mFan = mFanSet.fan();
+    mFans = mFanSet.list();
 }
 
 int FormGb::fan() const
@@ -81,93 +177,73 @@ int FormGb::fan() const
     return mFan;
 }
 
+///
+/// \brief Compatible list form of fanSet()
+///
 const FormGb::Fans &FormGb::fans() const
 {
     return mFans;
 }
 
+const FormGb::FanSet &FormGb::fanSet() const
+{
+    return mFanSet;
+}
+
 void FormGb::init13(const PointInfo &info)
 {
     mType = Type::F13;
-    mFans.push_back(Fan::SSY88);
-    checkPick(mFans, info);
+    mFanSet.add(Fan::SSY88);
+    checkPick(mFanSet, info);
     if (!mDianpao)
-        mFans.push_back(Fan::ZM1);
-    mFan = calcFan(mFans);
-}
-
-int FormGb::calcFan(const FormGb::Fans &fs)
-{
-    int res = 0;
-
-    for (Fan f : fs) {
-        if (Fan::DSY88 <= f && f <= Fan::SSY88)
-            res += 88;
-        else if (Fan::QYJ64 <= f && f <= Fan::YSSLH64)
-            res += 64;
-        else if (Fan::YSSTS48 <= f && f <= Fan::YSSJG48)
-            res += 48;
-        else if (Fan::YSSBG32 <= f && f <= Fan::HYJ32)
-            res += 32;
-        else if (Fan::Q7D24 <= f && f <= Fan::QX24)
-            res += 24;
-        else if (Fan::QL16 <= f && f <= Fan::SAK16)
-            res += 16;
-        else if (Fan::DYW12 <= f && f <= Fan::SFK12)
-            res += 12;
-        else if (Fan::HL8 <= f && f <= Fan::QGH8)
-            res += 8;
-        else if (Fan::PPH6 <= f && f <= Fan::SJK6)
-            res += 6;
-        else if (f == Fan::MAG5)
-            res += 5;
-        else if (Fan::QDY4 <= f && f <= Fan::HJZ4)
-            res += 4;
-        else if (Fan::JK2 <= f && f <= Fan::DY2)
-            res += 2;
-        else if (Fan::YBG1 <= f && f <= Fan::ZM1)
-            res += 1;
-        else
-            unreached("FormGb::calcFan");
-    }
+        mFanSet.add(Fan::ZM1);
+}
 
-    return res;
+///
+/// \brief Check if the wait-hand waits for only one kind of tile
+///
+/// The same for all explanations, thus computed once per form.
+///
+bool FormGb::isSingleWait(const Hand &hand)
+{
+    // effA of wait-hand, not full (including drawn) hand
+    return hand.closed().effA(hand.barks().size()).size() == 1;
 }
 
-FormGb::Fans FormGb::calcFansF7(const PointInfo &info, const Hand &hand) const
+FormGb::FanSet FormGb::calcFansF7(const PointInfo &info, const Hand &hand) const
 {
-    Fans res;
+    FanSet res;
 
     // Lianqidui
     const auto &ts = hand.closed().t34s13();
     bool lqd = ts[0].suit() == ts.back().suit() && ts[0].val() + 6 == ts.back().val();
     if (lqd)
-        res.push_back(Fan::LQD88);
+        res.add(Fan::LQD88);
 
     // Qidui
     if (!lqd)
-        res.push_back(Fan::Q7D24);
+        res.add(Fan::Q7D24);
 
     // Qingyise
     if (!lqd && ts.front().suit() == ts.back().suit())
-        res.push_back(Fan::QYS24);
+        res.add(Fan::QYS24);
 
     // Quanda Quanzhong Quanxiao
     if (util::all(ts, [](T34 t) { return t.isNum() && t.val() >= 7; }))
-        res.push_back(Fan::QDA24);
+        res.add(Fan::QDA24);
     if (util::all(ts, [](T34 t) { return t.isNum() && 4 <= t.val() && t.val() <= 6; }))
-        res.push_back(Fan::QZ24);
+        res.add(Fan::QZ24);
     if (util::all(ts, [](T34 t) { return t.isNum() && t.val() <= 3; }))
-        res.push_back(Fan::QX24);
+        res.add(Fan::QX24);
 
     // Dayuwu Xiaoyuwu
-    if (!util::has(res, Fan::QDA24)
+    if (!res.has(Fan::QDA24)
             && util::all(ts, [](T34 t) { return t.isNum() && t.val() >= 5; })) {
-        res.push_back(Fan::DYW12);
+        res.add(Fan::DYW12);
     }
-    if (!util::has(res, Fan::QX24)
+    if (!res.has(Fan::QX24)
             && util::all(ts, [](T34 t) { return t.isNum() && t.val() <= 5; })) {
-        res.push_back(Fan::XYW12);
+        res.add(Fan::XYW12);
     }
 
     // Tuibudao
@@ -179,7 +255,7 @@ FormGb::Fans FormGb::calcFansF7(const PointInfo &info, const Hand &hand) const
         return util::has(tumbler, t);
     };
     if (util::all(ts, isTumbler))
-        res.push_back(Fan::TBD8);
+        res.add(Fan::TBD8);
 
     checkPick(res, info);
 
@@ -189,47 +265,47 @@ FormGb::Fans FormGb::calcFansF7(const PointInfo &info, const Hand &hand) const
 
     // Hunyise
     if (suits[3] + suits[4] > 0 && suits[0] + suits[1] + suits[2] == 1)
-        res.push_back(Fan::HYS6);
+        res.add(Fan::HYS6);
 
     // Wumenqi
     if (!util::has(suits, false))
-        res.push_back(Fan::WMQ6);
+        res.add(Fan::WMQ6);
 
     // Duanyao
-    if (!util::has(res, Fan::QZ24)
+    if (!res.has(Fan::QZ24)
             && util::none(ts, [](T34 t) { return t.isYao(); })) {
-        res.push_back(Fan::DY2);
+        res.add(Fan::DY2);
     }
 
     // Siguiyi
-    if (!util::has(res, Fan::YSSTS48))
+    if (!res.has(Fan::YSSTS48))
         for (int ti = 0; ti < 34; ti++)
             if (hand.closed().ct(T34(ti)) >= 3) // 4 or 3+pick
-                res.push_back(Fan::SGY2);
+                res.add(Fan::SGY2);
 
     // Queyimen
-    if (!util::has(res, Fan::TBD8) && suits[0] + suits[1] + suits[2] == 2)
-        res.push_back(Fan::QYM1);
+    if (!res.has(Fan::TBD8) && suits[0] + suits[1] + suits[2] == 2)
+        res.add(Fan::QYM1);
 
     // Wuzi
-    const std::vector<Fan> implyWz {
+    static const FanSet::Bits implyWz = maskOf({
         Fan::LQD88, Fan::QYS24, Fan::QDA24, Fan::QZ24, Fan::QX24,
         Fan::DYW12, Fan::XYW12, Fan::DY2
-    };
-    if (!util::common(res, implyWz)
+    });
+    if (!res.any(implyWz)
             && util::none(ts, [](T34 t) { return t.isZ(); })) {
-        res.push_back(Fan::WZ1);
+        res.add(Fan::WZ1);
     }
 
     // Zimo
     if (!mDianpao)
-        res.push_back(Fan::ZM1);
+        res.add(Fan::ZM1);
 
     return res;
 }
 
-FormGb::Fans FormGb::calcFansF4(const PointInfo &info, const Hand &hand, const T37 &last,
-                               const Explain4 &exp, bool juezhang) const
+FormGb::FanSet FormGb::calcFansF4(const PointInfo &info, const Hand &hand, const T37 &last,
+                                  const Explain4 &exp, bool juezhang, bool singleWait) const
 {
     TileCount total(hand.closed()); // copy
     for (const M37 &m: hand.barks())
@@ -237,7 +313,7 @@ FormGb::Fans FormGb::calcFansF4(const PointInfo &info, const Hand &hand, const T
             total.inc(t, 1);
     total.inc(last, 1);
 
-    Fans res;
+    FanSet res;
 
     const std::array<T34, 4> &heads = exp.heads();
 
@@ -257,15 +333,15 @@ FormGb::Fans FormGb::calcFansF4(const PointInfo &info, const Hand &hand, const T
     checkV5F4(res, exp);
     checkV4F4(res, exp, hand.isMenzen() && !mDianpao, juezhang);
     checkV2F4(res, exp, info, hand, last);
-    checkV1F4(res, exp, info, hand);
+    checkV1F4(res, exp, info, singleWait);
     if (res.empty()) // Wufanhu
-        res.push_back(Fan::WFH8);
+        res.add(Fan::WFH8);
 
 
     return res;
 }
 
-void FormGb::checkV8864F4(Fans &res, const Hand &hand, const Explain4 &exp, bool pure) const
+void FormGb::checkV8864F4(FanSet &res, const Hand &hand, const Explain4 &exp, bool pure) const
 {
     const std::array<T34, 4> &heads = exp.heads();
 
@@ -273,17 +349,17 @@ void FormGb::checkV8864F4(Fans &res, const Hand &hand, const Explain4 &exp, bool
     int yCt = std::count_if(exp.x34b(), exp.x34e(),
                             [](T34 t) { return t.suit() == Suit::Y; });
     if (yCt == 3)
-        res.push_back(Fan::DSY88);
+        res.add(Fan::DSY88);
     else if (yCt == 2 && exp.pair().suit() == Suit::Y)
-        res.push_back(Fan::XSY64);
+        res.add(Fan::XSY64);
 
     // Dasixi Xiaosixi
     int fCt = std::count_if(exp.x34b(), exp.x34e(),
                             [](T34 t) { return t.suit() == Suit::F; });
     if (fCt == 4)
-        res.push_back(Fan::DSX88);
+        res.add(Fan::DSX88);
     else if (fCt == 3 && exp.pair().suit() == Suit::F)
-        res.push_back(Fan::XSX64);
+        res.add(Fan::XSX64);
 
     // Jiulianbaodeng
     if (hand.isMenzen() && pure) {
@@ -293,12 +369,12 @@ void FormGb::checkV8864F4(Fans &res, const Hand &hand, const Explain4 &exp, bool
             waitLook = waitLook * 10 + hand.closed().ct(T34(suit, val));
 
         if (waitLook == 311111113)
-            res.push_back(Fan::JLBD88);
+            res.add(Fan::JLBD88);
     }
 
     // Sigang
     if (exp.numO4() + exp.numC4() == 4)
-        res.push_back(Fan::SG88);
+        res.add(Fan::SG88);
 
     // Lvyise
     auto green = [](T34 t) {
@@ -313,29 +389,29 @@ void FormGb::checkV8864F4(Fans &res, const Hand &hand, const Explain4 &exp, bool
     if (green(exp.pair())
             && util::all(exp.sb(), exp.se(), greenSeq)
             && util::all(exp.x34b(), exp.x34e(), green))
-        res.push_back(Fan::LYS88);
+        res.add(Fan::LYS88);
 
     // Qingyaojiu
     if (exp.numX34() == 4 && util::all(heads, [](T34 t) { return t.isNum19(); })
             && exp.pair().isNum19())
-        res.push_back(Fan::QYJ64);
+        res.add(Fan::QYJ64);
 
     // Ziyise
     if (util::all(heads, [](T34 h) { return h.isZ(); }) && exp.pair().isZ())
-        res.push_back(Fan::ZYS64);
+        res.add(Fan::ZYS64);
 
     // Si'anke
     if (exp.numC3() + exp.numC4() == 4)
-        res.push_back(Fan::SAK64);
+        res.add(Fan::SAK64);
 
     // Yiseshuanglonghui
     if (pure && exp.numS() == 4 && exp.pair().val() == 5
             && heads[0].val() == 1 && heads[1].val() == 1
             && heads[2].val() == 7 && heads[3].val() == 7)
-        res.push_back(Fan::YSSLH64);
+        res.add(Fan::YSSLH64);
 }
 
-void FormGb::checkV4832F4(Fans &res, const Explain4 &exp, bool pureNumMelds) const
+void FormGb::checkV4832F4(FanSet &res, const Explain4 &exp, bool pureNumMelds) const
 {
     const std::array<T34, 4> &hs = exp.heads();
     std::array<int, 4> hvs;
@@ -344,14 +420,14 @@ void FormGb::checkV4832F4(Fans &res, const Explain4 &exp, bool pureNumMelds) con
 
     // Yisesitongshun
     if (pureNumMelds && exp.numS() == 4 && hvs[0] == hvs[3])
-        res.push_back(Fan::YSSTS48);
+        res.add(Fan::YSSTS48);
 
     // Yisesijiegao
     if (pureNumMelds && exp.numX34() == 4) {
         std::array<T34, 4> xs(hs); // copy
         std::sort(xs.begin(), xs.end());
         if ((xs[0] | xs[1]) && (xs[1] | xs[2]) && (xs[2] | xs[3]))
-            res.push_back(Fan::YSSJG48);
+            res.add(Fan::YSSJG48);
     }
 
     // Yisesibugao
@@ -359,51 +435,51 @@ void FormGb::checkV4832F4(Fans &res, const Explain4 &exp, bool pureNumMelds) con
         bool twoJump = hvs[0] == 1 && hvs[1] == 3 && hvs[2] == 5 && hvs[3] == 7;
         bool oneJump = ((hs[0] | hs[1]) && (hs[1] | hs[2]) && (hs[2] | hs[3]));
         if (twoJump || oneJump)
-            res.push_back(Fan::YSSBG32);
+            res.add(Fan::YSSBG32);
     }
 
     // Sangang
     if (exp.numC4() + exp.numO4() == 3)
-        res.push_back(Fan::SG32);
+        res.add(Fan::SG32);
 
     // Hunyaojiu
-    const std::vector<Fan> implyHyj { Fan::QYJ64, Fan::ZYS64 };
-    if (!util::common(res, implyHyj) && exp.numX34() == 4  && exp.pair().isYao()
+    static const FanSet::Bits implyHyj = maskOf({ Fan::QYJ64, Fan::ZYS64 });
+    if (!res.any(implyHyj) && exp.numX34() == 4  && exp.pair().isYao()
             && util::all(hs, [](T34 t) { return t.isYao(); })) {
-        res.push_back(Fan::HYJ32);
+        res.add(Fan::HYJ32);
     }
 }
 
-void FormGb::checkV24F4(FormGb::Fans &res, const Explain4 &exp, bool pure) const
+void FormGb::checkV24F4(FanSet &res, const Explain4 &exp, bool pure) const
 {
     const auto &heads = exp.heads();
     auto isDouble = [](T34 t) { return t.isNum() && t.val() % 2 == 0; };
 
     // Quanshuangke
     if (exp.numX34() == 4 && isDouble(exp.pair()) && util::all(heads, isDouble))
-        res.push_back(Fan::QSK24);
+        res.add(Fan::QSK24);
 
     // Qingyise
-    const std::vector<Fan> implyQys { Fan::JLBD88, Fan::YSSLH64 };
-    if (!util::common(res, implyQys) && pure)
-        res.push_back(Fan::QYS24);
+    static const FanSet::Bits implyQys = maskOf({ Fan::JLBD88, Fan::YSSLH64 });
+    if (!res.any(implyQys) && pure)
+        res.add(Fan::QYS24);
 
     // Yisesantongshun
-    if (!util::has(res, Fan::YSSTS48)) {
+    if (!res.has(Fan::YSSTS48)) {
         bool a = exp.numS() >= 3 && heads[0] == heads[2];
         bool b = exp.numS() == 4 && heads[1] == heads[3];
         if (a || b)
-            res.push_back(Fan::YSSTS24);
+            res.add(Fan::YSSTS24);
     }
 
     // Yisesanjiegao
-    if (!util::has(res, Fan::YSSJG48) && exp.numX34() == 4) {
+    if (!res.has(Fan::YSSJG48) && exp.numX34() == 4) {
         std::vector<T34> xs(exp.x34b(), exp.x34e()); // copy
         std::sort(xs.begin(), xs.end());
         bool a = xs.size() >= 3 && (xs[0] | xs [1]) && (xs[1] | xs[2]);
         bool b = xs.size() == 4 && (xs[1] | xs [2]) && (xs[2] | xs[3]);
         if (a || b)
-            res.push_back(Fan::YSSJG24);
+            res.add(Fan::YSSJG24);
     }
 
     // Quanda Quanzhong Quanxiao
@@ -413,19 +489,19 @@ void FormGb::checkV24F4(FormGb::Fans &res, const Explain4 &exp, bool pure) const
     if (isBig(exp.pair())
             && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() == 7; })
             && util::all(exp.x34b(), exp.x34e(), isBig)) {
-        res.push_back(Fan::QDA24);
+        res.add(Fan::QDA24);
     } else if (isMiddle(exp.pair())
                && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() == 4; })
                && util::all(exp.x34b(), exp.x34e(), isMiddle)) {
-        res.push_back(Fan::QZ24);
+        res.add(Fan::QZ24);
     } else if (isSmall(exp.pair())
                && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() == 1; })
                && util::all(exp.x34b(), exp.x34e(), isSmall)) {
-        res.push_back(Fan::QX24);
+        res.add(Fan::QX24);
     }
 }
 
-void FormGb::checkV16F4(FormGb::Fans &res, const Explain4 &exp) const
+void FormGb::checkV16F4(FanSet &res, const Explain4 &exp) const
 {
     const auto &h = exp.heads();
 
@@ -434,7 +510,7 @@ void FormGb::checkV16F4(FormGb::Fans &res, const Explain4 &exp) const
         return l.suit() == r.suit() && l.val() == 1 && m.val() == 4 && r.val() == 7;
     };
     if (seq3In3Or4(exp, ql))
-        res.push_back(Fan::QL16);
+        res.add(Fan::QL16);
 
     // Sanseshuanglonghui
     if (exp.numS() == 4 && exp.pair().val() == 5
@@ -443,21 +519,21 @@ void FormGb::checkV16F4(FormGb::Fans &res, const Explain4 &exp) const
             && exp.pair().suit() != h[0].suit() && exp.pair().suit() != h[2].suit()
             && h[0].val() == 1 && h[1].val() == 7
             && h[2].val() == 1 && h[3].val() == 7) {
-        res.push_back(Fan::SSSLH16);
+        res.add(Fan::SSSLH16);
     }
 
     // Yisesanbugao
     auto walk1 = [](T34 l, T34 m, T34 r) { return (l | m) && (m | r); };
     auto walk2 = [](T34 l, T34 m, T34 r) { return (l || m) && (m || r); };
-    if (!util::has(res, Fan::YSSBG32))
+    if (!res.has(Fan::YSSBG32))
         if (seq3In3Or4(exp, walk1) || seq3In3Or4(exp, walk2))
-            res.push_back(Fan::YSSBG16);
+            res.add(Fan::YSSBG16);
 
     // Quandaiwu
     if (exp.pair().val() == 5
             && util::all(exp.sb(), exp.se(), [](T34 t) { return 3 <= t.val() && t.val() <= 5; })
             && util::all(exp.x34b(), exp.x34e(), [](T34 t) { return t.val() == 5; })) {
-        res.push_back(Fan::QDW16);
+        res.add(Fan::QDW16);
     }
 
     // Santongke
@@ -468,47 +544,47 @@ void FormGb::checkV16F4(FormGb::Fans &res, const Explain4 &exp) const
     };
     if (exp.numX34() == 3) {
         if (check(h[1], h[2], h[3])) // X34 lays from the back
-            res.push_back(Fan::STK16);
+            res.add(Fan::STK16);
     } else if (exp.numX34() == 4) {
         if (check(h[0], h[1], h[2])
                 || check(h[0], h[1], h[3])
                 || check(h[0], h[2], h[3])
                 || check(h[1], h[2], h[3]))
-            res.push_back(Fan::STK16);
+            res.add(Fan::STK16);
     }
 
     // San'anke
     if (exp.numC3() + exp.numC4() == 3)
-        res.push_back(Fan::SAK16);
+        res.add(Fan::SAK16);
 }
 
-void FormGb::checkV12F4(FormGb::Fans &res, const Explain4 &exp) const
+void FormGb::checkV12F4(FanSet &res, const Explain4 &exp) const
 {
     // Dayuwu
     auto gt5 = [](T34 t) { return t.isNum() && t.val() > 5; };
-    if (!util::has(res, Fan::QDA24)
+    if (!res.has(Fan::QDA24)
             && gt5(exp.pair())
             && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() > 5; })
             && util::all(exp.x34b(), exp.x34e(), gt5)) {
-        res.push_back(Fan::DYW12);
+        res.add(Fan::DYW12);
     }
 
     // Xiaoyuwu
     auto lt5 = [](T34 t) { return t.isNum() && t.val() < 5; };
-    if (!util::has(res, Fan::QX24)
+    if (!res.has(Fan::QX24)
             && lt5(exp.pair())
             && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() < 2; })
             && util::all(exp.x34b(), exp.x34e(), lt5)) {
-        res.push_back(Fan::XYW12);
+        res.add(Fan::XYW12);
     }
 
     // Sanfengke
     auto isF = [](T34 t) { return t.suit() == Suit::F; };
-    if (!util::has(res, Fan::XSX64) && std::count_if(exp.x34b(), exp.x34e(), isF) == 3)
-        res.push_back(Fan::SFK12);
+    if (!res.has(Fan::XSX64) && std::count_if(exp.x34b(), exp.x34e(), isF) == 3)
+        res.add(Fan::SFK12);
 }
 
-void FormGb::checkV8F4(FormGb::Fans &res, const Explain4 &exp, const PointInfo &info) const
+void FormGb::checkV8F4(FanSet &res, const Explain4 &exp, const PointInfo &info) const
 {
     // Hualong
     std::vector<T34> vals(exp.sb(), exp.se()); // copy
@@ -519,13 +595,13 @@ void FormGb::checkV8F4(FormGb::Fans &res, const Explain4 &exp, const PointInfo &
     };
     if (exp.numS() == 3) {
         if (jerk(vals[0], vals[1], vals[2]))
-            res.push_back(Fan::HL8);
+            res.add(Fan::HL8);
     } else if (exp.numS() == 4) {
         if (jerk(vals[0], vals[1], vals[2])
                 || jerk(vals[0], vals[1], vals[3])
                 || jerk(vals[0], vals[2], vals[3])
                 || jerk(vals[1], vals[2], vals[3]))
-            res.push_back(Fan::HL8);
+            res.add(Fan::HL8);
     }
 
     // Tuibudao
@@ -543,7 +619,7 @@ void FormGb::checkV8F4(FormGb::Fans &res, const Explain4 &exp, const PointInfo &
     if (isTumbler(exp.pair())
             && util::all(exp.sb(), exp.se(), isTumblerSeq)
             && util::all(exp.x34b(), exp.x34e(), isTumbler)) {
-        res.push_back(Fan::TBD8);
+        res.add(Fan::TBD8);
     }
 
     // Sansesantongshun
@@ -552,7 +628,7 @@ void FormGb::checkV8F4(FormGb::Fans &res, const Explain4 &exp, const PointInfo &
                 && a.val() == b.val() && b.val() == c.val();
     };
     if (seq3In3Or4(exp, sanse))
-        res.push_back(Fan::SSSTS8);
+        res.add(Fan::SSSTS8);
 
     // Sansesanjiegao
     std::vector<T34> xs(exp.x34b(), exp.x34e()); // copy
@@ -563,29 +639,29 @@ void FormGb::checkV8F4(FormGb::Fans &res, const Explain4 &exp, const PointInfo &
     };
     if (xs.size() == 3) {
         if (kick(xs[0], xs[1], xs[2]))
-            res.push_back(Fan::SSSJG8);
+            res.add(Fan::SSSJG8);
     } else if (xs.size() == 4) {
         if (kick(xs[0], xs[1], xs[2])
                 || kick(xs[0], xs[1], xs[3])
                 || kick(xs[0], xs[2], xs[3])
                 || kick(xs[1], xs[2], xs[3]))
-            res.push_back(Fan::SSSJG8);
+            res.add(Fan::SSSJG8);
     }
 
     checkPick(res, info);
 }
 
-void FormGb::checkV6F4(FormGb::Fans &res, const Explain4 &exp, const Hand &hand) const
+void FormGb::checkV6F4(FanSet &res, const Explain4 &exp, const Hand &hand) const
 {
     const std::array<T34, 4> &h = exp.heads();
 
     // Pengpenghu
-    const std::vector<Fan> implyPph {
+    static const FanSet::Bits implyPph = maskOf({
         Fan::DSX88, Fan::SG88, Fan::QYJ64, Fan::ZYS64, Fan::SAK64,
         Fan::YSSJG48, Fan::HYJ32, Fan::QSK24
-    };
-    if (!util::common(res, implyPph) && exp.numX34() == 4)
-        res.push_back(Fan::PPH6);
+    });
+    if (!res.any(implyPph) && exp.numX34() == 4)
+        res.add(Fan::PPH6);
 
     std::array<bool, 5> suits { false, false, false, false, false };
     suits[static_cast<int>(exp.pair().suit())] = true;
@@ -593,9 +669,9 @@ void FormGb::checkV6F4(FormGb::Fans &res, const Explain4 &exp, const Hand &hand)
         suits[static_cast<int>(t.suit())] = true;
 
     // Hunyise
-    if (!util::has(res, Fan::LYS88)
+    if (!res.has(Fan::LYS88)
             && suits[3] + suits[4] > 0 && suits[0] + suits[1] + suits[2] == 1) {
-        res.push_back(Fan::HYS6);
+        res.add(Fan::HYS6);
     }
 
     // Sansesanbugao
@@ -607,97 +683,97 @@ void FormGb::checkV6F4(FormGb::Fans &res, const Explain4 &exp, const Hand &hand)
     };
     if (seqs.size() == 3) {
         if (raise(seqs[0], seqs[1], seqs[2]))
-            res.push_back(Fan::SSSBG6);
+            res.add(Fan::SSSBG6);
     } else if (seqs.size() == 4) {
         if (raise(seqs[0], seqs[1], seqs[2])
                 || raise(seqs[0], seqs[1], seqs[3])
                 || raise(seqs[0], seqs[2], seqs[3])
                 || raise(seqs[1], seqs[2], seqs[3]))
-            res.push_back(Fan::SSSBG6);
+            res.add(Fan::SSSBG6);
     }
 
     // Wumenqi
     if (!util::has(suits, false))
-        res.push_back(Fan::WMQ6);
+        res.add(Fan::WMQ6);
 
     // Quanqiuren
     auto isAnkan = [](const M37 &m) { return m.type() == M37::Type::ANKAN; };
     if (hand.barks().size() == 4 && util::none(hand.barks(), isAnkan))
-        res.push_back(Fan::QQR6);
+        res.add(Fan::QQR6);
 
     // Shuang'an'gang
-    const std::vector<Fan> implySag { Fan::SG88, Fan::SG32, Fan::SAK2 };
-    if (!util::common(res, implySag) && exp.numC4() == 2)
-        res.push_back(Fan::SAG6);
+    static const FanSet::Bits implySag = maskOf({ Fan::SG88, Fan::SG32, Fan::SAK2 });
+    if (!res.any(implySag) && exp.numC4() == 2)
+        res.add(Fan::SAG6);
 
     // Shuangjianke
     int yCt = std::count_if(exp.x34b(), exp.x34e(), [](T34 t) { return t.suit() == Suit::Y; });
-    if (!util::has(res, Fan::XSY64) && yCt == 2)
-        res.push_back(Fan::SJK6);
+    if (!res.has(Fan::XSY64) && yCt == 2)
+        res.add(Fan::SJK6);
 }
 
-void FormGb::checkV5F4(FormGb::Fans &res, const Explain4 &exp) const
+void FormGb::checkV5F4(FanSet &res, const Explain4 &exp) const
 {
     // Ming'an'gang
-    const std::vector<Fan> implyMag { Fan::SG88, Fan::SG32 };
-    if (!util::common(res, implyMag) && exp.numO4() == 1 && exp.numC4() == 1)
-        res.push_back(Fan::MAG5);
+    static const FanSet::Bits implyMag = maskOf({ Fan::SG88, Fan::SG32 });
+    if (!res.any(implyMag) && exp.numO4() == 1 && exp.numC4() == 1)
+        res.add(Fan::MAG5);
 }
 
-void FormGb::checkV4F4(FormGb::Fans &res, const Explain4 &exp, bool mqq, bool hjz) const
+void FormGb::checkV4F4(FanSet &res, const Explain4 &exp, bool mqq, bool hjz) const
 {
     // Quandaiyao
-    std::vector<Fan> implyQdy { Fan::QYJ64, Fan::ZYS64, Fan::HYJ32 };
-    if (!util::common(res, implyQdy)
+    static const FanSet::Bits implyQdy = maskOf({ Fan::QYJ64, Fan::ZYS64, Fan::HYJ32 });
+    if (!res.any(implyQdy)
             && exp.pair().isYao()
             && util::all(exp.sb(), exp.se(), [](T34 t) { return t.val() == 1 || t.val() == 7; })
             && util::all(exp.x34b(), exp.x34e(), [](T34 t) { return t.isYao(); })) {
-        res.push_back(Fan::QDY4);
+        res.add(Fan::QDY4);
     }
 
     // Buqiuren
-    std::vector<Fan> implyBqr { Fan::JLBD88, Fan::SAK64 };
-    if (!util::common(res, implyBqr) && mqq && !mDianpao)
-        res.push_back(Fan::BQR4);
+    static const FanSet::Bits implyBqr = maskOf({ Fan::JLBD88, Fan::SAK64 });
+    if (!res.any(implyBqr) && mqq && !mDianpao)
+        res.add(Fan::BQR4);
 
     // Shuangming'gang
-    const std::vector<Fan> implySmg { Fan::SG88, Fan::SG32 };
-    if (!util::common(res, implySmg) && exp.numO4() == 2)
-        res.push_back(Fan::SMG4);
+    static const FanSet::Bits implySmg = maskOf({ Fan::SG88, Fan::SG32 });
+    if (!res.any(implySmg) && exp.numO4() == 2)
+        res.add(Fan::SMG4);
 
     // Hujuezhang
     if (hjz)
-        res.push_back(Fan::HJZ4);
+        res.add(Fan::HJZ4);
 }
 
-void FormGb::checkV2F4(FormGb::Fans &res, const Explain4 &exp,
+void FormGb::checkV2F4(FanSet &res, const Explain4 &exp,
                        const PointInfo &info, const Hand &hand, const T37 &pick) const
 {
     // Jianke
     int yCt = std::count_if(exp.x34b(), exp.x34e(),
                             [](T34 t) { return t.suit() == Suit::Y; });
     if (yCt == 1)
-        res.push_back(Fan::JK2);
+        res.add(Fan::JK2);
 
     // Quanfengke
     T34 quanF(Suit::F, info.roundWind);
-    if (!util::has(res, Fan::DSX88) && util::has(exp.x34b(), exp.x34e(), quanF))
-        res.push_back(Fan::QFK2);
+    if (!res.has(Fan::DSX88) && util::has(exp.x34b(), exp.x34e(), quanF))
+        res.add(Fan::QFK2);
 
     // Menfengke
     T34 menF(Suit::F, info.selfWind);
-    if (!util::has(res, Fan::DSX88) && util::has(exp.x34b(), exp.x34e(), menF))
-        res.push_back(Fan::MFK2);
+    if (!res.has(Fan::DSX88) && util::has(exp.x34b(), exp.x34e(), menF))
+        res.add(Fan::MFK2);
 
     // Menqianqing
-    const std::vector<Fan> implyMqq { Fan::JLBD88, Fan::SAK64, Fan::BQR4 };
-    if (!util::common(res, implyMqq) && hand.isMenzen())
-        res.push_back(Fan::MQQ2);
+    static const FanSet::Bits implyMqq = maskOf({ Fan::JLBD88, Fan::SAK64, Fan::BQR4 });
+    if (!res.any(implyMqq) && hand.isMenzen())
+        res.add(Fan::MQQ2);
 
     // Pinghu
-    const std::vector<Fan> implyPh { Fan::YSSLH64, Fan::SSSLH16 };
-    if (!util::common(res, implyPh) && exp.numS() == 4 && exp.pair().isNum())
-        res.push_back(Fan::PH2);
+    static const FanSet::Bits implyPh = maskOf({ Fan::YSSLH64, Fan::SSSLH16 });
+    if (!res.any(implyPh) && exp.numS() == 4 && exp.pair().isNum())
+        res.add(Fan::PH2);
 
     // Siguiyi
     TileCount noGang(hand.closed()); // copy
@@ -708,37 +784,37 @@ void FormGb::checkV2F4(FormGb::Fans &res, const Explain4 &exp,
     noGang.inc(pick, 1);
     for (int ti = 0; ti < 34; ti++)
         if (noGang.ct(T34(ti)) == 4)
-            res.push_back(Fan::SGY2);
+            res.add(Fan::SGY2);
 
     // Shuangtongke
-    if (!util::has(res, Fan::QYJ64) && !util::has(res, Fan::STK16))
+    if (!res.has(Fan::QYJ64) && !res.has(Fan::STK16))
         for (auto it = exp.x34b(); it + 1 < exp.x34e(); it++)
             for (auto jt = it + 1; jt < exp.x34e(); jt++)
                 if (it->isNum() && jt->isNum() && it->val() == jt->val())
-                    res.push_back(Fan::STK2);
+                    res.add(Fan::STK2);
 
     // Shuanganke
-    if (!util::has(res, Fan::SAG6))
+    if (!res.has(Fan::SAG6))
         if (exp.numC3() + exp.numC4() == 2)
-            res.push_back(Fan::SAK2);
+            res.add(Fan::SAK2);
 
     // An'gang
-    const std::vector<Fan> implyAg { Fan::SG88, Fan::SG32 };
-    if (!util::common(res, implyAg) && exp.numC4() == 1)
-        res.push_back(Fan::AG2);
+    static const FanSet::Bits implyAg = maskOf({ Fan::SG88, Fan::SG32 });
+    if (!res.any(implyAg) && exp.numC4() == 1)
+        res.add(Fan::AG2);
 
     // Duanyao
-    const std::vector<Fan> implyDy { Fan::QSK24, Fan::QZ24, Fan::QDW16 };
-    if (!util::common(res, implyDy)
+    static const FanSet::Bits implyDy = maskOf({ Fan::QSK24, Fan::QZ24, Fan::QDW16 });
+    if (!res.any(implyDy)
             && util::none(exp.sb(), exp.se(), [](T34 t) { return t.val() == 1 || t.val() == 7; })
             && util::none(exp.x34b(), exp.x34e(), [](T34 t) { return t.isYao(); })
             && !exp.pair().isYao()) {
-        res.push_back(Fan::DY2);
+        res.add(Fan::DY2);
     }
 }
 
-void FormGb::checkV1F4(FormGb::Fans &res, const Explain4 &exp,
-                       const PointInfo &info, const Hand &hand) const
+void FormGb::checkV1F4(FanSet &res, const Explain4 &exp,
+                       const PointInfo &info, bool singleWait) const
 {
     const std::array<T34, 4> &h = exp.heads();
 
@@ -746,20 +822,20 @@ void FormGb::checkV1F4(FormGb::Fans &res, const Explain4 &exp,
     // Xixiangfeng
     // Lianliu
     // Laoshaofu
-    const std::vector<Fan> implyYbg { Fan::YSSLH64, Fan::YSSTS48, Fan::YSSTS24 };
-    const std::vector<Fan> implyXxf { Fan::SSSLH16, Fan::SSSTS8 };
-    const std::vector<Fan> implyLl { Fan::QL16 };
-    const std::vector<Fan> implyLsf { Fan::YSSLH64, Fan::QL16, Fan::SSSLH16 };
+    static const FanSet::Bits implyYbg = maskOf({ Fan::YSSLH64, Fan::YSSTS48, Fan::YSSTS24 });
+    static const FanSet::Bits implyXxf = maskOf({ Fan::SSSLH16, Fan::SSSTS8 });
+    static const FanSet::Bits implyLl = maskOf({ Fan::QL16 });
+    static const FanSet::Bits implyLsf = maskOf({ Fan::YSSLH64, Fan::QL16, Fan::SSSLH16 });
     auto exclude = [](T34, T34) { return false; };
-    auto ban = util::common(res, implyYbg) ? exclude
+    auto ban = res.any(implyYbg) ? exclude
                                            : [](T34 a, T34 b) { return a == b; };
-    auto feng = util::common(res, implyXxf) ? exclude
+    auto feng = res.any(implyXxf) ? exclude
                                             : [](T34 a, T34 b) {
         return a.suit() != b.suit() && a.val() == b.val();
     };
-    auto lian = util::common(res, implyLl) ? exclude
+    auto lian = res.any(implyLl) ? exclude
                                            : [](T34 a, T34 b) { return a ^ b; };
-    auto lao = util::common(res, implyLsf) ? exclude
+    auto lao = res.any(implyLsf) ? exclude
                                            : [](T34 a, T34 b) {
         return a.suit() == b.suit() && a.val() == 1 && b.val() == 7;
     };
@@ -785,16 +861,16 @@ void FormGb::checkV1F4(FormGb::Fans &res, const Explain4 &exp,
                 }
 
                 if (ban(h[i], h[j])) {
-                    res.push_back(Fan::YBG1);
+                    res.add(Fan::YBG1);
                     edges[i][j] = true;
                 } else if (feng(h[i], h[j])) {
-                    res.push_back(Fan::XXF1);
+                    res.add(Fan::XXF1);
                     edges[i][j] = true;
                 } else if (lian(h[i], h[j])) {
-                    res.push_back(Fan::LL1);
+                    res.add(Fan::LL1);
                     edges[i][j] = true;
                 } else if (lao(h[i], h[j])) {
-                    res.push_back(Fan::LSF1);
+                    res.add(Fan::LSF1);
                     edges[i][j] = true;
                 }
             }
@@ -802,66 +878,67 @@ void FormGb::checkV1F4(FormGb::Fans &res, const Explain4 &exp,
     }
 
     // Yaojiuke
-    std::vector<Fan> implyYjk {
+    static const FanSet::Bits implyYjk = maskOf({
         Fan::DSX88, Fan::JLBD88, Fan::QYJ64, Fan::ZYS64, Fan::HYJ32
-    };
-    if(!util::common(res, implyYjk)) {
+    });
+    if(!res.any(implyYjk)) {
         for (auto it = exp.x34b(); it != exp.x34e(); it++) {
             bool num19 = it->isNum19();
             bool okF = it->suit() == Suit::F
-                    && !util::has(res, Fan::XSX64)
+                    && !res.has(Fan::XSX64)
                     && it->val() != info.selfWind
                     && it->val() != info.roundWind;
             if (num19 || okF)
-                res.push_back(Fan::YJK1);
+                res.add(Fan::YJK1);
         }
     }
 
     // Ming'gang
-    const std::vector<Fan> implyMg { Fan::SG88, Fan::SG32 };
-    if (!util::common(res, implyMg) && exp.numO4() == 1)
-        res.push_back(Fan::MG1);
+    static const FanSet::Bits implyMg = maskOf({ Fan::SG88, Fan::SG32 });
+    if (!res.any(implyMg) && exp.numO4() == 1)
+        res.add(Fan::MG1);
 
     // Queyimen
     std::array<bool, 3> hasSuits { false, false, false };
-    hasSuits[static_cast<int>(exp.pair().suit())] = true;
+    if (exp.pair().isNum())
+        hasSuits[static_cast<int>(exp.pair().suit())] = true;
     for (T34 t : exp.heads())
-        hasSuits[static_cast<int>(t.suit())] = true;
+        if (t.isNum())
+            hasSuits[static_cast<int>(t.suit())] = true;
     int hasSuitCt = hasSuits[0] + hasSuits[1] + hasSuits[2];
-    std::vector<Fan> implyQym {
+    static const FanSet::Bits implyQym = maskOf({
         Fan::XSY64, Fan::XSX64, Fan::YSSTS48, Fan::YSSJG48, Fan::YSSBG32,
         Fan::SFK12, Fan::TBD8
-    };
-    if (!util::common(res, implyQym) && hasSuitCt == 2)
-        res.push_back(Fan::QYM1);
+    });
+    if (!res.any(implyQym) && hasSuitCt == 2)
+        res.add(Fan::QYM1);
 
     // Wuzi
-    std::vector<Fan> implyWz {
+    static const FanSet::Bits implyWz = maskOf({
         Fan::QYJ64, Fan::YSSLH64, Fan::QSK24, Fan::QYS24,
         Fan::QDA24, Fan::QZ24, Fan::QX24, Fan::SSSLH16, Fan::QDW16,
         Fan::DYW12, Fan::XYW12, Fan::DY2, Fan::PH2
-    };
-    if (!util::common(res, implyWz)
+    });
+    if (!res.any(implyWz)
             && !exp.pair().isZ()
             && util::none(exp.heads(), [](T34 t) { return t.isZ(); })) {
-        res.push_back(Fan::WZ1);
+        res.add(Fan::WZ1);
     }
 
     // Bianzhang
     // Kanzhang
     // Dandiaojiang
-    if (hand.closed().effA(hand.barks().size()).size() == 1) {
-        // effA of wait-hand, not full (including drawn) hand
+    if (singleWait) {
         switch (exp.wait()) {
         case Wait::SIDE:
-            res.push_back(Fan::BZ1);
+            res.add(Fan::BZ1);
             break;
         case Wait::CLAMP:
-            res.push_back(Fan::KZ1);
+            res.add(Fan::KZ1);
             break;
         case Wait::ISORIDE:
-            if (!util::has(res, Fan::SG88) && !util::has(res, Fan::QQR6))
-                res.push_back(Fan::DDJ1);
+            if (!res.has(Fan::SG88) && !res.has(Fan::QQR6))
+                res.add(Fan::DDJ1);
             break;
         default:
             break;
@@ -869,19 +946,23 @@ void FormGb::checkV1F4(FormGb::Fans &res, const Explain4 &exp,
     }
 
     // Zimo
-    if (!util::has(res, Fan::BQR4) && !mDianpao)
-        res.push_back(Fan::ZM1);
+    if (!res.has(Fan::BQR4) && !mDianpao)
+        res.add(Fan::ZM1);
 }
 
-void FormGb::checkPick(FormGb::Fans &fs, const PointInfo &info) const
+void FormGb::checkPick(FanSet &fs, const PointInfo &info) const
 {
     if (info.duringKan)
-        fs.push_back(mDianpao ? Fan::QGH8 : Fan::GSKH8);
+        fs.add(mDianpao ? Fan::QGH8 : Fan::GSKH8);
     if (info.emptyMount) // not 'else if', addable in GB rule
-        fs.push_back(mDianpao ? Fan::HDLY8 : Fan::MSHC8);
+        fs.add(mDianpao ? Fan::HDLY8 : Fan::MSHC8);
 }
 
-bool FormGb::seq3In3Or4(const Explain4 &exp, std::function<bool(T34, T34, T34)> p) const
+///
+/// \brief Check if 3 of the sequences satisfy 'p', in head order
+///
+template<typename Pred>
+bool FormGb::seq3In3Or4(const Explain4 &exp, Pred p) const
 {
     const std::array<T34, 4> &h = exp.heads();
 
@@ -4,7 +4,9 @@
 #include "hand.h"
 #include "explain.h"
 
-#include <functional>
+#include <array>
+#include <bitset>
+#include <vector>
 
 
 
@@ -40,43 +42,72 @@ public:
 
     using Fans = std::vector<Fan>;
 
+    ///
+    /// \brief Fans as presence bits plus repeat counts, with the running total
+    ///
+    class FanSet
+    {
+    public:
+        using Bits = std::bitset<Fan::NUM_FANS>;
+
+        void add(Fan f);
+        bool has(Fan f) const;
+        bool any(const Bits &mask) const;
+        int ct(Fan f) const;
+        bool empty() const;
+        int fan() const;
+        const Bits &bits() const;
+        Fans list() const;
+
+        static int valueOf(Fan f);
+
+    private:
+        Bits mBits;
+        std::array<uint8_t, Fan::NUM_FANS> mCts {};
+        int mFan = 0;
+    };
+
     FormGb(const Hand &ready, const T37 &pick, const PointInfo &info, bool juezhang);
     FormGb(const Hand &full, const PointInfo &info, bool juezhang);
     ~FormGb() = default;
 
     int fan() const;
     const Fans &fans() const;
+    const FanSet &fanSet() const;
 
 private:
     void init13(const PointInfo &info);
 
-    static int calcFan(const Fans &fs);
+    static bool isSingleWait(const Hand &hand);
 
-    Fans calcFansF7(const PointInfo &info, const Hand &hand) const;
-    Fans calcFansF4(const PointInfo &info, const Hand &hand, const T37 &last,
-                    const Explain4 &exp, bool juezhang) const;
+    FanSet calcFansF7(const PointInfo &info, const Hand &hand) const;
+    FanSet calcFansF4(const PointInfo &info, const Hand &hand, const T37 &last,
+                      const Explain4 &exp, bool juezhang, bool singleWait) const;
 
-    void checkV8864F4(Fans &res, const Hand &hand, const Explain4 &exp,
+    void checkV8864F4(FanSet &res, const Hand &hand, const Explain4 &exp,
                       bool pure) const;
-    void checkV4832F4(Fans &res, const Explain4 &exp, bool pureNumMelds) const;
-    void checkV24F4(Fans &res, const Explain4 &exp, bool pure) const;
-    void checkV16F4(Fans &res, const Explain4 &exp) const;
-    void checkV12F4(Fans &res, const Explain4 &exp) const;
-    void checkV8F4(Fans &res, const Explain4 &exp, const PointInfo &info) const;
-    void checkV6F4(Fans &res, const Explain4 &exp, const Hand &hand) const;
-    void checkV5F4(Fans &res, const Explain4 &exp) const;
-    void checkV4F4(Fans &res, const Explain4 &exp, bool mqq, bool hjz) const;
-    void checkV2F4(Fans &res, const Explain4 &exp, const PointInfo &info,
+    void checkV4832F4(FanSet &res, const Explain4 &exp, bool pureNumMelds) const;
+    void checkV24F4(FanSet &res, const Explain4 &exp, bool pure) const;
+    void checkV16F4(FanSet &res, const Explain4 &exp) const;
+    void checkV12F4(FanSet &res, const Explain4 &exp) const;
+    void checkV8F4(FanSet &res, const Explain4 &exp, const PointInfo &info) const;
+    void checkV6F4(FanSet &res, const Explain4 &exp, const Hand &hand) const;
+    void checkV5F4(FanSet &res, const Explain4 &exp) const;
+    void checkV4F4(FanSet &res, const Explain4 &exp, bool mqq, bool hjz) const;
+    void checkV2F4(FanSet &res, const Explain4 &exp, const PointInfo &info,
                    const Hand &hand, const T37 &pick) const;
-    void checkV1F4(Fans &res, const Explain4 &exp, const PointInfo &info, const Hand &hand) const;
+    void checkV1F4(FanSet &res, const Explain4 &exp, const PointInfo &info,
+                   bool singleWait) const;
 
-    void checkPick(Fans &fans, const PointInfo &info) const;
+    void checkPick(FanSet &fans, const PointInfo &info) const;
 
-    bool seq3In3Or4(const Explain4 &exp, std::function<bool(T34, T34, T34)> p) const;
+    template<typename Pred>
+    bool seq3In3Or4(const Explain4 &exp, Pred p) const;
 
 private:
     Type mType;
     bool mDianpao;
+    FanSet mFanSet;
     Fans mFans;
     int mFan = 0;
 };
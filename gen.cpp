@@ -1,7 +1,9 @@
 #include "gen.h"
 #include "rand.h"
 #include "util.h"
+#include "util_parallel.h"
 
+#include <algorithm>
 #include <cassert>
 
 
@@ -256,6 +258,51 @@ Gen Gen::genForm4F110Horse(Rand &rand, int selfWind, const RuleInfo &rule, bool
     }
 }
 
+///
+/// \brief Call 'gen' 'count' times on 'threads' workers
+///
+/// Results are cut into chunks of BATCH_CHUNK, and each chunk draws
+/// from its own Rand seeded by (seed, chunk index). The output thus
+/// depends only on 'seed' and 'count', not on the thread count.
+/// 'gen' is called concurrently and must not share mutable state.
+///
+std::vector<Gen> Gen::genBatch(uint32_t seed, size_t count,
+                               const std::function<Gen(Rand &)> &gen, int threads)
+{
+    size_t chunkCt = (count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    std::vector<std::vector<Gen>> chunks(chunkCt);
+
+    util::parallelFor(chunkCt, threads, [&](size_t c) {
+        Rand rand;
+        rand.set(chunkSeed(seed, c));
+        size_t end = std::min(count, (c + 1) * BATCH_CHUNK);
+        chunks[c].reserve(end - c * BATCH_CHUNK);
+        for (size_t i = c * BATCH_CHUNK; i < end; i++)
+            chunks[c].push_back(gen(rand));
+    });
+
+    std::vector<Gen> res;
+    res.reserve(count);
+    for (auto &chunk : chunks)
+        for (Gen &g : chunk)
+            res.push_back(std::move(g));
+
+    return res;
+}
+
+///
+/// \brief Seed of a chunk's substream, never 0 as minstd_rand requires
+///
+uint32_t Gen::chunkSeed(uint32_t seed, size_t chunk)
+{
+    // splitmix-style finalizer, neighboring chunks get unrelated streams
+    uint32_t x = seed ^ static_cast<uint32_t>(chunk * 0x9e3779b9u);
+    x = (x ^ (x >> 16)) * 0x85ebca6bu;
+    x = (x ^ (x >> 13)) * 0xc2b2ae35u;
+    x ^= x >> 16;
+    return 1 + x % 2147483646u;
+}
+
 Hand Gen::genFormal4(Rand &rand, int triCent, int quadCent, int openCent)
 {
     // monkey algorithm, usually ends within a few (less than 3) loops
@@ -4,6 +4,9 @@
 #include "form.h"
 #include "rand.h"
 
+#include <functional>
+#include <vector>
+
 
 
 namespace saki
@@ -28,11 +31,17 @@ public:
     static Gen genForm4F110Han(Rand &rand, int han, int selfWind, const RuleInfo &rule, bool ron);
     static Gen genForm4F110Horse(Rand &rand, int selfWind, const RuleInfo &rule, bool ron);
 
+    static std::vector<Gen> genBatch(uint32_t seed, size_t count,
+                                     const std::function<Gen(Rand &)> &gen, int threads = 0);
+
+    static const size_t BATCH_CHUNK = 32;
+
 private:
     Gen(const Form &form, const Hand &hand, const T37 &pick);
 
     static Hand genFormal4(Rand &rand, int triCent, int quadCent, int openCent);
     static Hand genWild4(Rand &rand, int triCent, int quadCent, int openCent);
+    static uint32_t chunkSeed(uint32_t seed, size_t chunk);
     static void genInfo(Rand &rand, PointInfo &info, T34 pick, const Hand &h,
                         bool ron, bool f110);
 
@@ -0,0 +1,156 @@
+#include "gen_gb.h"
+#include "util_parallel.h"
+
+#include <utility>
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+GenGb::GenGb(const FormGb &form, const Hand &hand, const T37 &pick)
+    : form(form)
+    , hand(hand)
+    , pick(pick)
+{
+}
+
+
+
+namespace
+{
+
+HandEnum::Options unscored(const HandEnum::Options &opt)
+{
+    HandEnum::Options res(opt);
+    res.score = false;
+    return res;
+}
+
+} // namespace
+
+///
+/// \brief Enumerate the hands allowed by 'opt' and index them
+///
+/// The enumeration leaves scoring to the index, which runs
+/// one FormGb per row for both the fan total and the fan kinds.
+///
+FanIndex::FanIndex(const HandEnum::Options &opt, int threads)
+    : FanIndex(HandEnum::run(unscored(opt), threads), opt, threads)
+{
+}
+
+///
+/// \brief Index a prebuilt table, scored or not
+///
+/// The table must have been enumerated with 'opt', whose scoring context
+/// is used to score every row again with one FormGb on 'threads' workers.
+///
+FanIndex::FanIndex(HandEnum table, const HandEnum::Options &opt, int threads)
+    : mOpt(opt)
+    , mTable(std::move(table))
+    , mFanSets(mTable.size())
+    , mByKind(Fan::NUM_FANS)
+{
+    util::parallelFor(mTable.size(), threads, [this](size_t row) {
+        GenGb gen = make(static_cast<uint32_t>(row));
+        mTable.fans[row] = static_cast<int16_t>(gen.form.fan());
+        for (Fan f : gen.form.fans())
+            mFanSets[row].set(f);
+    });
+
+    for (uint32_t row = 0; row < mTable.size(); row++) {
+        mByFan[mTable.fans[row]].push_back(row);
+        for (int f = 0; f < Fan::NUM_FANS; f++)
+            if (mFanSets[row].test(f))
+                mByKind[f].push_back(row);
+    }
+}
+
+///
+/// \brief Uniformly pick a hand whose fan total is 'fan'
+/// \pre countFan(fan) > 0
+///
+GenGb FanIndex::genFan(Rand &rand, int fan) const
+{
+    auto it = mByFan.find(fan);
+    assert(it != mByFan.end());
+    const std::vector<uint32_t> &rows = it->second;
+    return make(rows[rand.gen(static_cast<int32_t>(rows.size()))]);
+}
+
+///
+/// \brief Uniformly pick a hand having every fan kind in 'must'
+/// \pre countFans(must) > 0
+///
+GenGb FanIndex::genFans(Rand &rand, const FormGb::Fans &must) const
+{
+    if (must.empty())
+        return make(static_cast<uint32_t>(rand.gen(static_cast<int32_t>(mTable.size()))));
+
+    std::vector<uint32_t> rows = matchFans(must);
+    assert(!rows.empty());
+    return make(rows[rand.gen(static_cast<int32_t>(rows.size()))]);
+}
+
+size_t FanIndex::countFan(int fan) const
+{
+    auto it = mByFan.find(fan);
+    return it == mByFan.end() ? 0 : it->second.size();
+}
+
+size_t FanIndex::countFans(const FormGb::Fans &must) const
+{
+    return must.empty() ? mTable.size() : matchFans(must).size();
+}
+
+size_t FanIndex::size() const
+{
+    return mTable.size();
+}
+
+///
+/// \brief Rows having all of 'must', filtered from the rarest kind's list
+/// \pre 'must' is not empty, every row matches an empty one
+///
+std::vector<uint32_t> FanIndex::matchFans(const FormGb::Fans &must) const
+{
+    assert(!must.empty());
+
+    std::vector<uint32_t> res;
+    FanSet want;
+    const std::vector<uint32_t> *rarest = nullptr;
+    for (Fan f : must) {
+        want.set(f);
+        if (rarest == nullptr || mByKind[f].size() < rarest->size())
+            rarest = &mByKind[f];
+    }
+
+    for (uint32_t row : *rarest)
+        if ((mFanSets[row] & want) == want)
+            res.push_back(row);
+
+    return res;
+}
+
+GenGb FanIndex::make(uint32_t row) const
+{
+    PointInfo info;
+    info.selfWind = mOpt.selfWind;
+    info.roundWind = mOpt.roundWind;
+
+    Hand hand = mTable.ready(row);
+    T37 pick(mTable.picks[row]);
+    if (mOpt.ron)
+        return GenGb(FormGb(hand, pick, info, false), hand, pick);
+
+    hand.draw(pick);
+    return GenGb(FormGb(hand, info, false), hand, pick);
+}
+
+
+
+} // namespace saki
@@ -0,0 +1,84 @@
+#ifndef SAKI_GEN_GB_H
+#define SAKI_GEN_GB_H
+
+#include "form_gb.h"
+#include "hand_enum.h"
+#include "rand.h"
+
+#include <bitset>
+#include <map>
+#include <vector>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief A generated GB-rule hand, the counterpart of Gen
+///
+class GenGb
+{
+public:
+    GenGb(const FormGb &form, const Hand &hand, const T37 &pick);
+
+public:
+    FormGb form;
+    Hand hand; ///< ready hand for dianpao, full hand for zimo
+    T37 pick;
+};
+
+
+
+///
+/// \brief Complete hands indexed by their GB fan total and fan kinds
+///
+/// The index is built once over a HandEnum table, after which every
+/// request is a uniform pick among the matching rows, instead of
+/// generating random hands until one hits. The table can be enumerated
+/// on the spot or come prebuilt, e.g. by HandEnum::read().
+///
+/// Only the shapes HandEnum covers are indexed: 4 melds + pair with
+/// chii/pon barks, 7 distinct pairs, and 13 orphans. GB-only forms such
+/// as quanbukao are not included. The scoring context (zimo/dianpao,
+/// winds) comes from the HandEnum::Options, and no hand is juezhang.
+///
+class FanIndex
+{
+public:
+    using FanSet = std::bitset<Fan::NUM_FANS>;
+
+    explicit FanIndex(const HandEnum::Options &opt, int threads = 0);
+    explicit FanIndex(HandEnum table, const HandEnum::Options &opt, int threads = 0);
+
+    FanIndex(const FanIndex &copy) = delete;
+    FanIndex &operator=(const FanIndex &assign) = delete;
+
+    GenGb genFan(Rand &rand, int fan) const;
+    GenGb genFans(Rand &rand, const FormGb::Fans &must) const;
+
+    size_t countFan(int fan) const;
+    size_t countFans(const FormGb::Fans &must) const;
+    size_t size() const;
+
+private:
+    std::vector<uint32_t> matchFans(const FormGb::Fans &must) const;
+    GenGb make(uint32_t row) const;
+
+private:
+    const HandEnum::Options mOpt;
+    HandEnum mTable;
+    std::vector<FanSet> mFanSets; ///< per row
+    std::map<int, std::vector<uint32_t>> mByFan;
+    std::vector<std::vector<uint32_t>> mByKind; ///< indexed by Fan
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_GEN_GB_H
@@ -0,0 +1,148 @@
+#include "gen_index.h"
+
+#include <tuple>
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+GenIndex::GenIndex(const RuleInfo &rule, size_t cap)
+    : mRule(rule)
+    , mCap(cap)
+{
+    assert(cap > 0);
+}
+
+///
+/// \brief Same as Gen::genForm4FuHan(), from the index
+///
+Gen GenIndex::genForm4FuHan(Rand &rand, int fu, int han, int selfWind, int roundWind, bool ron)
+{
+    assert(1 <= selfWind && selfWind <= 4);
+    assert(1 <= roundWind && roundWind <= 4);
+
+    if (fu == 110) {
+        assert(selfWind == roundWind);
+        return genForm4F110Han(rand, han, selfWind, ron);
+    }
+
+    Source source = fu >= 80 ? Source::HEAVY : Source::COMMON;
+    return take(rand, Key { source, fu, han, selfWind, roundWind, ron });
+}
+
+///
+/// \brief Same as Gen::genForm4Mangan(), from the index
+///
+Gen GenIndex::genForm4Mangan(Rand &rand, int han, int selfWind, int roundWind, bool ron)
+{
+    assert(1 <= selfWind && selfWind <= 4);
+    assert(1 <= roundWind && roundWind <= 4);
+
+    // fu does not matter above mangan, bucketed as 0
+    return take(rand, Key { Source::MANGAN, 0, han, selfWind, roundWind, ron });
+}
+
+///
+/// \brief Same as Gen::genForm4F110Han(), from the index
+///
+Gen GenIndex::genForm4F110Han(Rand &rand, int han, int selfWind, bool ron)
+{
+    return take(rand, Key { Source::F110, 110, han, selfWind, selfWind, ron });
+}
+
+///
+/// \brief Pre-build the common buckets, e.g. at loading time
+///
+void GenIndex::warm(Rand &rand, int selfWind, int roundWind, bool ron, int loops)
+{
+    for (int i = 0; i < loops; i++)
+        fill(rand, Source::COMMON, selfWind, roundWind, ron);
+}
+
+size_t GenIndex::bucketSize(int fu, int han, int selfWind, int roundWind, bool ron) const
+{
+    Source source = fu == 110 ? Source::F110 : fu >= 80 ? Source::HEAVY : Source::COMMON;
+    auto it = mBuckets.find(Key { source, fu, han, selfWind, roundWind, ron });
+    return it == mBuckets.end() ? 0 : it->second.gens.size();
+}
+
+bool GenIndex::Key::operator<(const Key &that) const
+{
+    return std::tie(source, fu, han, selfWind, roundWind, ron)
+            < std::tie(that.source, that.fu, that.han, that.selfWind, that.roundWind, that.ron);
+}
+
+Gen GenIndex::take(Rand &rand, const Key &key)
+{
+    auto it = mBuckets.find(key);
+    while (it == mBuckets.end()) {
+        fill(rand, key.source, key.selfWind, key.roundWind, key.ron);
+        it = mBuckets.find(key);
+    }
+
+    Bucket &bucket = it->second;
+    if (++bucket.takes >= bucket.gens.size()) {
+        bucket.takes = 0;
+        fill(rand, key.source, key.selfWind, key.roundWind, key.ron);
+    }
+
+    return bucket.gens[rand.gen(static_cast<int32_t>(bucket.gens.size()))];
+}
+
+///
+/// \brief Generate a round of hands the way 'source' does, keep them all
+///
+void GenIndex::fill(Rand &rand, Source source, int selfWind, int roundWind, bool ron)
+{
+    for (int i = 0; i < FILL_LOOPS; i++) {
+        switch (source) {
+        case Source::COMMON: {
+            Gen gen = Gen::genForm4(rand, 20, 10, 30, selfWind, roundWind, mRule, ron);
+            if (gen.form.fu() < 80 && gen.form.fu() != 110)
+                put(rand, Key { source, gen.form.fu(), gen.form.han(), selfWind, roundWind, ron }, gen);
+            break;
+        }
+        case Source::HEAVY: {
+            Gen gen = Gen::genForm4(rand, 60, 70, 2, selfWind, roundWind, mRule, ron);
+            if (gen.form.fu() >= 80 && gen.form.fu() != 110)
+                put(rand, Key { source, gen.form.fu(), gen.form.han(), selfWind, roundWind, ron }, gen);
+            break;
+        }
+        case Source::MANGAN: {
+            Gen gen = Gen::genForm4(rand, 20, 10, 5, selfWind, roundWind, mRule, ron);
+            if (gen.form.gain() >= 8000 && !gen.form.isPrototypalYakuman())
+                put(rand, Key { source, 0, gen.form.han(), selfWind, roundWind, ron }, gen);
+            break;
+        }
+        case Source::F110: {
+            Gen gen = Gen::genForm4F110Horse(rand, selfWind, mRule, ron);
+            if (gen.form.fu() == 110)
+                put(rand, Key { source, 110, gen.form.han(), selfWind, selfWind, ron }, gen);
+            break;
+        }
+        }
+    }
+}
+
+///
+/// \brief Keep 'gen' in its bucket, by reservoir sampling once the bucket is full
+///
+void GenIndex::put(Rand &rand, const Key &key, const Gen &gen)
+{
+    Bucket &bucket = mBuckets[key];
+    bucket.seen++;
+    if (bucket.gens.size() < mCap) {
+        bucket.gens.push_back(gen);
+    } else {
+        size_t pos = static_cast<size_t>(rand.gen(static_cast<int32_t>(bucket.seen)));
+        if (pos < mCap)
+            bucket.gens[pos] = gen;
+    }
+}
+
+
+} // namespace saki
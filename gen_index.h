@@ -0,0 +1,88 @@
+#ifndef SAKI_GEN_INDEX_H
+#define SAKI_GEN_INDEX_H
+
+#include "gen.h"
+
+#include <map>
+#include <vector>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Buckets of generated forms for direct sampling
+///
+/// The Gen::genForm4* functions reject random hands until one matches
+/// the target, throwing the others away. GenIndex keeps the hands it
+/// generates in buckets keyed by (generator, fu, han, ron/tsumo,
+/// self wind, round wind). A request is one uniform pick from its bucket.
+/// An empty bucket is generated for until it has an entry, and any other
+/// bucket gets one more round of generation per as many requests as it
+/// holds entries, so no bucket freezes. A round fills the neighboring
+/// buckets as well.
+///
+/// Past 'cap' entries, a bucket is a reservoir sample of every hand
+/// generated for it. Each result thus follows the distribution of the
+/// matching Gen function, but results close in time may repeat, as they
+/// are drawn from the same at most 'cap' hands.
+///
+class GenIndex
+{
+public:
+    explicit GenIndex(const RuleInfo &rule, size_t cap = 64);
+
+    GenIndex(const GenIndex &copy) = delete;
+    GenIndex &operator=(const GenIndex &assign) = delete;
+
+    Gen genForm4FuHan(Rand &rand, int fu, int han, int selfWind, int roundWind, bool ron);
+    Gen genForm4Mangan(Rand &rand, int han, int selfWind, int roundWind, bool ron);
+    Gen genForm4F110Han(Rand &rand, int han, int selfWind, bool ron);
+
+    void warm(Rand &rand, int selfWind, int roundWind, bool ron, int loops);
+
+    size_t bucketSize(int fu, int han, int selfWind, int roundWind, bool ron) const;
+
+private:
+    enum class Source { COMMON, HEAVY, MANGAN, F110 };
+
+    struct Key
+    {
+        Source source;
+        int fu;
+        int han;
+        int selfWind;
+        int roundWind;
+        bool ron;
+        bool operator<(const Key &that) const;
+    };
+
+    struct Bucket
+    {
+        std::vector<Gen> gens;
+        size_t seen = 0; ///< hands ever put, for reservoir sampling
+        size_t takes = 0; ///< takes since the last fill round
+    };
+
+    Gen take(Rand &rand, const Key &key);
+    void fill(Rand &rand, Source source, int selfWind, int roundWind, bool ron);
+    void put(Rand &rand, const Key &key, const Gen &gen);
+
+private:
+    static const int FILL_LOOPS = 64;
+
+    const RuleInfo mRule;
+    const size_t mCap;
+    std::map<Key, Bucket> mBuckets;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_GEN_INDEX_H
@@ -58,15 +58,17 @@ Girl *Girl::clone() const
     return new Girl(*this);
 }
 
-Girl::Girl(Who who, Id id)
+Girl::Girl(Who who, Id id, const Hooks &hooks)
     : mSelf(who)
     , mId(id)
+    , mHooks(hooks)
 {
 }
 
 Girl::Girl(const Girl &copy)
     : mSelf(copy.mSelf)
     , mId(copy.mId)
+    , mHooks(copy.mHooks)
 {
 }
 
@@ -75,6 +77,11 @@ Girl::Id Girl::getId() const
     return mId;
 }
 
+const Girl::Hooks &Girl::hooks() const
+{
+    return mHooks;
+}
+
 void Girl::onDice(Rand &rand, const Table &table, Choices &choices)
 {
     (void) rand; (void) table; (void) choices;
@@ -179,8 +186,11 @@ void Girl::accelerate(Mount &mount, const Hand &hand, const util::Stactor<T37, 2
     // in order to enable user-controled advance direction
     eraseRivered(effs, river);
 
+    std::array<int, 34> deltas {};
     for (T34 t : effs)
-        mount.lightA(t, delta);
+        deltas[t.id34()] = delta;
+
+    mount.powerBatch(Mount::WALL, 0, deltas, false);
 }
 
 
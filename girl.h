@@ -7,14 +7,16 @@
 #include "choices.h"
 
 #include <bitset>
+#include <type_traits>
 
 
 
 #define GIRL_CTORS(Name) \
-    Name(Who who, Id id) : Girl(who, id) { }; \
+    Name(Who who, Id id) : Girl(who, id, hooksOf<Name>()) { }; \
     Name(const Name &copy) = default; \
     Name *clone() const override { return new Name(*this); }
 
+// a hand-written ctor should pass 'hooksOf<Name>()' to Girl's ctor
 #define GIRL_CTORS_CLONE_ONLY(Name) \
     Name(const Name &copy) = default; \
     Name *clone() const override { return new Name(*this); }
@@ -77,12 +79,25 @@ public:
         NUM_NM_SKILL
     };
 
+    ///
+    /// \brief Table events that reach a girl only if she overrides them
+    ///
+    enum Hook
+    {
+        ON_DICE, ON_ACTIVATE, ON_INBOX, ON_DRAW, ON_CHOOSE_FIRST_DEALER,
+        ON_DISCARDED, ON_RIICHI_ESTABLISHED, ON_ROUND_ENDED,
+        NUM_HOOKS
+    };
+
+    using Hooks = std::bitset<NUM_HOOKS>;
+
     static Girl *create(Who who, int id);
     virtual Girl *clone() const;
     virtual ~Girl() = default;
     Girl &operator=(const Girl &assign) = delete;
 
     Id getId() const;
+    const Hooks &hooks() const;
 
     virtual void onDice(Rand &rand, const Table &table, Choices &choices);
     virtual void onMonkey(std::array<Exist, 4> &exists, const Princess &princess);
@@ -110,9 +125,30 @@ public:
     virtual std::string popUpStr() const;
 
 protected:
-    Girl(Who who, Id id);
+    Girl(Who who, Id id, const Hooks &hooks = Hooks());
     Girl(const Girl &copy);
 
+    ///
+    /// \brief Hooks that 'G' overrides, decided at compile time
+    ///
+    /// '&G::onDraw' has type 'void (Girl::*)(...)' unless G or one of its
+    /// bases under Girl declares its own onDraw().
+    ///
+    template<typename G>
+    static Hooks hooksOf()
+    {
+        Hooks res;
+        res[ON_DICE] = overrides(&G::onDice);
+        res[ON_ACTIVATE] = overrides(&G::onActivate);
+        res[ON_INBOX] = overrides(&G::onInbox);
+        res[ON_DRAW] = overrides(&G::onDraw);
+        res[ON_CHOOSE_FIRST_DEALER] = overrides(&G::onChooseFirstDealer);
+        res[ON_DISCARDED] = overrides(&G::onDiscarded);
+        res[ON_RIICHI_ESTABLISHED] = overrides(&G::onRiichiEstablished);
+        res[ON_ROUND_ENDED] = overrides(&G::onRoundEnded);
+        return res;
+    }
+
     static void eraseRivered(util::Stactor<T34, 34> &ts, const util::Stactor<T37, 24> &river);
     static void eraseRivered(std::bitset<34> &ts, const util::Stactor<T37, 24> &river);
     void accelerate(Mount &mount, const Hand &hand, const util::Stactor<T37, 24> &river, int delta);
@@ -120,6 +156,16 @@ protected:
 protected:
     const Who mSelf;
     const Id mId;
+
+private:
+    template<typename C, typename F>
+    static constexpr bool overrides(F C::*)
+    {
+        return !std::is_same<C, Girl>::value;
+    }
+
+private:
+    const Hooks mHooks;
 };
 
 
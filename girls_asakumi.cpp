@@ -151,8 +151,10 @@ void Shino::powerIipei(const Hand &hand, const util::Stactor<T37, 24> &river,
     }
 
     eraseRivered(drags, river);
+    std::array<int, 34> deltas;
     for (int ti = 0; ti < 34; ti++)
-        mount.lightA(T34(ti), drags.test(ti) ? posMk : negMk);
+        deltas[ti] = drags.test(ti) ? posMk : negMk;
+    mount.powerBatch(Mount::WALL, 0, deltas, false);
 }
 
 bool Shino::power3sk(const Hand &hand, Mount &mount, int posMk, int negMk)
@@ -186,8 +188,10 @@ bool Shino::power3sk(const Hand &hand, Mount &mount, int posMk, int negMk)
         }
     }
 
+    std::array<int, 34> deltas;
     for (int ti = 0; ti < 34; ti++)
-        mount.lightA(T34(ti), powerSsk.test(ti) ? posMk : negMk);
+        deltas[ti] = powerSsk.test(ti) ? posMk : negMk;
+    mount.powerBatch(Mount::WALL, 0, deltas, false);
 
     return maxSum == 9;
 }
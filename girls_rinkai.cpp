@@ -35,9 +35,12 @@ void Huiyu::skill(Mount &mount, const Hand &hand, const PointInfo &info)
         for (const T37 &t : m.tiles())
             total.inc(t, 1);
 
-    if (expand(mount, total)) // expand done, drag eff
+    if (expand(mount, total)) { // expand done, drag eff
+        std::array<int, 34> deltas {};
         for (T34 t : hand.effA())
-            mount.lightA(t, 200);
+            deltas[t.id34()] = 200;
+        mount.powerBatch(Mount::WALL, 0, deltas, false);
+    }
 }
 
 void Huiyu::onActivate(const Table &table, Choices &choices)
@@ -45,16 +48,15 @@ void Huiyu::onActivate(const Table &table, Choices &choices)
     auto filterDrawn = [&]() {
         Choices::ModeDrawn drawn = choices.drawn();
 
-        if (drawn.tsumo) {
+        if (drawn.tsumo()) {
             const Hand &hand = table.getHand(mSelf);
             bool juezhang = table.riverRemain(hand.drawn()) == 0;
             FormGb f(hand, table.getPointInfo(mSelf), juezhang);
             if (f.fan() < 8)
-                drawn.tsumo = false;
+                drawn.banTsumo();
         }
 
-        drawn.spinRiichi = false;
-        drawn.swapRiichis.clear();
+        drawn.banRiichi();
 
         choices.setDrawn(drawn);
     };
@@ -113,9 +115,12 @@ bool Huiyu::expand(Mount &mount, const TileCount &total)
     update(gtlt5, 6);
 
     assert(minDist >= 0);
-    if (0 < minDist && minDist < 14)
+    if (0 < minDist && minDist < 14) {
+        std::array<int, 34> deltas;
         for (int ti = 0; ti < 34; ti++)
-            mount.lightA(T34(ti), minReqs.test(ti) ? 100 : -10);
+            deltas[ti] = minReqs.test(ti) ? 100 : -10;
+        mount.powerBatch(Mount::WALL, 0, deltas, false);
+    }
 
     return minDist == 0;
 }
@@ -144,14 +144,13 @@ void Sera::onDraw(const Table &table, Mount &mount, Who who, bool rinshan)
     const RuleInfo &rule = table.getRuleInfo();
     const auto &drids = mount.getDrids();
     if (hand.ready()) {
-        for (T34 t : hand.effA()) {
-            Form f(hand, T37(t.id34()), info, rule, drids);
-            int ronHan = f.han();
+        for (const Form::WaitScore &ws : Form::scoreWaits(hand, info, rule, drids)) {
+            int ronHan = ws.ron.han();
             int tsumoHan = hand.isMenzen() ? ronHan + 1 : ronHan;
-            bool pinfu = f.yakus().test(Yaku::PF);
+            bool pinfu = ws.ron.yakus().test(Yaku::PF);
             bool ok = tsumoHan >= (4 + pinfu);
             bool modest = tsumoHan <= 7;
-            mount.lightA(t, ok ? (modest ? 400 : 100) : -200);
+            mount.lightA(ws.pick, ok ? (modest ? 400 : 100) : -200);
         }
     } else {
         accelerate(mount, hand, table.getRiver(mSelf), 30);
@@ -3,7 +3,7 @@
 #include "ai.h"
 #include "string_enum.h"
 
-#include <sstream>
+#include <ostream>
 
 
 
@@ -12,6 +12,73 @@ namespace saki
 
 
 
+namespace
+{
+
+///
+/// \brief Stream buffer into a fixed char array, truncating like snprintf
+///
+/// Drops the first 'skip' chars and counts the rest even if they do not fit.
+///
+class FixedBuf : public std::streambuf
+{
+public:
+    FixedBuf(char *buf, size_t size, size_t skip)
+        : mBuf(buf)
+        , mSize(size)
+        , mSkip(skip)
+    {
+    }
+
+    ///
+    /// \brief Terminate the text and return its untruncated length
+    ///
+    size_t end()
+    {
+        if (mSize > 0)
+            mBuf[mLen < mSize ? mLen : mSize - 1] = '\0';
+        return mLen;
+    }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+            put(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        for (std::streamsize i = 0; i < n; i++)
+            put(s[i]);
+        return n;
+    }
+
+private:
+    void put(char c)
+    {
+        if (mSkip > 0) {
+            mSkip--;
+            return;
+        }
+
+        if (mLen + 1 < mSize)
+            mBuf[mLen] = c;
+        mLen++;
+    }
+
+private:
+    char *mBuf;
+    size_t mSize;
+    size_t mSkip;
+    size_t mLen = 0;
+};
+
+} // namespace
+
+
+
 TokiEvents::TokiEvents(const TokiEvents &copy)
 {
     for (const std::unique_ptr<TokiEvent> &p : copy.events)
@@ -30,26 +97,39 @@ void TokiEvents::emplace_back(TokiEvent *event)
 }
 
 std::string TokiEvents::str(Who toki) const
+{
+    // measure, then write in place
+    std::string res(str(nullptr, 0, toki), '\0');
+    str(&res[0], res.size() + 1, toki);
+    return res;
+}
+
+///
+/// \brief Write str() into 'buf' without allocating
+/// \return Length of the whole text, truncated if not less than 'size'
+///
+size_t TokiEvents::str(char *buf, size_t size, Who toki) const
 {
     bool inDiscardStream = false;
 
-    std::ostringstream oss;
+    FixedBuf fixed(buf, size, 1); // eliminate first '\n'
+    std::ostream os(&fixed);
 
     for (const auto &p : events) {
         const TokiEvent &e = *p;
         if (e.isDiscard()) {
             if (!inDiscardStream) {
-                oss << "\nDISCARD";
+                os << "\nDISCARD";
                 inDiscardStream = true;
             }
         } else {
             inDiscardStream = false;
         }
 
-        e.print(oss, toki);
+        e.print(os, toki);
     }
 
-    return oss.str().substr(1); // eliminate first '\n'
+    return fixed.end();
 }
 
 bool TokiEvent::isDiscard() const
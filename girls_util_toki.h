@@ -33,6 +33,7 @@ struct TokiEvents
     TokiEvents &operator=(TokiEvents assign);
     void emplace_back(TokiEvent *event);
     std::string str(Who toki) const;
+    size_t str(char *buf, size_t size, Who toki) const;
     std::vector<std::unique_ptr<TokiEvent>> events;
 };
 
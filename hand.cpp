@@ -159,7 +159,7 @@ bool Hand::canChiiAsLeft(T34 t) const
 
 bool Hand::canChiiAsMiddle(T34 t) const
 {
-    if (t.isZ() || t.val() == 1 || t.val() == 9)
+    if (t.isYao())
         return false;
 
     if (!(mClosed.ct(t.prev()) > 0 && mClosed.ct(t.next()) > 0))
@@ -192,6 +192,29 @@ bool Hand::canCp(T34 pick, const Action &action) const
 {
     using AC = ActCode;
 
+    switch (action.act()) {
+    case AC::CHII_AS_LEFT:
+        return canChiiAsLeft(pick) && canCpOut(pick, action);
+    case AC::CHII_AS_MIDDLE:
+        return canChiiAsMiddle(pick) && canCpOut(pick, action);
+    case AC::CHII_AS_RIGHT:
+        return canChiiAsRight(pick) && canCpOut(pick, action);
+    case AC::PON:
+        return canPon(pick) && canCpOut(pick, action);
+    default:
+        unreached("Hand::canCp");
+    }
+}
+
+///
+/// \brief The part of canCp() about the out tile, assuming the call itself is ok
+///
+/// Useful to check the call once and the out tiles many times.
+///
+bool Hand::canCpOut(T34 pick, const Action &action) const
+{
+    using AC = ActCode;
+
     const T37 &out = action.t37();
     if (out == pick)
         return false;
@@ -202,28 +225,20 @@ bool Hand::canCp(T34 pick, const Action &action) const
 
     switch (action.act()) {
     case AC::CHII_AS_LEFT:
-        if (!canChiiAsLeft(pick))
-            return false;
         kuikae = (pick ^ out);
         needShow = ((pick | out) || (pick || out)) && tension;
         break;
     case AC::CHII_AS_MIDDLE:
-        if (!canChiiAsMiddle(pick))
-            return false;
         needShow = ((out | pick) || (pick | out)) && tension;
         break;
     case AC::CHII_AS_RIGHT:
-        if (!canChiiAsRight(pick))
-            return false;
         kuikae = (out ^ pick);
         needShow = ((out || pick) || (out | pick)) && tension;
         break;
     case AC::PON:
-        if (!canPon(pick))
-            return false;
         break;
     default:
-        unreached("Hand::canCp");
+        unreached("Hand::canCpOut");
     }
 
     return !kuikae && mClosed.ct(out) >= (needShow ? 2 : 1);
@@ -277,7 +292,7 @@ bool Hand::canRon(T34 t, const PointInfo &info, const RuleInfo &rule, bool &douj
 {
     assert(!mHasDrawn);
 
-    if (mClosed.peekDraw(t, &TileCount::step, static_cast<int>(mBarks.size())) != -1)
+    if (!((waitMask() >> t.id34()) & 1))
         return false;
 
     T37 pick(t.id34()); // whether aka5 does not affect ronnablity
@@ -315,10 +330,24 @@ bool Hand::canRiichi(util::Stactor<T37, 13> &swappables, bool &spinnable) const
 
 bool Hand::ready() const
 {
+    if (!mHasDrawn)
+        return waits().ready;
+
     return step7() == 0 || step13() == 0
             || (step4() == 0 && util::any(effA(), [this](T34 t) { return ct(t) < 4; }));
 }
 
+///
+/// \brief Tiles completing the closed part, drawn excluded, as bits of id34
+///
+/// Cached until the closed part or the barks change, thus a ron check
+/// on a non-winning tile costs one bit test.
+///
+uint64_t Hand::waitMask() const
+{
+    return waits().mask;
+}
+
 int Hand::step() const
 {
     return peekStay(&TileCount::step, mBarks.size());
@@ -390,12 +419,9 @@ int Hand::estimate(const RuleInfo &rule, int sw, int rw, const util::Stactor<T37
     info.roundWind = rw;
 
     int max = 0;
-    for (T34 t : effA()) {
-        T37 pick(t.id34());
-        Form form(*this, pick, info, rule, drids);
-        if (form.hasYaku())
-            max = std::max(max, form.gain());
-    }
+    for (const Form::WaitScore &ws : Form::scoreWaits(*this, info, rule, drids))
+        if (ws.ron.hasYaku())
+            max = std::max(max, ws.ron.gain());
 
     return max;
 }
@@ -434,6 +460,7 @@ void Hand::swapOut(const T37 &out)
     mClosed.inc(out, -1);
     mClosed.inc(mDrawn, 1);
     mHasDrawn = false;
+    changed();
 }
 
 void Hand::spinOut()
@@ -447,6 +474,7 @@ void Hand::barkOut(const T37 &out)
     assert(mClosed.ct(out) > 0);
     assert(!mHasDrawn);
     mClosed.inc(out, -1);
+    changed();
 }
 
 void Hand::chiiAsLeft(const T37 &pick, bool showAka5)
@@ -521,6 +549,7 @@ void Hand::ankan(T34 t)
     if (!useDrawn)
         mClosed.inc(mDrawn, 1);
     mHasDrawn = false;
+    changed();
 
     mBarks.pushBack(M37::ankan(one, two, three, four));
 }
@@ -540,6 +569,7 @@ void Hand::kakan(int barkId)
     }
 
     mHasDrawn = false;
+    changed();
 
     mBarks[barkId].kakan(t);
 }
@@ -579,6 +609,7 @@ T37 Hand::tryShow(T34 t34, bool showAka5)
 
     assert(mClosed.ct(t37) > 0);
     mClosed.inc(t37, -1);
+    changed();
 
     return t37;
 }
@@ -594,6 +625,39 @@ util::Stactor<T37, 13> Hand::makeChoices(SwapOk ok) const
     return choices;
 }
 
+const Hand::WaitCache &Hand::waits() const
+{
+    if (mWaits.valid)
+        return mWaits;
+
+    int barkCt = static_cast<int>(mBarks.size());
+    int s4 = mClosed.step4(barkCt);
+    int s7 = mClosed.step7();
+    int s13 = mClosed.step13();
+
+    mWaits.mask = 0;
+    bool unheld = false;
+    if (std::min(s4, std::min(s7, s13)) == 0) {
+        for (T34 t : mClosed.effA(barkCt)) {
+            mWaits.mask |= uint64_t(1) << t.id34();
+            // ct() without the drawn, as if this were a 13-tile hand
+            unheld = unheld || ct(t) - (mHasDrawn && mDrawn == t) < 4;
+        }
+    }
+
+    mWaits.ready = s7 == 0 || s13 == 0 || (s4 == 0 && unheld);
+    mWaits.valid = true;
+    return mWaits;
+}
+
+///
+/// \brief Drop caches depending on mClosed or mBarks
+///
+void Hand::changed()
+{
+    mWaits.valid = false;
+}
+
 
 
 Hand::DeltaSpin::DeltaSpin(Hand &hand)
@@ -612,6 +676,7 @@ Hand::DeltaSpin::~DeltaSpin()
 Hand::DeltaSwap::DeltaSwap(Hand &hand, const T37 &out)
     : mHand(hand)
     , mOut(out)
+    , mSaved(hand.mWaits)
 {
     mHand.swapOut(out);
 }
@@ -621,11 +686,13 @@ Hand::DeltaSwap::~DeltaSwap()
     mHand.mHasDrawn = true;
     mHand.mClosed.inc(mHand.mDrawn, -1);
     mHand.mClosed.inc(mOut, 1);
+    mHand.mWaits = mSaved;
 }
 
 Hand::DeltaCp::DeltaCp(Hand &hand, const T37 &pick, const Action &a, const T37 &out)
     : mHand(hand)
     , mOut(out)
+    , mSaved(hand.mWaits)
 {
     switch (a.act()) {
     case ActCode::CHII_AS_LEFT:
@@ -657,6 +724,7 @@ Hand::DeltaCp::~DeltaCp()
             mHand.mClosed.inc(cp[i], 1);
 
     mHand.mBarks.popBack();
+    mHand.mWaits = mSaved;
 }
 
 
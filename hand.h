@@ -17,6 +17,14 @@ namespace saki
 
 
 
+///
+/// \brief Closed tiles, the drawn tile and barks of a player
+///
+/// Const queries like ready() and waitMask() fill a mutable cache, so a
+/// hand is not safe to read from several threads at once. Threads that
+/// start from a shared hand, such as rollout forks, should each query
+/// a copy of it.
+///
 class Hand
 {
 public:
@@ -52,6 +60,7 @@ public:
     bool canChiiAsRight(T34 t) const;
     bool canPon(T34 t) const;
     bool canCp(T34 pick, const Action &action) const;
+    bool canCpOut(T34 pick, const Action &action) const;
     bool canDaiminkan(T34 t) const;
     bool canAnkan(util::Stactor<T34, 3> &choices, bool riichi) const;
     bool canKakan(util::Stactor<int, 3> &barkIds) const;
@@ -60,6 +69,7 @@ public:
     bool canRiichi(util::Stactor<T37, 13> &swappables, bool &spinnable) const;
 
     bool ready() const;
+    uint64_t waitMask() const;
     int step() const;
     int stepGb() const;
     int step4() const;
@@ -147,6 +157,16 @@ private:
         Hand &mHand;
     };
 
+    ///
+    /// \brief Waits of mClosed, the drawn tile not counted
+    ///
+    struct WaitCache
+    {
+        uint64_t mask = 0; ///< bit id34 set if the tile completes mClosed
+        bool ready = false; ///< ready() when nothing is drawn
+        bool valid = false;
+    };
+
     class DeltaSwap
     {
     public:
@@ -159,6 +179,7 @@ private:
     private:
         Hand &mHand;
         const T37 &mOut;
+        WaitCache mSaved;
     };
 
     class DeltaCp
@@ -173,10 +194,14 @@ private:
     private:
         Hand &mHand;
         const T37 &mOut;
+        WaitCache mSaved;
     };
 
     using SwapOk = std::function<bool(T34)>;
 
+    const WaitCache &waits() const;
+    void changed();
+
     bool hasSwappableAfterChii(T34 mat1, T34 mat2, SwapOk ok) const;
     bool shouldShowAka5(T34 show, bool showAka5) const;
     T37 tryShow(T34 t, bool showAka5);
@@ -194,6 +219,7 @@ private:
     T37 mDrawn;
     bool mHasDrawn = false;
     util::Stactor<M37, 4> mBarks;
+    mutable WaitCache mWaits; // refreshed on demand after changed()
 };
 
 int operator%(T34 ind, const Hand &hand);
@@ -0,0 +1,556 @@
+#include "hand_enum.h"
+#include "form_gb.h"
+#include "util_parallel.h"
+
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+// HAND ENUM FILE
+//
+// little-endian, no padding
+//
+// u32 magic "SKHE"
+// u32 version (1)
+// u32 row count (n)
+// column data, each column contiguous, in this order:
+//     i8[n]      types
+//     u8[n * 7]  shapes
+//     i8[n]      picks
+//     i8[n]      fus
+//     i8[n]      hans
+//     i16[n]     fans
+
+
+
+namespace saki
+{
+
+
+
+namespace
+{
+
+const uint32_t MAGIC = 0x45484b53; // "SKHE"
+const uint32_t VERSION = 1;
+
+using Counts = std::array<int, 34>;
+
+void writeU32(std::ostream &os, uint32_t u)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = static_cast<char>((u >> (8 * i)) & 0xff);
+    os.write(buf, 4);
+}
+
+bool readU32(std::istream &is, uint32_t &u)
+{
+    unsigned char buf[4];
+    if (!is.read(reinterpret_cast<char*>(buf), 4))
+        return false;
+    u = 0;
+    for (int i = 0; i < 4; i++)
+        u |= static_cast<uint32_t>(buf[i]) << (8 * i);
+    return true;
+}
+
+template<typename T>
+void writeColumn(std::ostream &os, const std::vector<T> &col)
+{
+    static_assert(sizeof(T) <= 2, "only byte and short columns");
+    if (sizeof(T) == 1) {
+        os.write(reinterpret_cast<const char*>(col.data()), col.size());
+    } else {
+        for (T v : col) {
+            auto u = static_cast<uint16_t>(v);
+            char buf[2] = { static_cast<char>(u & 0xff), static_cast<char>(u >> 8) };
+            os.write(buf, 2);
+        }
+    }
+}
+
+template<typename T>
+bool readColumn(std::istream &is, std::vector<T> &col, size_t n)
+{
+    static_assert(sizeof(T) <= 2, "only byte and short columns");
+    col.resize(n);
+    if (sizeof(T) == 1)
+        return static_cast<bool>(is.read(reinterpret_cast<char*>(col.data()), n));
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char buf[2];
+        if (!is.read(reinterpret_cast<char*>(buf), 2))
+            return false;
+        col[i] = static_cast<T>(static_cast<uint16_t>(buf[0] | (buf[1] << 8)));
+    }
+
+    return true;
+}
+
+template<typename T>
+void appendColumn(std::vector<T> &dst, const std::vector<T> &src)
+{
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+bool allowed(unsigned suits, int id34)
+{
+    return (suits >> static_cast<int>(T34(id34).suit())) & 1;
+}
+
+///
+/// \brief Add 'delta' copies of meld 'code' to 'ct'
+/// \return false if some count went out of [0, 4] or a tile is not allowed
+///
+bool addMeld(Counts &ct, uint8_t code, int delta, unsigned suits)
+{
+    T34 head = HandEnum::meldHead(code);
+    if (!allowed(suits, head.id34()))
+        return false;
+
+    bool ok = true;
+    auto add = [&](int id34, int d) {
+        ct[id34] += d;
+        ok = ok && 0 <= ct[id34] && ct[id34] <= 4;
+    };
+
+    if (code < HandEnum::SEQ) {
+        add(head.id34(), 3 * delta);
+    } else {
+        for (int i = 0; i < 3; i++)
+            add(head.id34() + i, delta);
+    }
+
+    return ok;
+}
+
+///
+/// \brief Cut 'melds' melds, always taking the smallest remaining tile,
+///        triplets before sequences
+/// \return false if 'ct' cannot be cut into melds
+///
+bool cutFirst(Counts &ct, int melds, uint8_t *out)
+{
+    if (melds == 0)
+        return true;
+
+    int i = 0;
+    while (ct[i] == 0)
+        i++;
+
+    if (ct[i] >= 3) {
+        ct[i] -= 3;
+        out[0] = static_cast<uint8_t>(i);
+        bool ok = cutFirst(ct, melds - 1, out + 1);
+        ct[i] += 3;
+        if (ok)
+            return true;
+    }
+
+    if (i < 27 && i % 9 <= 6 && ct[i + 1] > 0 && ct[i + 2] > 0) {
+        ct[i]--;
+        ct[i + 1]--;
+        ct[i + 2]--;
+        out[0] = static_cast<uint8_t>(HandEnum::SEQ + (i / 9) * 7 + i % 9);
+        bool ok = cutFirst(ct, melds - 1, out + 1);
+        ct[i]++;
+        ct[i + 1]++;
+        ct[i + 2]++;
+        if (ok)
+            return true;
+    }
+
+    return false;
+}
+
+///
+/// \brief Check if (pair, melds) is the first decomposition of its tiles
+///
+/// The first decomposition takes the smallest possible pair, then
+/// follows cutFirst(). Exactly one decomposition per tile set passes.
+///
+bool isCanonical(Counts ct, int pair, const uint8_t *melds, int meldCt)
+{
+    for (int p = 0; p < pair; p++) {
+        if (ct[p] >= 2) {
+            ct[p] -= 2;
+            uint8_t out[4];
+            bool ok = cutFirst(ct, meldCt, out);
+            ct[p] += 2;
+            if (ok)
+                return false;
+        }
+    }
+
+    ct[pair] -= 2;
+    uint8_t out[4];
+    bool ok = cutFirst(ct, meldCt, out);
+    assert(ok);
+    (void) ok;
+    assert(0 <= meldCt && meldCt <= 4);
+    for (int i = 1; i < meldCt; i++) // insertion sort, at most 4 melds
+        for (int j = i; j > 0 && out[j] < out[j - 1]; j--)
+            std::swap(out[j], out[j - 1]);
+    return std::equal(out, out + meldCt, melds);
+}
+
+} // namespace
+
+
+
+///
+/// \brief Enumerate all hands allowed by 'opt' on 'threads' workers
+///
+/// Tasks are (pair, first meld) for 4-meld forms, smallest pair for
+/// 7-pairs, and one for 13-orphans. Their costs are uneven, thus workers
+/// steal from each other. Row order is the same as a single-threaded run.
+///
+HandEnum HandEnum::run(const Options &opt, int threads)
+{
+    std::vector<HandEnum> parts(taskCount());
+
+    util::parallelForStealing(parts.size(), threads, [&opt, &parts](size_t i) {
+        parts[i].runTask(opt, i);
+    });
+
+    HandEnum res;
+    for (const HandEnum &part : parts)
+        res.append(part);
+
+    return res;
+}
+
+size_t HandEnum::size() const
+{
+    return types.size();
+}
+
+void HandEnum::append(const HandEnum &other)
+{
+    appendColumn(types, other.types);
+    appendColumn(shapes, other.shapes);
+    appendColumn(picks, other.picks);
+    appendColumn(fus, other.fus);
+    appendColumn(hans, other.hans);
+    appendColumn(fans, other.fans);
+}
+
+///
+/// \brief Rebuild the 13-tile hand of a row, without the pick
+///
+Hand HandEnum::ready(size_t row) const
+{
+    const uint8_t *shape = &shapes[row * SHAPE_LEN];
+    auto type = static_cast<Form::Type>(types[row]);
+    TileCount closed = closedOf(type, shape);
+    closed.inc(T37(picks[row]), -1);
+
+    util::Stactor<M37, 4> barks;
+    if (type == Form::Type::F4) {
+        for (int m = 1; m <= 4; m++) {
+            if (!(shape[m] & OPEN))
+                continue;
+            auto code = static_cast<uint8_t>(shape[m] & ~OPEN);
+            int h = meldHead(code).id34();
+            barks.pushBack(code >= SEQ ? M37::chii(T37(h), T37(h + 1), T37(h + 2), 0)
+                                       : M37::pon(T37(h), T37(h), T37(h), 0));
+        }
+    }
+
+    return Hand(closed, barks);
+}
+
+void HandEnum::write(std::ostream &os) const
+{
+    writeU32(os, MAGIC);
+    writeU32(os, VERSION);
+    writeU32(os, static_cast<uint32_t>(size()));
+
+    writeColumn(os, types);
+    writeColumn(os, shapes);
+    writeColumn(os, picks);
+    writeColumn(os, fus);
+    writeColumn(os, hans);
+    writeColumn(os, fans);
+}
+
+///
+/// \brief Replace the content by an enum file
+/// \return false if the stream is not a readable enum file
+///
+bool HandEnum::read(std::istream &is)
+{
+    uint32_t magic, version, n;
+    if (!readU32(is, magic) || magic != MAGIC)
+        return false;
+    if (!readU32(is, version) || version != VERSION)
+        return false;
+    if (!readU32(is, n))
+        return false;
+
+    return readColumn(is, types, n)
+            && readColumn(is, shapes, n * SHAPE_LEN)
+            && readColumn(is, picks, n)
+            && readColumn(is, fus, n)
+            && readColumn(is, hans, n)
+            && readColumn(is, fans, n);
+}
+
+///
+/// \brief Smallest tile of a meld code, the OPEN bit must be cleared
+///
+T34 HandEnum::meldHead(uint8_t code)
+{
+    assert(code < MELDS);
+    if (code < SEQ)
+        return T34(code);
+
+    int s = (code - SEQ) / 7;
+    int v = (code - SEQ) % 7 + 1;
+    return T34(Suit(s), v);
+}
+
+size_t HandEnum::taskCount()
+{
+    return 34 * MELDS + 34 + 1;
+}
+
+void HandEnum::runTask(const Options &opt, size_t task)
+{
+    const size_t tasks4 = 34 * MELDS;
+    if (task < tasks4) {
+        if (opt.form4)
+            runTask4(opt, static_cast<int>(task / MELDS), static_cast<int>(task % MELDS));
+    } else if (task < tasks4 + 34) {
+        if (opt.form7)
+            runTask7(opt, static_cast<int>(task - tasks4));
+    } else {
+        if (opt.form13)
+            runTask13(opt);
+    }
+}
+
+///
+/// \brief All 4-meld hands with the given pair and smallest meld
+///
+/// Melds are chosen as a non-decreasing sequence, then every subset
+/// of them small enough may become barks. A closed part with several
+/// decompositions is only emitted for its canonical one.
+///
+void HandEnum::runTask4(const Options &opt, int pair, int first)
+{
+    if (!allowed(opt.suits, pair))
+        return;
+
+    Counts ct;
+    ct.fill(0);
+    ct[pair] = 2;
+
+    uint8_t melds[4];
+    melds[0] = static_cast<uint8_t>(first);
+    if (!addMeld(ct, melds[0], 1, opt.suits))
+        return;
+
+    auto leaf = [&]() {
+        for (unsigned mask = 0; mask < 16; mask++) {
+            int barkCt = 0;
+            bool ordered = true;
+            for (int m = 0; m < 4; m++) {
+                bool open = (mask >> m) & 1;
+                barkCt += open;
+                // among same melds, barks come first
+                if (m > 0 && open && melds[m] == melds[m - 1] && !((mask >> (m - 1)) & 1))
+                    ordered = false;
+            }
+
+            if (!ordered || barkCt > opt.maxBarks)
+                continue;
+
+            Counts closed(ct);
+            uint8_t closedMelds[4];
+            int closedCt = 0;
+            for (int m = 0; m < 4; m++) {
+                if ((mask >> m) & 1)
+                    addMeld(closed, melds[m], -1, opt.suits);
+                else
+                    closedMelds[closedCt++] = melds[m];
+            }
+
+            if (!isCanonical(closed, pair, closedMelds, closedCt))
+                continue;
+
+            uint8_t shape[SHAPE_LEN];
+            shape[0] = static_cast<uint8_t>(pair);
+            for (int m = 0; m < 4; m++)
+                shape[m + 1] = static_cast<uint8_t>(melds[m] | (((mask >> m) & 1) ? OPEN : 0));
+            shape[5] = shape[6] = NONE;
+            emit(opt, Form::Type::F4, shape);
+        }
+    };
+
+    std::function<void(int)> dfs = [&](int m) {
+        if (m == 4) {
+            leaf();
+            return;
+        }
+
+        for (int code = melds[m - 1]; code < MELDS; code++) {
+            melds[m] = static_cast<uint8_t>(code);
+            if (addMeld(ct, melds[m], 1, opt.suits))
+                dfs(m + 1);
+            addMeld(ct, melds[m], -1, opt.suits);
+        }
+    };
+
+    dfs(1);
+}
+
+///
+/// \brief All 7-pairs hands with the given smallest pair
+///
+/// Hands also having a 4-meld form are left to runTask4(),
+/// as Form scores them as 4-meld hands.
+///
+void HandEnum::runTask7(const Options &opt, int first)
+{
+    if (!allowed(opt.suits, first))
+        return;
+
+    uint8_t shape[SHAPE_LEN];
+    shape[0] = static_cast<uint8_t>(first);
+
+    std::function<void(int, int)> dfs = [&](int k, int from) {
+        if (k == SHAPE_LEN) {
+            if (opt.form4) {
+                TileCount count;
+                for (int i = 0; i < SHAPE_LEN; i++)
+                    count.inc(T37(shape[i]), 2);
+                if (count.step4(0) == -1)
+                    return;
+            }
+
+            emit(opt, Form::Type::F7, shape);
+            return;
+        }
+
+        for (int ti = from; ti + (SHAPE_LEN - k) <= 34; ti++) {
+            if (!allowed(opt.suits, ti))
+                continue;
+            shape[k] = static_cast<uint8_t>(ti);
+            dfs(k + 1, ti + 1);
+        }
+    };
+
+    dfs(1, first + 1);
+}
+
+void HandEnum::runTask13(const Options &opt)
+{
+    for (int ti = 0; ti < 34; ti++) {
+        if (!T34(ti).isYao() || !allowed(opt.suits, ti))
+            continue;
+
+        uint8_t shape[SHAPE_LEN];
+        std::fill(shape, shape + SHAPE_LEN, NONE);
+        shape[0] = static_cast<uint8_t>(ti);
+        emit(opt, Form::Type::F13, shape);
+    }
+}
+
+///
+/// \brief Append one row per distinct closed tile of 'shape' as the pick
+///
+void HandEnum::emit(const Options &opt, Form::Type type, const uint8_t *shape)
+{
+    if (type == Form::Type::F13) {
+        // every orphan kind is needed
+        for (int ti = 0; ti < 34; ti++)
+            if (T34(ti).isYao() && !allowed(opt.suits, ti))
+                return;
+    }
+
+    TileCount closed = closedOf(type, shape);
+
+    PointInfo info;
+    info.selfWind = opt.selfWind;
+    info.roundWind = opt.roundWind;
+    RuleInfo rule;
+
+    auto record = [this](const Form &form, const FormGb &gb) {
+        int han = !form.hasYaku() ? 0
+                : form.isPrototypalYakuman() ? -form.base() / 8000
+                : form.han();
+        fus.push_back(static_cast<int8_t>(form.fu()));
+        hans.push_back(static_cast<int8_t>(han));
+        fans.push_back(static_cast<int16_t>(gb.fan()));
+    };
+
+    for (int ti = 0; ti < 34; ti++) {
+        if (closed.ct(T34(ti)) == 0)
+            continue;
+
+        size_t row = size();
+        types.push_back(static_cast<int8_t>(type));
+        shapes.insert(shapes.end(), shape, shape + SHAPE_LEN);
+        picks.push_back(static_cast<int8_t>(ti));
+
+        if (!opt.score) {
+            fus.push_back(0);
+            hans.push_back(0);
+            fans.push_back(0);
+            continue;
+        }
+
+        Hand hand = ready(row);
+        T37 pick(ti);
+        if (opt.ron) {
+            record(Form(hand, pick, info, rule), FormGb(hand, pick, info, false));
+        } else {
+            hand.draw(pick);
+            record(Form(hand, info, rule), FormGb(hand, info, false));
+        }
+    }
+}
+
+///
+/// \brief Closed tiles of a shape, pick included
+///
+TileCount HandEnum::closedOf(Form::Type type, const uint8_t *shape)
+{
+    TileCount closed;
+
+    switch (type) {
+    case Form::Type::F4:
+        closed.inc(T37(shape[0]), 2);
+        for (int m = 1; m <= 4; m++) {
+            if (shape[m] & OPEN)
+                continue;
+            int h = meldHead(shape[m]).id34();
+            if (shape[m] >= SEQ) {
+                for (int i = 0; i < 3; i++)
+                    closed.inc(T37(h + i), 1);
+            } else {
+                closed.inc(T37(h), 3);
+            }
+        }
+        break;
+    case Form::Type::F7:
+        for (int i = 0; i < SHAPE_LEN; i++)
+            closed.inc(T37(shape[i]), 2);
+        break;
+    case Form::Type::F13:
+        for (int ti = 0; ti < 34; ti++)
+            if (T34(ti).isYao())
+                closed.inc(T37(ti), 1);
+        closed.inc(T37(shape[0]), 1);
+        break;
+    }
+
+    return closed;
+}
+
+
+} // namespace saki
@@ -0,0 +1,95 @@
+#ifndef SAKI_HAND_ENUM_H
+#define SAKI_HAND_ENUM_H
+
+#include "form.h"
+
+#include <iosfwd>
+#include <vector>
+#include <cstdint>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Table of every complete 14-tile hand, scored by Form and FormGb
+///
+/// One row is one distinct (closed tiles, barks, pick) combination.
+/// Barks are chii and pon only, kans would make it a 15+ tile hand.
+/// No aka-dora, no dora, and the scoring context is fixed by Options.
+///
+/// Shapes are stored in SHAPE_LEN bytes per row:
+/// - F4: pair id34, then 4 meld codes in ascending order, then NONE x2
+/// - F7: the 7 pair id34s in ascending order
+/// - F13: the doubled id34, then NONE x6
+///
+/// A meld code is the id34 for a triplet, or SEQ + 7 * suit + (val - 1)
+/// for a sequence, with the OPEN bit set if the meld is a bark.
+/// Melds sharing the same code list barks first.
+///
+class HandEnum
+{
+public:
+    static const int SHAPE_LEN = 7;
+    static const int SEQ = 34;
+    static const int MELDS = 55;
+    static const uint8_t OPEN = 0x80;
+    static const uint8_t NONE = 0xff;
+
+    struct Options
+    {
+        unsigned suits = 0x1f; ///< bit i for Suit(i), tiles outside are never used
+        int maxBarks = 4;
+        bool form4 = true;
+        bool form7 = true;
+        bool form13 = true;
+        bool score = true; ///< false to leave the fu/han/fan columns zero
+        bool ron = false;
+        int selfWind = 2;
+        int roundWind = 1;
+    };
+
+    HandEnum() = default;
+    HandEnum(const HandEnum &copy) = default;
+    HandEnum &operator=(const HandEnum &assign) = default;
+    ~HandEnum() = default;
+
+    static HandEnum run(const Options &opt, int threads = 0);
+
+    size_t size() const;
+    void append(const HandEnum &other);
+    Hand ready(size_t row) const;
+
+    void write(std::ostream &os) const;
+    bool read(std::istream &is);
+
+    static T34 meldHead(uint8_t code);
+
+public:
+    std::vector<int8_t> types;   ///< Form::Type
+    std::vector<uint8_t> shapes; ///< SHAPE_LEN entries per row
+    std::vector<int8_t> picks;   ///< id34 of the winning tile
+    std::vector<int8_t> fus;     ///< Form::fu()
+    std::vector<int8_t> hans;    ///< Form::han(), 0 if no yaku, -k for k-fold yakuman
+    std::vector<int16_t> fans;   ///< FormGb::fan()
+
+private:
+    static size_t taskCount();
+    void runTask(const Options &opt, size_t task);
+    void runTask4(const Options &opt, int pair, int first);
+    void runTask7(const Options &opt, int first);
+    void runTask13(const Options &opt);
+    void emit(const Options &opt, Form::Type type, const uint8_t *shape);
+    static TileCount closedOf(Form::Type type, const uint8_t *shape);
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_HAND_ENUM_H
@@ -1,7 +1,6 @@
 #include "mount.h"
 #include "util.h"
 
-#include <numeric>
 #include <algorithm>
 #include <limits>
 #include <cassert>
@@ -39,6 +38,16 @@ void Exist::inc(T34 t, int delta)
     }
 }
 
+///
+/// \brief Same as inc(T34(ti), deltas[ti]) for every ti
+///
+void Exist::inc(const std::array<int, 34> &deltas)
+{
+    for (int ti = 0; ti < 34; ti++)
+        if (deltas[ti] != 0)
+            inc(T34(ti), deltas[ti]);
+}
+
 void Exist::addBaseMk(const TileCount &stoch)
 {
     for (int ti = 0; ti < 34; ti++) {
@@ -58,8 +67,10 @@ Exist::Polar Exist::polarize(const TileCount &stoch) const
     Polar res;
 
     auto add = [&res, &stoch](const T37 &t, int d) {
-        if (stoch.ct(t) > 0)
-            (res.*(d > 0 ? &Polar::pos : &Polar::npos)).emplace_back(t, d);
+        if (stoch.ct(t) > 0) {
+            (res.*(d > 0 ? &Polar::pos : &Polar::npos)).pushBack(Polar::Cy(t, d));
+            res.posSum += d > 0 ? d : 0;
+        }
     };
 
     for (int ti = 0; ti < 34; ti++)
@@ -226,6 +237,25 @@ void Mount::power(Mount::Exit exit, size_t pos, const T37 &t, int delta, bool bS
     }
 }
 
+///
+/// \brief Same as power(exit, pos, T34(ti), deltas[ti], bSpace) for every ti
+///
+/// The slot is looked up once for the whole batch. Zero deltas stand for
+/// tiles not powered at all, so an all-zero batch does not even make the
+/// slot superposed.
+///
+void Mount::powerBatch(Exit exit, size_t pos, const std::array<int, 34> &deltas, bool bSpace)
+{
+    if (util::all(deltas, [](int d) { return d == 0; }))
+        return;
+
+    auto &ptr = prepareSuperpos(exit, pos);
+    if (ptr->state == Erwin::SUPERPOS) {
+        Exist &exist = *(bSpace ? ptr->exB : ptr->exA);
+        exist.inc(deltas);
+    }
+}
+
 void Mount::pin(Exit exit, std::size_t pos, const T37 &tile)
 {
     ErwinQueue &eq = mErwinQueues[exit];
@@ -277,6 +307,57 @@ void Mount::digIndic(Rand &rand)
         mUrids.pushBack(popFrom(rand, Exit::URADORA));
 }
 
+///
+/// \brief Forget all skill effects on the mount
+///
+/// Superpositions are dropped, pinned tiles and stoch-B tiles are
+/// put back to stoch-A, leaving a mount drawn purely by chance.
+///
+void Mount::forget()
+{
+    for (ErwinQueue &eq : mErwinQueues) {
+        for (const std::unique_ptr<Erwin> &ptr : eq)
+            if (ptr != nullptr && ptr->state == Erwin::DEFINITE)
+                mStochA.inc(ptr->tile, 1);
+        eq.clear();
+    }
+
+    mStochA += mStochB;
+    mStochB = TileCount();
+}
+
+///
+/// \brief Put tiles an observer cannot tell from the mount back to stoch-A
+///
+/// Used to redeal hidden hands, together with dealA() and takeA().
+/// The number of remaining tiles is not changed, as the caller
+/// takes out as many tiles as it puts back.
+///
+void Mount::returnA(const TileCount &hidden)
+{
+    mStochA += hidden;
+}
+
+///
+/// \brief Take 'count' random tiles out of stoch-A, see returnA()
+///
+TileCount Mount::dealA(Rand &rand, int count)
+{
+    TileCount res;
+    while (count --> 0)
+        res.inc(popScientific(rand), 1);
+    return res;
+}
+
+///
+/// \brief Take exactly 'wanted' out of stoch-A, see returnA()
+///
+void Mount::takeA(const TileCount &wanted)
+{
+    assert(affordA(wanted));
+    mStochA -= wanted;
+}
+
 const std::unique_ptr<Mount::Erwin> &Mount::prepareSuperpos(Exit exit, std::size_t pos)
 {
     ErwinQueue &eq = mErwinQueues[exit];
@@ -350,10 +431,7 @@ T37 Mount::popExist(Rand &rand, Exist &exA, Exist &exB)
     } else if (polarB.pos.empty()) {
         return popPolar(rand, polarA, mStochA, 1).at(0);
     } else {
-        auto plus = [](int s, Cy &p) { return s + p.e; };
-        int sumA = std::accumulate(polarA.pos.begin(), polarA.pos.end(), 0, plus);
-        int sumB = std::accumulate(polarB.pos.begin(), polarB.pos.end(), 0, plus);
-        bool inA = rand.gen(sumA + sumB) < sumA;
+        bool inA = rand.gen(polarA.posSum + polarB.posSum) < polarA.posSum;
         return inA ? popPolar(rand, polarA, mStochA, 1).at(0)
                    : popPolar(rand, polarB, mStochB, 1).at(0);
     }
@@ -363,12 +441,7 @@ std::vector<T37> Mount::popPolar(Rand &rand, Exist::Polar &polar, TileCount &sto
 {
     std::vector<T37> res;
     res.reserve(need);
-    int sum = 0;
-
-    if (!polar.pos.empty()) { // init pos-polar
-        auto plus = [](int s, const Exist::Polar::Cy &p) { return s + p.e; };
-        sum = std::accumulate(polar.pos.begin(), polar.pos.end(), 0, plus);
-    }
+    int &sum = polar.posSum;
 
     while (need --> 0) {
         T37 pop;
@@ -397,7 +470,10 @@ std::vector<T37> Mount::popPolar(Rand &rand, Exist::Polar &polar, TileCount &sto
                     polar.npos[index].e = std::numeric_limits<int>::min();
                 } else {
                     sum -= polar.pos[index].e;
-                    polar.pos.erase(polar.pos.begin() + index);
+                    // keep the order, picks depend on it
+                    std::copy(polar.pos.begin() + index + 1, polar.pos.end(),
+                              polar.pos.begin() + index);
+                    polar.pos.popBack();
                 }
             } else if (!polar.pos.empty()) {
                 // match the probablity
@@ -26,13 +26,15 @@ public:
     {
         struct Cy
         {
+            Cy() = default;
             explicit Cy(const T37 &t, int e) : t(t), e(e) { }
             T37 t;
             int e;
         };
 
-        std::vector<Cy> pos;
-        std::vector<Cy> npos;
+        util::Stactor<Cy, 37> pos;
+        util::Stactor<Cy, 37> npos;
+        int posSum = 0; ///< sum of 'e' over 'pos'
     };
 
     Exist();
@@ -41,6 +43,7 @@ public:
 
     void inc(const T37 &t, int delta);
     void inc(T34 t, int delta);
+    void inc(const std::array<int, 34> &deltas);
     void addBaseMk(const TileCount &stoch);
 
     Polar polarize(const TileCount &stoch) const;
@@ -98,12 +101,18 @@ public:
     void lightB(const T37 &t, int delta, bool rinshan = false);
     void power(Exit exit, size_t pos, T34 t, int delta, bool bSpace);
     void power(Exit exit, size_t pos, const T37 &t, int delta, bool bSpace);
+    void powerBatch(Exit exit, size_t pos, const std::array<int, 34> &deltas, bool bSpace);
     void pin(Exit exit, std::size_t pos, const T37 &t);
     void loadB(const T37 &t, int count);
 
     void flipIndic(Rand &rand);
     void digIndic(Rand &rand);
 
+    void forget();
+    void returnA(const TileCount &hidden);
+    TileCount dealA(Rand &rand, int count);
+    void takeA(const TileCount &wanted);
+
 private:
     struct Erwin
     {
@@ -233,12 +233,14 @@ void Princess::fixIndicator(Indic which, const std::array<bool, 34> &exceptId34s
     mImageIndics[static_cast<int>(which)] = indic;
     mHasImageIndics[static_cast<int>(which)] = true;
 
-    for (int ti = 0; ti < 34; ti++) {
-        T34 t(ti);
-        // TODO de-magic the '100's and parametize them
-        mMount.power(exit, pos, t, -100, false);
-        mMount.power(exit, pos, t, t == indic ? 100 : -100, true);
-    }
+    // TODO de-magic the '100's and parametize them
+    std::array<int, 34> deltasA;
+    std::array<int, 34> deltasB;
+    deltasA.fill(-100);
+    deltasB.fill(-100);
+    deltasB[indic.id34()] = 100;
+    mMount.powerBatch(exit, pos, deltasA, false);
+    mMount.powerBatch(exit, pos, deltasB, true);
 }
 
 T34 Princess::pickIndicator(const std::array<bool, 34> &ex34s, bool wall)
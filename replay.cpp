@@ -16,6 +16,7 @@
 //     "init_points": [ 25000, 25000, 25000, 25000 ]
 //     "scores": [ 45, 10, -15, -40 ]
 //     "rule": { ... }
+//     "seed": 2333333
 //     "rounds": [
 //         {
 //             "round": 0
@@ -26,6 +27,11 @@
 //             "state": 2333333
 //             "die1": 3
 //             "die2": 5
+//             "result": "TSUMO"
+//             "resultPoints": [ 33000, 22000, 22000, 23000 ]
+//             "spells": [ "..." ]
+//             "charges": [ "..." ]
+//             "forms": [ [ 1, 2000, 30, 0, 2, 1, 0, 0, 0, false, false, true ] ]
 //             "drids": [ "1f" ]
 //             "urids": [ "2f" ]
 //             "tracks": [
@@ -49,6 +55,15 @@
 // pon/daiminkan: "5p05", "0p55", "0p055"
 // ankan: "a5p"
 // kakan: "k0p", "k5p"
+// riichi: "!1m", "!->"
+// in-only: "ron", "-" (skip)
+// out-only: "tsumo", "ryuukyoku", "-" (skip)
+// forms: [ yakus, base, fu, extraRound, han, dora, uradora, akadora,
+//          type, yakuman, dealerWin, ron ], members of Form::Digest
+//        "spells" and "charges" are made from them, and ignored on reading
+//
+// the picked tile comes first in a chii/pon/daiminkan string
+// see replay_json.h for the native reader and writer
 
 
 
@@ -182,10 +197,8 @@ void Replay::onRoundEnded(const Table &table, RoundResult result, const std::vec
     for (const T37 &t : table.getMount().getUrids())
         rounds.back().urids.emplace_back(t);
 
-    for (const auto &form : forms) {
-        rounds.back().spells.emplace_back(form.spell());
-        rounds.back().charges.emplace_back(form.charge());
-    }
+    for (const auto &form : forms)
+        rounds.back().forms.push_back(form.digest());
 
     if (result == RoundResult::KSKP) {
         rounds.back().tracks[openers[0].index()].out.emplace_back(Out::RYUUKYOKU);
@@ -209,9 +222,26 @@ void Replay::onPointsChanged(const Table &table)
     rounds.back().resultPoints = table.getPoints();
 }
 
-TableSnap Replay::look(int roundId, int turn)
+TableSnap Replay::look(int roundId, int turn) const
 {
     TableSnap snap;
+    look(snap, roundId, turn);
+    return snap;
+}
+
+///
+/// \brief Same as the returning version, but refills a caller-owned snap
+///
+/// Repeated looks into the same snap do not allocate
+///
+void Replay::look(TableSnap &snap, int roundId, int turn) const
+{
+    walk(snap, roundId, turn, nullptr);
+}
+
+void Replay::walk(TableSnap &snap, int roundId, int turn, const StepHook &hook) const
+{
+    snap = TableSnap();
     std::array<TileCount, 4> hands;
     const Round &round = rounds[roundId];
     const std::array<Track, 4> &tracks = round.tracks;
@@ -237,7 +267,7 @@ TableSnap Replay::look(int roundId, int turn)
 
     // flip first indicator
     if (!round.drids.empty())
-        snap.drids.emplace_back(round.drids[0]);
+        snap.drids.pushBack(round.drids[0]);
 
     Who who = round.dealer;
     auto next = [&who]() { who = who.right(); };
@@ -248,6 +278,8 @@ TableSnap Replay::look(int roundId, int turn)
     Who lastDiscarder;
 
     for (bool inStage = true; turn --> 0; inStage = !inStage) {
+        Who actor = who;
+        bool in = inStage;
         int step = steps[who.index()];
 
         // in-stage
@@ -285,7 +317,7 @@ TableSnap Replay::look(int roundId, int turn)
                 break;
             case In::RON:
                 snap.endOfRound = true;
-                snap.openers.emplace_back(who);
+                snap.openers.pushBack(who);
 
                 if (kanContext) {
                     snap.cannon = snap[snap.gunner.index()].barks.back()[3];
@@ -309,7 +341,7 @@ TableSnap Replay::look(int roundId, int turn)
 
             auto checkFlip = [&snap, &round, &toFlip]() {
                 if (toFlip && snap.drids.size() < round.drids.size()) {
-                    snap.drids.emplace_back(round.drids[snap.drids.size()]);
+                    snap.drids.pushBack(round.drids[snap.drids.size()]);
                     toFlip = false;
                 }
             };
@@ -327,7 +359,7 @@ TableSnap Replay::look(int roundId, int turn)
                 break;
             case Out::SPIN:
                 kanContext = false;
-                snap[who.index()].river.emplace_back(snap.drawn);
+                snap[who.index()].river.pushBack(snap.drawn);
                 snap.whoDrawn = Who();
                 lastDiscarder = who;
                 checkFlip();
@@ -346,7 +378,7 @@ TableSnap Replay::look(int roundId, int turn)
                 kanContext = false;
                 toRiichi = true;
                 snap[who.index()].riichiPos = snap[who.index()].river.size();
-                snap[who.index()].river.emplace_back(snap.drawn);
+                snap[who.index()].river.pushBack(snap.drawn);
                 snap.whoDrawn = Who();
                 lastDiscarder = who;
                 checkFlip();
@@ -357,7 +389,7 @@ TableSnap Replay::look(int roundId, int turn)
                 kanContext = true;
                 checkFlip(); // flipping of previous kan
                 if (snap.drids.size() < round.drids.size()) // flip this kan
-                    snap.drids.push_back(round.drids[snap.drids.size()]);
+                    snap.drids.pushBack(round.drids[snap.drids.size()]);
                 break;
             case Out::KAKAN:
                 lookKakan(snap, hands[who.index()], out.t37, who);
@@ -370,7 +402,7 @@ TableSnap Replay::look(int roundId, int turn)
                 break;
             case Out::TSUMO:
                 snap.endOfRound = true;
-                snap.openers.emplace_back(who);
+                snap.openers.pushBack(who);
                 break;
             case Out::SKIP_OUT:
                 // daiminkan case only
@@ -379,6 +411,9 @@ TableSnap Replay::look(int roundId, int turn)
                 break;
             }
         }
+
+        if (hook)
+            hook(snap, hands, actor, in, step);
     }
 
     for (int w = 0; w < 4; w++)
@@ -388,14 +423,11 @@ TableSnap Replay::look(int roundId, int turn)
         snap.endOfRound = true;
 
     if (snap.endOfRound) {
-        snap.spells = round.spells;
-        snap.charges = round.charges;
+        lookForms(snap, round);
         snap.points = round.resultPoints;
         for (const T37 &t : round.urids)
-            snap.urids.emplace_back(t);
+            snap.urids.pushBack(t);
     }
-
-    return snap;
 }
 
 void Replay::addSkip(Who who, Who fromWhom)
@@ -407,9 +439,23 @@ void Replay::addSkip(Who who, Who fromWhom)
     }
 }
 
-void Replay::lookAdvance(TableSnap &snap, TileCount &hand, const T37 &t37, Who who)
+///
+/// \brief Spell the winners' forms into the snap's fixed buffers
+///
+void Replay::lookForms(TableSnap &snap, const Round &round) const
 {
-    snap[who.index()].river.emplace_back(t37);
+    for (const Form::Digest &digest : round.forms) {
+        Form form(digest);
+        snap.spells.pushBack(TableSnap::Spell());
+        form.spell(snap.spells.back().data(), Form::SPELL_BUF);
+        snap.charges.pushBack(TableSnap::Charge());
+        form.charge(snap.charges.back().data(), Form::CHARGE_BUF);
+    }
+}
+
+void Replay::lookAdvance(TableSnap &snap, TileCount &hand, const T37 &t37, Who who) const
+{
+    snap[who.index()].river.pushBack(t37);
     hand.inc(t37, -1);
     if (snap.whoDrawn.somebody()) {
         hand.inc(snap.drawn, 1);
@@ -418,7 +464,7 @@ void Replay::lookAdvance(TableSnap &snap, TileCount &hand, const T37 &t37, Who w
 }
 
 void Replay::lookChii(TableSnap &snap, TileCount &hand, const InAct &in,
-                      Who who, Who lastDiscarder)
+                      Who who, Who lastDiscarder) const
 {
     T37 pick = snap[lastDiscarder.index()].river.back();
     T37 t1, t2;
@@ -451,11 +497,11 @@ void Replay::lookChii(TableSnap &snap, TileCount &hand, const InAct &in,
 
     hand.inc(t1, -1);
     hand.inc(t2, -1);
-    snap[lastDiscarder.index()].river.pop_back();
+    snap[lastDiscarder.index()].river.popBack();
 }
 
 void Replay::lookPon(TableSnap &snap, TileCount &hand, int showAka5,
-                     Who who, Who lastDiscarder)
+                     Who who, Who lastDiscarder) const
 {
     T37 pick = snap[lastDiscarder.index()].river.back();
     T37 t1(pick.id34());
@@ -475,10 +521,10 @@ void Replay::lookPon(TableSnap &snap, TileCount &hand, int showAka5,
 
     hand.inc(t1, -1);
     hand.inc(t2, -1);
-    snap[lastDiscarder.index()].river.pop_back();
+    snap[lastDiscarder.index()].river.popBack();
 }
 
-void Replay::lookDaiminkan(TableSnap &snap, TileCount &hand, Who who, Who lastDiscarder)
+void Replay::lookDaiminkan(TableSnap &snap, TileCount &hand, Who who, Who lastDiscarder) const
 {
     T37 pick = snap[lastDiscarder.index()].river.back();
 
@@ -500,10 +546,10 @@ void Replay::lookDaiminkan(TableSnap &snap, TileCount &hand, Who who, Who lastDi
 
     for (const T37 t : pushes)
         hand.inc(t, -1);
-    snap[lastDiscarder.index()].river.pop_back();
+    snap[lastDiscarder.index()].river.popBack();
 }
 
-void Replay::lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who)
+void Replay::lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who) const
 {
     int w = who.index();
     if (hand.ct(t34) == 4) {
@@ -519,6 +565,10 @@ void Replay::lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who)
         hand.inc(pushes[1], -1);
         hand.inc(pushes[2], -1);
         hand.inc(pushes[3], -1);
+        if (snap.whoDrawn == who) {
+            hand.inc(snap.drawn, 1);
+            snap.whoDrawn = Who();
+        }
     } else {
         assert(hand.ct(t34) == 3 && snap.drawn == t34);
         assert(snap.whoDrawn == who);
@@ -538,7 +588,7 @@ void Replay::lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who)
     }
 }
 
-void Replay::lookKakan(TableSnap &snap, TileCount &hand, const T37 &t37, Who who)
+void Replay::lookKakan(TableSnap &snap, TileCount &hand, const T37 &t37, Who who) const
 {
     assert(snap.whoDrawn == who);
 
@@ -546,6 +596,8 @@ void Replay::lookKakan(TableSnap &snap, TileCount &hand, const T37 &t37, Who who
         snap.whoDrawn = Who();
     } else { // from hand
         hand.inc(t37, -1);
+        hand.inc(snap.drawn, 1);
+        snap.whoDrawn = Who();
     }
 
     auto &barks = snap[who.index()].barks;
@@ -4,6 +4,8 @@
 #include "tableobserver.h"
 #include "girl.h"
 
+#include <functional>
+
 
 
 namespace saki
@@ -11,11 +13,14 @@ namespace saki
 
 
 
+///
+/// \brief Fixed-capacity snapshot, no heap allocation on copy or refill
+///
 struct PlayerSnap
 {
     util::Stactor<T37, 13> hand;
     util::Stactor<M37, 4> barks;
-    std::vector<T37> river;
+    util::Stactor<T37, 24> river;
     int riichiPos = -1;
     bool riichiBar = false;
 };
@@ -26,8 +31,8 @@ struct TableSnap
     Who whoDrawn;
     T37 drawn;
     std::array<int, 4> points;
-    std::vector<T37> drids;
-    std::vector<T37> urids;
+    util::Stactor<T37, 5> drids;
+    util::Stactor<T37, 5> urids;
     int wallRemain;
     int deadRemain;
 
@@ -43,9 +48,12 @@ struct TableSnap
     bool endOfRound = false;
     Who gunner;
     T37 cannon;
-    std::vector<Who> openers;
-    std::vector<std::string> spells;
-    std::vector<std::string> charges;
+    util::Stactor<Who, 4> openers;
+    using Spell = std::array<char, Form::SPELL_BUF>;
+    using Charge = std::array<char, Form::CHARGE_BUF>;
+    // null-terminated, made by Form::spell() and Form::charge() at look time
+    util::Stactor<Spell, 4> spells;
+    util::Stactor<Charge, 4> charges;
 
     PlayerSnap &operator[](int w) { return players[w]; }
     const PlayerSnap &operator[](int w) const { return players[w]; }
@@ -106,8 +114,7 @@ public:
         int die2;
         RoundResult result = RoundResult::ABORT;
         std::array<int, 4> resultPoints;
-        std::vector<std::string> spells;
-        std::vector<std::string> charges;
+        std::vector<Form::Digest> forms; ///< spelled when looked or written
         std::vector<T37> drids;
         std::vector<T37> urids;
         std::array<Track, 4> tracks;
@@ -133,16 +140,29 @@ public:
                       const std::vector<Form> &fs) override;
     void onPointsChanged(const Table &table) override;
 
-    TableSnap look(int roundId, int turn);
+    ///
+    /// \brief Called after each consumed in/out act during a walk
+    ///
+    /// 'step' is the act's index in tracks[who].in or tracks[who].out,
+    /// 'snap.players[].hand' is not filled during the walk, use 'hands' instead
+    ///
+    using StepHook = std::function<void(const TableSnap &snap,
+                                        const std::array<TileCount, 4> &hands,
+                                        Who who, bool in, int step)>;
+
+    TableSnap look(int roundId, int turn) const;
+    void look(TableSnap &snap, int roundId, int turn) const;
+    void walk(TableSnap &snap, int roundId, int turn, const StepHook &hook) const;
 
 private:
     void addSkip(Who who, Who fromWhom);
-    void lookAdvance(TableSnap &snap, TileCount &hand, const T37 &t37, Who who);
-    void lookChii(TableSnap &snap, TileCount &hand, const InAct &in, Who who, Who lastDiscarder);
-    void lookPon(TableSnap &snap, TileCount &hand, int showAka5, Who who, Who lastDiscarder);
-    void lookDaiminkan(TableSnap &snap, TileCount &hand, Who who, Who lastDiscarder);
-    void lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who);
-    void lookKakan(TableSnap &snap, TileCount &hand, const T37 &t37, Who who);
+    void lookForms(TableSnap &snap, const Round &round) const;
+    void lookAdvance(TableSnap &snap, TileCount &hand, const T37 &t37, Who who) const;
+    void lookChii(TableSnap &snap, TileCount &hand, const InAct &in, Who who, Who lastDiscarder) const;
+    void lookPon(TableSnap &snap, TileCount &hand, int showAka5, Who who, Who lastDiscarder) const;
+    void lookDaiminkan(TableSnap &snap, TileCount &hand, Who who, Who lastDiscarder) const;
+    void lookAnkan(TableSnap &snap, TileCount &hand, T34 t34, Who who) const;
+    void lookKakan(TableSnap &snap, TileCount &hand, const T37 &t37, Who who) const;
 
 public:
     std::array<Girl::Id, 4> girls;
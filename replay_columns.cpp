@@ -0,0 +1,287 @@
+#include "replay_columns.h"
+#include "util_parallel.h"
+
+#include <istream>
+#include <ostream>
+#include <climits>
+#include <cassert>
+
+// REPLAY COLUMN FILE
+//
+// little-endian, no padding
+//
+// u32 magic "SKRC"
+// u32 version (1)
+// u32 row count (n)
+// column data, each column contiguous, in this order:
+//     i16[n]      roundIds
+//     i8[n]       whos
+//     i8[n]       wallRemains
+//     i8[n]       riichis
+//     i8[n]       drawns
+//     i8[n]       acts
+//     i8[n]       outs
+//     u8[n * 34]  hands
+//     u8[n * 136] rivers
+//     u8[n * 34]  remains
+
+
+
+namespace saki
+{
+
+
+
+namespace
+{
+
+const uint32_t MAGIC = 0x43524b53; // "SKRC"
+const uint32_t VERSION = 1;
+
+void writeU32(std::ostream &os, uint32_t u)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = static_cast<char>((u >> (8 * i)) & 0xff);
+    os.write(buf, 4);
+}
+
+bool readU32(std::istream &is, uint32_t &u)
+{
+    unsigned char buf[4];
+    if (!is.read(reinterpret_cast<char*>(buf), 4))
+        return false;
+    u = 0;
+    for (int i = 0; i < 4; i++)
+        u |= static_cast<uint32_t>(buf[i]) << (8 * i);
+    return true;
+}
+
+template<typename T>
+void writeColumn(std::ostream &os, const std::vector<T> &col)
+{
+    static_assert(sizeof(T) <= 2, "only byte and short columns");
+    if (sizeof(T) == 1) {
+        os.write(reinterpret_cast<const char*>(col.data()), col.size());
+    } else {
+        for (T v : col) {
+            auto u = static_cast<uint16_t>(v);
+            char buf[2] = { static_cast<char>(u & 0xff), static_cast<char>(u >> 8) };
+            os.write(buf, 2);
+        }
+    }
+}
+
+template<typename T>
+bool readColumn(std::istream &is, std::vector<T> &col, size_t n)
+{
+    static_assert(sizeof(T) <= 2, "only byte and short columns");
+    col.resize(n);
+    if (sizeof(T) == 1)
+        return static_cast<bool>(is.read(reinterpret_cast<char*>(col.data()), n));
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char buf[2];
+        if (!is.read(reinterpret_cast<char*>(buf), 2))
+            return false;
+        col[i] = static_cast<T>(static_cast<uint16_t>(buf[0] | (buf[1] << 8)));
+    }
+
+    return true;
+}
+
+template<typename T>
+void appendColumn(std::vector<T> &dst, const std::vector<T> &src)
+{
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+} // namespace
+
+
+
+///
+/// \brief Extract all rounds, rounds are distributed over 'threads' workers
+///
+/// Row order is the same as extracting round by round in a single thread.
+///
+ReplayColumns ReplayColumns::extract(const Replay &replay, int threads)
+{
+    std::vector<ReplayColumns> parts(replay.rounds.size());
+
+    util::parallelFor(parts.size(), threads, [&replay, &parts](size_t i) {
+        parts[i].extractRound(replay, static_cast<int>(i));
+    });
+
+    ReplayColumns res;
+    for (const ReplayColumns &part : parts)
+        res.append(part);
+
+    return res;
+}
+
+///
+/// \brief Walk one round once and append its rows
+///
+void ReplayColumns::extractRound(const Replay &replay, int roundId)
+{
+    const Replay::Round &round = replay.rounds[roundId];
+    std::array<int, 4> outSteps { 0, 0, 0, 0 };
+    TileCount::AkadoraCount aka = replay.rule.akadora;
+
+    auto hook = [&](const TableSnap &snap, const std::array<TileCount, 4> &counts,
+                    Who who, bool in, int step) {
+        int w = who.index();
+        if (!in) {
+            outSteps[w] = step + 1;
+            return;
+        }
+
+        Replay::In inAct = round.tracks[w].in[step].act;
+        if (inAct == Replay::In::RON || inAct == Replay::In::SKIP_IN
+                || inAct == Replay::In::DAIMINKAN)
+            return;
+
+        const std::vector<Replay::OutAct> &track = round.tracks[w].out;
+        if (outSteps[w] >= static_cast<int>(track.size()))
+            return; // the round ended (abort) before the decision was made
+        const Replay::OutAct &out = track[outSteps[w]];
+
+        bool hasDrawn = snap.whoDrawn == who;
+        TileCount remain(aka);
+        int8_t riichi = 0;
+        roundIds.push_back(static_cast<int16_t>(roundId));
+        whos.push_back(static_cast<int8_t>(w));
+        wallRemains.push_back(static_cast<int8_t>(snap.wallRemain));
+        drawns.push_back(hasDrawn ? codeOf(snap.drawn) : -1);
+        acts.push_back(static_cast<int8_t>(out.act));
+
+        switch (out.act) {
+        case Replay::Out::ADVANCE:
+        case Replay::Out::RIICHI_ADVANCE:
+        case Replay::Out::ANKAN:
+        case Replay::Out::KAKAN:
+            outs.push_back(codeOf(out.t37));
+            break;
+        case Replay::Out::SPIN:
+        case Replay::Out::RIICHI_SPIN:
+            outs.push_back(codeOf(snap.drawn));
+            break;
+        default:
+            outs.push_back(-1);
+            break;
+        }
+
+        for (int s = 0; s < SEATS; s++) {
+            const PlayerSnap &player = snap[who.byTurn(s).index()];
+            if (player.riichiPos >= 0)
+                riichi |= 1 << s;
+
+            size_t base = rivers.size();
+            rivers.resize(base + CELLS, 0);
+            for (const T37 &t : player.river) {
+                rivers[base + t.id34()]++;
+                remain.inc(t, -1);
+            }
+
+            for (const M37 &m : player.barks)
+                for (const T37 &t : m.tiles())
+                    remain.inc(t, -1);
+        }
+
+        riichis.push_back(riichi);
+
+        remain -= counts[w];
+        if (hasDrawn)
+            remain.inc(snap.drawn, -1);
+        for (const T37 &t : snap.drids)
+            remain.inc(t, -1);
+
+        for (int ti = 0; ti < CELLS; ti++)
+            hands.push_back(static_cast<uint8_t>(counts[w].ct(T34(ti))));
+
+        for (int ti = 0; ti < CELLS; ti++)
+            remains.push_back(static_cast<uint8_t>(remain.ct(T34(ti))));
+    };
+
+    TableSnap snap;
+    replay.walk(snap, roundId, INT_MAX, hook);
+}
+
+size_t ReplayColumns::size() const
+{
+    return roundIds.size();
+}
+
+void ReplayColumns::append(const ReplayColumns &other)
+{
+    appendColumn(roundIds, other.roundIds);
+    appendColumn(whos, other.whos);
+    appendColumn(wallRemains, other.wallRemains);
+    appendColumn(riichis, other.riichis);
+    appendColumn(drawns, other.drawns);
+    appendColumn(acts, other.acts);
+    appendColumn(outs, other.outs);
+    appendColumn(hands, other.hands);
+    appendColumn(rivers, other.rivers);
+    appendColumn(remains, other.remains);
+}
+
+void ReplayColumns::write(std::ostream &os) const
+{
+    writeU32(os, MAGIC);
+    writeU32(os, VERSION);
+    writeU32(os, static_cast<uint32_t>(size()));
+
+    writeColumn(os, roundIds);
+    writeColumn(os, whos);
+    writeColumn(os, wallRemains);
+    writeColumn(os, riichis);
+    writeColumn(os, drawns);
+    writeColumn(os, acts);
+    writeColumn(os, outs);
+    writeColumn(os, hands);
+    writeColumn(os, rivers);
+    writeColumn(os, remains);
+}
+
+///
+/// \brief Replace the content by a column file
+/// \return false if the stream is not a readable column file
+///
+bool ReplayColumns::read(std::istream &is)
+{
+    uint32_t magic, version, n;
+    if (!readU32(is, magic) || magic != MAGIC)
+        return false;
+    if (!readU32(is, version) || version != VERSION)
+        return false;
+    if (!readU32(is, n))
+        return false;
+
+    return readColumn(is, roundIds, n)
+            && readColumn(is, whos, n)
+            && readColumn(is, wallRemains, n)
+            && readColumn(is, riichis, n)
+            && readColumn(is, drawns, n)
+            && readColumn(is, acts, n)
+            && readColumn(is, outs, n)
+            && readColumn(is, hands, n * CELLS)
+            && readColumn(is, rivers, n * SEATS * CELLS)
+            && readColumn(is, remains, n * CELLS);
+}
+
+int8_t ReplayColumns::codeOf(const T37 &t)
+{
+    return static_cast<int8_t>(t.isAka5() ? 34 + static_cast<int>(t.suit()) : t.id34());
+}
+
+T37 ReplayColumns::tileOf(int8_t code)
+{
+    assert(0 <= code && code < 37);
+    return code < 34 ? T37(code) : T37(0, Suit(code - 34));
+}
+
+
+
+} // namespace saki
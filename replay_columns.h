@@ -0,0 +1,73 @@
+#ifndef SAKI_REPLAY_COLUMNS_H
+#define SAKI_REPLAY_COLUMNS_H
+
+#include "replay.h"
+
+#include <iosfwd>
+#include <vector>
+#include <cstdint>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Per-decision features of a replay, stored column by column
+///
+/// One row is one out-stage act (discard, riichi, kan, tsumo, ryuukyoku)
+/// together with the table state right before it, as seen by the actor.
+/// Seat-related columns are relative to the actor: seat 0 is the actor,
+/// seat 1 is the right-hand player, and so on.
+///
+/// Tile codes are id34 for black tiles and 34 + suit for red fives,
+/// or -1 for no tile.
+///
+class ReplayColumns
+{
+public:
+    static const int CELLS = 34;
+    static const int SEATS = 4;
+
+    ReplayColumns() = default;
+    ReplayColumns(const ReplayColumns &copy) = default;
+    ReplayColumns &operator=(const ReplayColumns &assign) = default;
+    ~ReplayColumns() = default;
+
+    static ReplayColumns extract(const Replay &replay, int threads = 0);
+    void extractRound(const Replay &replay, int roundId);
+
+    size_t size() const;
+    void append(const ReplayColumns &other);
+
+    void write(std::ostream &os) const;
+    bool read(std::istream &is);
+
+    static int8_t codeOf(const T37 &t);
+    static T37 tileOf(int8_t code);
+
+public:
+    // scalar columns, one entry per row
+    std::vector<int16_t> roundIds;
+    std::vector<int8_t> whos;
+    std::vector<int8_t> wallRemains;
+    std::vector<int8_t> riichis;   ///< bit i set if seat i has riichi
+    std::vector<int8_t> drawns;    ///< tile code, -1 after a bark
+    std::vector<int8_t> acts;      ///< Replay::Out
+    std::vector<int8_t> outs;      ///< tile code of the act, -1 if none
+
+    // vector columns, CELLS or SEATS * CELLS entries per row
+    std::vector<uint8_t> hands;    ///< closed counts, drawn excluded
+    std::vector<uint8_t> rivers;   ///< river counts per relative seat
+    std::vector<uint8_t> remains;  ///< visible remain from the actor
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_REPLAY_COLUMNS_H
@@ -0,0 +1,994 @@
+#include "replay_json.h"
+#include "string_enum.h"
+
+#include <ostream>
+#include <cstring>
+#include <climits>
+#include <limits>
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+namespace
+{
+
+///
+/// \brief Emits JSON tokens, keeps track of commas only
+///
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream &os) : mOs(os) { }
+
+    void beginObject() { sep(); mOs.put('{'); push(); }
+    void endObject() { mDepth--; mOs.put('}'); }
+    void beginArray() { sep(); mOs.put('['); push(); }
+    void endArray() { mDepth--; mOs.put(']'); }
+
+    void key(const char *k)
+    {
+        sep();
+        quoted(k);
+        mOs.put(':');
+        mAfterKey = true;
+    }
+
+    void value(int i) { sep(); mOs << i; }
+    void value(uint32_t u) { sep(); mOs << u; }
+    void value(long long ll) { sep(); mOs << ll; }
+    void value(bool b) { sep(); mOs << (b ? "true" : "false"); }
+    void value(const char *s) { sep(); quoted(s); }
+
+private:
+    void push()
+    {
+        assert(mDepth + 1 < static_cast<int>(mFirst.size()));
+        mFirst[++mDepth] = true;
+    }
+
+    void sep()
+    {
+        if (mAfterKey) {
+            mAfterKey = false;
+            return;
+        }
+
+        if (!mFirst[mDepth])
+            mOs.put(',');
+        mFirst[mDepth] = false;
+    }
+
+    void quoted(const char *s)
+    {
+        mOs.put('"');
+        for (; *s != '\0'; s++) {
+            unsigned char c = static_cast<unsigned char>(*s);
+            if (c == '"' || c == '\\') {
+                mOs.put('\\');
+                mOs.put(*s);
+            } else if (c < 0x20) {
+                const char *hex = "0123456789abcdef";
+                mOs << "\\u00";
+                mOs.put(hex[c >> 4]);
+                mOs.put(hex[c & 0xf]);
+            } else {
+                mOs.put(*s);
+            }
+        }
+        mOs.put('"');
+    }
+
+private:
+    std::ostream &mOs;
+    std::array<bool, 8> mFirst {{ true }};
+    int mDepth = 0;
+    bool mAfterKey = false;
+};
+
+///
+/// \brief Pull-style tokenizer over a char range
+///
+/// Every function returns false on malformed input,
+/// after which the reader should be abandoned.
+///
+class JsonReader
+{
+public:
+    JsonReader(const char *begin, const char *end) : mP(begin), mEnd(end) { }
+
+    bool atEnd()
+    {
+        ws();
+        return mP == mEnd;
+    }
+
+    ///
+    /// \brief Iterate an object, calling f(key) with the reader at the value
+    ///
+    template<typename F>
+    bool object(F f)
+    {
+        if (!lit('{'))
+            return false;
+        if (peek('}'))
+            return lit('}');
+
+        do {
+            // keys longer than any known one are unknown, skip their values
+            char key[32];
+            size_t len = 0;
+            auto put = [&key, &len](char c) {
+                if (len < sizeof(key))
+                    key[len++] = c;
+                return true;
+            };
+
+            if (!string(put) || !lit(':'))
+                return false;
+
+            if (len == sizeof(key)) {
+                if (!skip())
+                    return false;
+            } else {
+                key[len] = '\0';
+                if (!f(key))
+                    return false;
+            }
+        } while (peek(',') && lit(','));
+
+        return lit('}');
+    }
+
+    ///
+    /// \brief Iterate an array, calling f(index) with the reader at the element
+    ///
+    template<typename F>
+    bool array(F f)
+    {
+        if (!lit('['))
+            return false;
+        if (peek(']'))
+            return lit(']');
+
+        int i = 0;
+        do {
+            if (!f(i++))
+                return false;
+        } while (peek(',') && lit(','));
+
+        return lit(']');
+    }
+
+    ///
+    /// \brief Read an integer, rejecting one that overflows 'long long'
+    ///
+    bool integer(long long &res)
+    {
+        ws();
+        bool neg = mP != mEnd && *mP == '-';
+        if (neg)
+            mP++;
+        if (mP == mEnd || !isDigit(*mP))
+            return false;
+
+        // accumulate on the negative side, which has room for LLONG_MIN
+        res = 0;
+        while (mP != mEnd && isDigit(*mP)) {
+            int digit = *mP++ - '0';
+            if (res < (LLONG_MIN + digit) / 10)
+                return false;
+            res = res * 10 - digit;
+        }
+
+        if (!neg) {
+            if (res == LLONG_MIN)
+                return false;
+            res = -res;
+        }
+
+        return true;
+    }
+
+    ///
+    /// \brief Read an integer, rejecting one out of the range of 'T'
+    ///
+    template<typename T>
+    bool number(T &res)
+    {
+        long long ll;
+        if (!integer(ll))
+            return false;
+        if (ll < static_cast<long long>(std::numeric_limits<T>::min())
+                || ll > static_cast<long long>(std::numeric_limits<T>::max()))
+            return false;
+        res = static_cast<T>(ll);
+        return true;
+    }
+
+    bool boolean(bool &res)
+    {
+        ws();
+        if (word("true")) {
+            res = true;
+            return true;
+        }
+
+        if (word("false")) {
+            res = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    ///
+    /// \brief Read a string into a fixed buffer, fail if it does not fit
+    ///
+    bool string(char *buf, size_t cap)
+    {
+        size_t len = 0;
+        auto put = [buf, cap, &len](char c) {
+            if (len + 1 >= cap)
+                return false;
+            buf[len++] = c;
+            return true;
+        };
+
+        bool ok = string(put);
+        buf[len] = '\0';
+        return ok;
+    }
+
+    bool skip()
+    {
+        ws();
+        if (mP == mEnd)
+            return false;
+
+        switch (*mP) {
+        case '{':
+            return object([this](const char *) { return skip(); });
+        case '[':
+            return array([this](int) { return skip(); });
+        case '"':
+            return string([](char) { return true; });
+        case 't':
+        case 'f':
+            bool b;
+            return boolean(b);
+        case 'n':
+            return word("null");
+        default:
+            // foreign numbers may be of any size, only their syntax is checked
+            if (*mP == '-')
+                mP++;
+            if (mP == mEnd || !isDigit(*mP))
+                return false;
+            // tolerate fraction and exponent parts of foreign numbers
+            while (mP != mEnd && (isDigit(*mP) || (*mP != '\0' && std::strchr(".eE+-", *mP))))
+                mP++;
+            return true;
+        }
+    }
+
+private:
+    static bool isDigit(char c)
+    {
+        return '0' <= c && c <= '9';
+    }
+
+    void ws()
+    {
+        while (mP != mEnd && (*mP == ' ' || *mP == '\n' || *mP == '\r' || *mP == '\t'))
+            mP++;
+    }
+
+    bool peek(char c)
+    {
+        ws();
+        return mP != mEnd && *mP == c;
+    }
+
+    bool lit(char c)
+    {
+        if (!peek(c))
+            return false;
+        mP++;
+        return true;
+    }
+
+    bool word(const char *w)
+    {
+        size_t len = std::strlen(w);
+        if (static_cast<size_t>(mEnd - mP) < len || std::strncmp(mP, w, len) != 0)
+            return false;
+        mP += len;
+        return true;
+    }
+
+    template<typename Put>
+    bool string(Put put)
+    {
+        if (!lit('"'))
+            return false;
+
+        while (mP != mEnd && *mP != '"') {
+            char c = *mP++;
+            if (c != '\\') {
+                if (!put(c))
+                    return false;
+                continue;
+            }
+
+            if (mP == mEnd)
+                return false;
+
+            char e = *mP++;
+            switch (e) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+                if (!unicode(put))
+                    return false;
+                continue;
+            default: c = e; break; // '"', '\\', '/'
+            }
+
+            if (!put(c))
+                return false;
+        }
+
+        return lit('"');
+    }
+
+    template<typename Put>
+    bool unicode(Put put)
+    {
+        if (mEnd - mP < 4)
+            return false;
+
+        unsigned u = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *mP++;
+            int d = isDigit(c) ? c - '0'
+                  : 'a' <= c && c <= 'f' ? c - 'a' + 10
+                  : 'A' <= c && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0)
+                return false;
+            u = u * 16 + d;
+        }
+
+        // surrogate pairs are not used by the format, kept as-is
+        if (u < 0x80)
+            return put(static_cast<char>(u));
+        if (u < 0x800)
+            return put(static_cast<char>(0xc0 | (u >> 6)))
+                    && put(static_cast<char>(0x80 | (u & 0x3f)));
+        return put(static_cast<char>(0xe0 | (u >> 12)))
+                && put(static_cast<char>(0x80 | ((u >> 6) & 0x3f)))
+                && put(static_cast<char>(0x80 | (u & 0x3f)));
+    }
+
+private:
+    const char *mP;
+    const char *mEnd;
+};
+
+
+
+int valOf(char digit)
+{
+    return digit == '0' ? 5 : digit - '0';
+}
+
+bool tileOf(const char *str, T37 &res)
+{
+    if (std::strlen(str) != 2 || !std::strchr("mpsfy", str[1]))
+        return false;
+
+    Suit s = T34::suitOf(str[1]);
+    int v = str[0] - '0';
+    int max = s == Suit::F ? 4 : s == Suit::Y ? 3 : 9;
+    bool aka = v == 0 && s != Suit::F && s != Suit::Y;
+    if (!aka && (v < 1 || v > max))
+        return false;
+
+    res = T37(str);
+    return true;
+}
+
+///
+/// \brief Format an open meld as "1s23", "5p05", "0p055", etc.
+///
+/// The picked tile comes first, followed by the values of the tiles
+/// shown from the hand, in meld order.
+///
+void meldStr(const M37 &m, char *buf)
+{
+    int lay = m.layIndex();
+    const char *pick = m[lay].str();
+    int len = 0;
+    buf[len++] = pick[0];
+    buf[len++] = pick[1];
+    for (int i = 0; i < static_cast<int>(m.tiles().size()); i++)
+        if (i != lay)
+            buf[len++] = m[i].isAka5() ? '0' : static_cast<char>('0' + m[i].val());
+    buf[len] = '\0';
+}
+
+bool meldOf(const char *str, Replay::InAct &res)
+{
+    size_t len = std::strlen(str);
+    T37 pick;
+    char pickStr[3] = { str[0], str[1], '\0' };
+    if ((len != 4 && len != 5) || !tileOf(pickStr, pick))
+        return false;
+
+    for (size_t i = 2; i < len; i++)
+        if (str[i] < '0' || str[i] > '9')
+            return false;
+
+    if (len == 5) {
+        res = Replay::InAct(Replay::In::DAIMINKAN);
+        return true;
+    }
+
+    int pv = pick.val();
+    int v1 = valOf(str[2]);
+    int v2 = valOf(str[3]);
+    int aka = (str[2] == '0') + (str[3] == '0');
+
+    if (v1 == pv && v2 == pv) {
+        res = Replay::InAct(Replay::In::PON, aka);
+    } else if (pick.isZ()) {
+        return false;
+    } else if (pv < v1 && pv < v2) {
+        res = Replay::InAct(Replay::In::CHII_AS_LEFT, aka);
+    } else if (pv > v1 && pv > v2) {
+        res = Replay::InAct(Replay::In::CHII_AS_RIGHT, aka);
+    } else {
+        res = Replay::InAct(Replay::In::CHII_AS_MIDDLE, aka);
+    }
+
+    return true;
+}
+
+bool inActOf(const char *str, Replay::InAct &res)
+{
+    T37 t;
+    if (std::strcmp(str, "ron") == 0)
+        res = Replay::InAct(Replay::In::RON);
+    else if (std::strcmp(str, "-") == 0)
+        res = Replay::InAct(Replay::In::SKIP_IN);
+    else if (tileOf(str, t))
+        res = Replay::InAct(Replay::In::DRAW, t);
+    else
+        return meldOf(str, res);
+
+    return true;
+}
+
+bool outActOf(const char *str, Replay::OutAct &res)
+{
+    T37 t;
+    if (std::strcmp(str, "->") == 0) {
+        res = Replay::OutAct(Replay::Out::SPIN);
+    } else if (std::strcmp(str, "!->") == 0) {
+        res = Replay::OutAct(Replay::Out::RIICHI_SPIN);
+    } else if (std::strcmp(str, "tsumo") == 0) {
+        res = Replay::OutAct(Replay::Out::TSUMO);
+    } else if (std::strcmp(str, "ryuukyoku") == 0) {
+        res = Replay::OutAct(Replay::Out::RYUUKYOKU);
+    } else if (std::strcmp(str, "-") == 0) {
+        res = Replay::OutAct(Replay::Out::SKIP_OUT);
+    } else if (tileOf(str, t)) {
+        res = Replay::OutAct(Replay::Out::ADVANCE, t);
+    } else if (str[0] != '\0' && tileOf(str + 1, t)) {
+        switch (str[0]) {
+        case '!':
+            res = Replay::OutAct(Replay::Out::RIICHI_ADVANCE, t);
+            break;
+        case 'a':
+            res = Replay::OutAct(Replay::Out::ANKAN, T37(t.id34())); // use id34 for ankan
+            break;
+        case 'k':
+            res = Replay::OutAct(Replay::Out::KAKAN, t);
+            break;
+        default:
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void writeTiles(JsonWriter &w, const std::vector<T37> &ts)
+{
+    w.beginArray();
+    for (const T37 &t : ts)
+        w.value(t.str());
+    w.endArray();
+}
+
+///
+/// \brief Write a digest as an array in the order of its members
+///
+void writeDigest(JsonWriter &w, const Form::Digest &digest)
+{
+    w.beginArray();
+    w.value(static_cast<long long>(digest.yakus));
+    w.value(static_cast<int>(digest.base));
+    w.value(static_cast<int>(digest.fu));
+    w.value(static_cast<int>(digest.extraRound));
+    w.value(static_cast<int>(digest.han));
+    w.value(static_cast<int>(digest.dora));
+    w.value(static_cast<int>(digest.uradora));
+    w.value(static_cast<int>(digest.akadora));
+    w.value(static_cast<int>(digest.type));
+    w.value(digest.yakuman);
+    w.value(digest.dealerWin);
+    w.value(digest.ron);
+    w.endArray();
+}
+
+void writeRule(JsonWriter &w, const RuleInfo &rule)
+{
+    // *** SYNC with RuleInfo ***
+    w.beginObject();
+    w.key("fly");
+    w.value(rule.fly);
+    w.key("headJump");
+    w.value(rule.headJump);
+    w.key("nagashimangan");
+    w.value(rule.nagashimangan);
+    w.key("ippatsu");
+    w.value(rule.ippatsu);
+    w.key("uradora");
+    w.value(rule.uradora);
+    w.key("kandora");
+    w.value(rule.kandora);
+    w.key("daiminkanPao");
+    w.value(rule.daiminkanPao);
+    w.key("akadora");
+    w.value(static_cast<int>(rule.akadora));
+    w.key("hill");
+    w.value(rule.hill);
+    w.key("returnLevel");
+    w.value(rule.returnLevel);
+    w.key("roundLimit");
+    w.value(rule.roundLimit);
+    w.endObject();
+}
+
+bool readRule(JsonReader &r, RuleInfo &rule)
+{
+    return r.object([&r, &rule](const char *key) {
+        int aka;
+        if (!std::strcmp(key, "fly"))
+            return r.boolean(rule.fly);
+        if (!std::strcmp(key, "headJump"))
+            return r.boolean(rule.headJump);
+        if (!std::strcmp(key, "nagashimangan"))
+            return r.boolean(rule.nagashimangan);
+        if (!std::strcmp(key, "ippatsu"))
+            return r.boolean(rule.ippatsu);
+        if (!std::strcmp(key, "uradora"))
+            return r.boolean(rule.uradora);
+        if (!std::strcmp(key, "kandora"))
+            return r.boolean(rule.kandora);
+        if (!std::strcmp(key, "daiminkanPao"))
+            return r.boolean(rule.daiminkanPao);
+        if (!std::strcmp(key, "akadora")) {
+            if (!r.number(aka) || aka < 0 || aka > 2)
+                return false;
+            rule.akadora = static_cast<TileCount::AkadoraCount>(aka);
+            return true;
+        }
+        if (!std::strcmp(key, "hill"))
+            return r.number(rule.hill);
+        if (!std::strcmp(key, "returnLevel"))
+            return r.number(rule.returnLevel);
+        if (!std::strcmp(key, "roundLimit"))
+            return r.number(rule.roundLimit);
+        return r.skip();
+    });
+}
+
+void writeTrack(JsonWriter &w, const Replay::Track &track, const util::Stactor<M37, 4> &melds)
+{
+    w.beginObject();
+
+    w.key("init");
+    w.beginArray();
+    for (const T37 &t : track.init)
+        w.value(t.str());
+    w.endArray();
+
+    w.key("in");
+    w.beginArray();
+    size_t meldIndex = 0;
+    char buf[8];
+    for (const Replay::InAct &in : track.in) {
+        switch (in.act) {
+        case Replay::In::DRAW:
+            w.value(in.t37.str());
+            break;
+        case Replay::In::CHII_AS_LEFT:
+        case Replay::In::CHII_AS_MIDDLE:
+        case Replay::In::CHII_AS_RIGHT:
+        case Replay::In::PON:
+        case Replay::In::DAIMINKAN:
+            assert(meldIndex < melds.size());
+            meldStr(melds[meldIndex++], buf);
+            w.value(buf);
+            break;
+        case Replay::In::RON:
+            w.value("ron");
+            break;
+        case Replay::In::SKIP_IN:
+            w.value("-");
+            break;
+        }
+    }
+    w.endArray();
+
+    w.key("out");
+    w.beginArray();
+    for (const Replay::OutAct &out : track.out) {
+        switch (out.act) {
+        case Replay::Out::ADVANCE:
+            w.value(out.t37.str());
+            break;
+        case Replay::Out::SPIN:
+            w.value("->");
+            break;
+        case Replay::Out::RIICHI_ADVANCE:
+        case Replay::Out::ANKAN:
+        case Replay::Out::KAKAN:
+            buf[0] = out.act == Replay::Out::RIICHI_ADVANCE ? '!'
+                   : out.act == Replay::Out::ANKAN ? 'a' : 'k';
+            std::strcpy(buf + 1, out.t37.str());
+            w.value(buf);
+            break;
+        case Replay::Out::RIICHI_SPIN:
+            w.value("!->");
+            break;
+        case Replay::Out::RYUUKYOKU:
+            w.value("ryuukyoku");
+            break;
+        case Replay::Out::TSUMO:
+            w.value("tsumo");
+            break;
+        case Replay::Out::SKIP_OUT:
+            w.value("-");
+            break;
+        }
+    }
+    w.endArray();
+
+    w.endObject();
+}
+
+bool readTrack(JsonReader &r, Replay::Track &track)
+{
+    return r.object([&r, &track](const char *key) {
+        char buf[16];
+        if (!std::strcmp(key, "init")) {
+            return r.array([&r, &track, &buf](int i) {
+                return i < 13 && r.string(buf, sizeof(buf)) && tileOf(buf, track.init[i]);
+            });
+        }
+
+        if (!std::strcmp(key, "in")) {
+            track.in.clear();
+            return r.array([&r, &track, &buf](int) {
+                Replay::InAct in(Replay::In::SKIP_IN);
+                if (!r.string(buf, sizeof(buf)) || !inActOf(buf, in))
+                    return false;
+                track.in.push_back(in);
+                return true;
+            });
+        }
+
+        if (!std::strcmp(key, "out")) {
+            track.out.clear();
+            return r.array([&r, &track, &buf](int) {
+                Replay::OutAct out(Replay::Out::SKIP_OUT);
+                if (!r.string(buf, sizeof(buf)) || !outActOf(buf, out))
+                    return false;
+                track.out.push_back(out);
+                return true;
+            });
+        }
+
+        return r.skip();
+    });
+}
+
+void writeRound(JsonWriter &w, const Replay &replay, int roundId)
+{
+    const Replay::Round &round = replay.rounds[roundId];
+
+    // the meld strings need the picked tiles, which only a walk can tell
+    std::array<util::Stactor<M37, 4>, 4> melds;
+    auto hook = [&melds, &round](const TableSnap &snap, const std::array<TileCount, 4> &hands,
+                                 Who who, bool in, int step) {
+        (void) hands;
+        if (!in)
+            return;
+        Replay::In act = round.tracks[who.index()].in[step].act;
+        if (act != Replay::In::DRAW && act != Replay::In::RON && act != Replay::In::SKIP_IN)
+            melds[who.index()].pushBack(snap[who.index()].barks.back());
+    };
+
+    TableSnap snap;
+    replay.walk(snap, roundId, INT_MAX, hook);
+
+    w.beginObject();
+    w.key("round");
+    w.value(round.round);
+    w.key("extraRound");
+    w.value(round.extraRound);
+    w.key("dealer");
+    w.value(round.dealer.index());
+    w.key("allLast");
+    w.value(round.allLast);
+    w.key("deposit");
+    w.value(round.deposit);
+    w.key("state");
+    w.value(round.state);
+    w.key("die1");
+    w.value(round.die1);
+    w.key("die2");
+    w.value(round.die2);
+    w.key("result");
+    w.value(stringOf(round.result));
+
+    w.key("resultPoints");
+    w.beginArray();
+    for (int p : round.resultPoints)
+        w.value(p);
+    w.endArray();
+
+    // texts for outside readers, spelled here into stack buffers
+    char text[Form::SPELL_BUF];
+
+    w.key("spells");
+    w.beginArray();
+    for (const Form::Digest &digest : round.forms) {
+        Form(digest).spell(text, sizeof(text));
+        w.value(text);
+    }
+    w.endArray();
+
+    w.key("charges");
+    w.beginArray();
+    for (const Form::Digest &digest : round.forms) {
+        Form(digest).charge(text, sizeof(text));
+        w.value(text);
+    }
+    w.endArray();
+
+    w.key("forms");
+    w.beginArray();
+    for (const Form::Digest &digest : round.forms)
+        writeDigest(w, digest);
+    w.endArray();
+
+    w.key("drids");
+    writeTiles(w, round.drids);
+    w.key("urids");
+    writeTiles(w, round.urids);
+
+    w.key("tracks");
+    w.beginArray();
+    for (int i = 0; i < 4; i++)
+        writeTrack(w, round.tracks[i], melds[i]);
+    w.endArray();
+
+    w.endObject();
+}
+
+bool readTiles(JsonReader &r, std::vector<T37> &ts)
+{
+    ts.clear();
+    return r.array([&r, &ts](int) {
+        char buf[4];
+        T37 t;
+        if (!r.string(buf, sizeof(buf)) || !tileOf(buf, t))
+            return false;
+        ts.push_back(t);
+        return true;
+    });
+}
+
+bool readDigest(JsonReader &r, Form::Digest &digest)
+{
+    int ct = 0;
+    bool ok = r.array([&r, &digest, &ct](int i) {
+        ct++;
+        switch (i) {
+        case 0: {
+            long long yakus;
+            if (!r.integer(yakus) || yakus < 0)
+                return false;
+            digest.yakus = static_cast<uint64_t>(yakus);
+            return true;
+        }
+        case 1:  return r.number(digest.base);
+        case 2:  return r.number(digest.fu);
+        case 3:  return r.number(digest.extraRound);
+        case 4:  return r.number(digest.han);
+        case 5:  return r.number(digest.dora);
+        case 6:  return r.number(digest.uradora);
+        case 7:  return r.number(digest.akadora);
+        case 8:  return r.number(digest.type);
+        case 9:  return r.boolean(digest.yakuman);
+        case 10: return r.boolean(digest.dealerWin);
+        case 11: return r.boolean(digest.ron);
+        default: return false;
+        }
+    });
+
+    return ok && ct == 12;
+}
+
+bool readDigests(JsonReader &r, std::vector<Form::Digest> &digests)
+{
+    digests.clear();
+    return r.array([&r, &digests](int) {
+        digests.emplace_back();
+        return readDigest(r, digests.back());
+    });
+}
+
+bool readRound(JsonReader &r, Replay::Round &round)
+{
+    return r.object([&r, &round](const char *key) {
+        int who;
+        char buf[16];
+        if (!std::strcmp(key, "round"))
+            return r.number(round.round);
+        if (!std::strcmp(key, "extraRound"))
+            return r.number(round.extraRound);
+        if (!std::strcmp(key, "dealer")) {
+            if (!r.number(who) || who < 0 || who >= 4)
+                return false;
+            round.dealer = Who(who);
+            return true;
+        }
+        if (!std::strcmp(key, "allLast"))
+            return r.boolean(round.allLast);
+        if (!std::strcmp(key, "deposit"))
+            return r.number(round.deposit);
+        if (!std::strcmp(key, "state"))
+            return r.number(round.state);
+        if (!std::strcmp(key, "die1"))
+            return r.number(round.die1);
+        if (!std::strcmp(key, "die2"))
+            return r.number(round.die2);
+        if (!std::strcmp(key, "result")) {
+            if (!r.string(buf, sizeof(buf)))
+                return false;
+            round.result = roundResultOf(buf);
+            return true;
+        }
+        if (!std::strcmp(key, "resultPoints")) {
+            return r.array([&r, &round](int i) {
+                return i < 4 && r.number(round.resultPoints[i]);
+            });
+        }
+        // "spells" and "charges" are skipped, being made from "forms"
+        if (!std::strcmp(key, "forms"))
+            return readDigests(r, round.forms);
+        if (!std::strcmp(key, "drids"))
+            return readTiles(r, round.drids);
+        if (!std::strcmp(key, "urids"))
+            return readTiles(r, round.urids);
+        if (!std::strcmp(key, "tracks")) {
+            return r.array([&r, &round](int i) {
+                return i < 4 && readTrack(r, round.tracks[i]);
+            });
+        }
+        return r.skip();
+    });
+}
+
+} // namespace
+
+
+
+void ReplayJson::write(std::ostream &os, const Replay &replay)
+{
+    JsonWriter w(os);
+
+    w.beginObject();
+    w.key("version");
+    w.value(3);
+
+    w.key("girls");
+    w.beginArray();
+    for (Girl::Id id : replay.girls)
+        w.value(static_cast<int>(id));
+    w.endArray();
+
+    w.key("init_points");
+    w.beginArray();
+    for (int p : replay.initPoints)
+        w.value(p);
+    w.endArray();
+
+    w.key("rule");
+    writeRule(w, replay.rule);
+    w.key("seed");
+    w.value(replay.seed);
+
+    w.key("rounds");
+    w.beginArray();
+    for (int i = 0; i < static_cast<int>(replay.rounds.size()); i++)
+        writeRound(w, replay, i);
+    w.endArray();
+
+    w.endObject();
+}
+
+///
+/// \brief Parse a v3 document into 'replay'
+/// \return false if the document is malformed or not version 3,
+///         in which case 'replay' is left in an unspecified state
+///
+bool ReplayJson::read(const char *begin, const char *end, Replay &replay)
+{
+    JsonReader r(begin, end);
+    bool versionOk = false;
+    replay.rounds.clear();
+
+    bool ok = r.object([&r, &replay, &versionOk](const char *key) {
+        if (!std::strcmp(key, "version")) {
+            int version;
+            versionOk = r.number(version) && version == 3;
+            return versionOk;
+        }
+        if (!std::strcmp(key, "girls")) {
+            return r.array([&r, &replay](int i) {
+                int id;
+                if (i >= 4 || !r.number(id))
+                    return false;
+                replay.girls[i] = Girl::Id(id);
+                return true;
+            });
+        }
+        if (!std::strcmp(key, "init_points")) {
+            return r.array([&r, &replay](int i) {
+                return i < 4 && r.number(replay.initPoints[i]);
+            });
+        }
+        if (!std::strcmp(key, "rule"))
+            return readRule(r, replay.rule);
+        if (!std::strcmp(key, "seed"))
+            return r.number(replay.seed);
+        if (!std::strcmp(key, "rounds")) {
+            return r.array([&r, &replay](int) {
+                replay.rounds.emplace_back();
+                return readRound(r, replay.rounds.back());
+            });
+        }
+        return r.skip();
+    });
+
+    return ok && versionOk && r.atEnd();
+}
+
+
+
+} // namespace saki
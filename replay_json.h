@@ -0,0 +1,37 @@
+#ifndef SAKI_REPLAY_JSON_H
+#define SAKI_REPLAY_JSON_H
+
+#include "replay.h"
+
+#include <iosfwd>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Streaming conversion between Replay and the v3 record document
+///
+/// The document format is described at the top of replay.cpp.
+/// Writing streams straight out of Replay::Round and reading fills it
+/// straight in, no JSON tree is built in between.
+///
+class ReplayJson
+{
+public:
+    ReplayJson() = delete;
+
+    static void write(std::ostream &os, const Replay &replay);
+    static bool read(const char *begin, const char *end, Replay &replay);
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_REPLAY_JSON_H
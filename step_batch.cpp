@@ -0,0 +1,107 @@
+#include "step_batch.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+void StepBatch::clear()
+{
+    for (auto &col : mCols)
+        col.clear();
+    mBarkCts.clear();
+    mSteps.clear();
+}
+
+///
+/// \return index of the new row
+///
+int StepBatch::add(const TileCount &count, int barkCt)
+{
+    for (int ti = 0; ti < 34; ti++)
+        mCols[ti].push_back(static_cast<uint8_t>(count.ct(T34(ti))));
+    mBarkCts.push_back(static_cast<uint8_t>(barkCt));
+    return static_cast<int>(mBarkCts.size()) - 1;
+}
+
+///
+/// \brief Add a copy of 'row' with one more 't'
+/// \return index of the new row
+///
+int StepBatch::addDraw(int row, T34 t)
+{
+    for (int ti = 0; ti < 34; ti++)
+        mCols[ti].push_back(static_cast<uint8_t>(mCols[ti][row] + (ti == t.id34())));
+    mBarkCts.push_back(mBarkCts[row]);
+    return static_cast<int>(mBarkCts.size()) - 1;
+}
+
+void StepBatch::evaluate()
+{
+    const size_t n = size();
+    std::vector<int8_t> kinds(n, 0);
+    std::vector<int8_t> pairs(n, 0);
+    std::vector<int8_t> yaoKinds(n, 0);
+    std::vector<int8_t> yaoPairs(n, 0);
+
+    for (int ti = 0; ti < 34; ti++) {
+        const uint8_t *col = mCols[ti].data();
+        for (size_t r = 0; r < n; r++) {
+            kinds[r] += col[r] > 0;
+            pairs[r] += col[r] >= 2;
+        }
+    }
+
+    for (T34 t : tiles34::YAO13) {
+        const uint8_t *col = mCols[t.id34()].data();
+        for (size_t r = 0; r < n; r++) {
+            yaoKinds[r] += col[r] > 0;
+            yaoPairs[r] |= col[r] >= 2;
+        }
+    }
+
+    mSteps.resize(n);
+    for (size_t r = 0; r < n; r++) {
+        int s7 = (6 - pairs[r]) + std::max(0, 7 - kinds[r]);
+        int s13 = 13 - yaoKinds[r] - yaoPairs[r];
+        int s = std::min(s7, s13);
+        if (s > -1) // nothing is below agari
+            s = std::min(s, count(static_cast<int>(r)).step4(mBarkCts[r]));
+        mSteps[r] = static_cast<int8_t>(s);
+    }
+}
+
+size_t StepBatch::size() const
+{
+    return mBarkCts.size();
+}
+
+///
+/// \brief Result of the latest evaluate()
+///
+int StepBatch::step(int row) const
+{
+    assert(0 <= row && row < static_cast<int>(mSteps.size()));
+    return mSteps[row];
+}
+
+///
+/// \brief Counts of a row, red fives are not kept
+///
+TileCount StepBatch::count(int row) const
+{
+    TileCount res;
+    for (int ti = 0; ti < 34; ti++)
+        if (mCols[ti][row] > 0)
+            res.inc(T37(ti), mCols[ti][row]);
+    return res;
+}
+
+
+
+} // namespace saki
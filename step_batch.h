@@ -0,0 +1,56 @@
+#ifndef SAKI_STEP_BATCH_H
+#define SAKI_STEP_BATCH_H
+
+#include "tile_count.h"
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+
+
+namespace saki
+{
+
+
+
+///
+/// \brief Step of many hands at once, stored tile kind by tile kind
+///
+/// Rows are laid out as 34 count columns, so the 7-pairs and
+/// 13-orphans parts are straight loops over contiguous bytes that
+/// compilers vectorize. The 4-meld part is a recursive search and is
+/// still done row by row.
+///
+/// Results equal TileCount::step(barkCt) of each row.
+///
+class StepBatch
+{
+public:
+    StepBatch() = default;
+    StepBatch(const StepBatch &copy) = default;
+    StepBatch &operator=(const StepBatch &assign) = default;
+    ~StepBatch() = default;
+
+    void clear();
+    int add(const TileCount &count, int barkCt);
+    int addDraw(int row, T34 t);
+    void evaluate();
+
+    size_t size() const;
+    int step(int row) const;
+    TileCount count(int row) const;
+
+private:
+    std::array<std::vector<uint8_t>, 34> mCols;
+    std::vector<uint8_t> mBarkCts;
+    std::vector<int8_t> mSteps;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_STEP_BATCH_H
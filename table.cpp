@@ -84,20 +84,45 @@ TablePrivate::TablePrivate(const std::array<int, 4> &points,
 
 
 
+namespace
+{
+
+std::array<std::unique_ptr<Girl>, 4> createGirls(const std::array<int, 4> &girlIds)
+{
+    std::array<std::unique_ptr<Girl>, 4> girls;
+    for (int w = 0; w < 4; w++)
+        girls[w].reset(Girl::create(Who(w), girlIds[w]));
+    return girls;
+}
+
+} // namespace
+
 Table::Table(const std::array<int, 4> &points,
              const std::array<int, 4> &girlIds,
              const std::array<TableOperator*, 4> &operators,
              const std::vector<TableObserver*> &observers,
              RuleInfo rule, Who tempDealer)
+    : Table(points, createGirls(girlIds), operators, observers, rule, tempDealer)
+{
+}
+
+///
+/// \brief Start with girls made by the caller, who gives up their ownership
+///
+Table::Table(const std::array<int, 4> &points,
+             std::array<std::unique_ptr<Girl>, 4> girls,
+             const std::array<TableOperator*, 4> &operators,
+             const std::vector<TableObserver*> &observers,
+             RuleInfo rule, Who tempDealer)
     : TablePrivate(points, rule, tempDealer)
+    , mGirls(std::move(girls))
     , mOperators(operators)
     , mObservers(observers)
 {
     assert(!util::has(mOperators, static_cast<TableOperator*>(nullptr)));
     assert(!util::has(mObservers, static_cast<TableObserver*>(nullptr)));
 
-    for (int w = 0; w < 4; w++)
-        mGirls[w].reset(Girl::create(Who(w), girlIds[w]));
+    subscribeGirls();
 
     // to choose real init dealer
     mChoicess[mInitDealer.index()].setDice();
@@ -114,9 +139,175 @@ Table::Table(const Table &orig,
     for (int w = 0; w < 4; w++)
         mGirls[w].reset(orig.mGirls[w]->clone());
 
+    subscribeGirls();
+
     mChoicess[toki.index()] = clean;
 }
 
+namespace
+{
+
+///
+/// \brief Draw a ready closed part for a riichi hand out of stoch-A
+///
+/// Melds and a pair are drawn at random out of the pool, then one of
+/// the tiles is dropped. Only the 4-meld form is generated.
+///
+/// \return Tiles for the closed part, or nothing after too many misses
+///
+TileCount drawReady(Rand &rand, const Mount &mount, const util::Stactor<M37, 4> &barks)
+{
+    const int MISS_LIMIT = 256;
+
+    std::array<int, 34> pool;
+    for (int ti = 0; ti < 34; ti++)
+        pool[ti] = mount.remainA(T34(ti));
+
+    std::array<int, 34> kinds {};
+    auto take = [&pool, &kinds](int ti, int ct) {
+        pool[ti] -= ct;
+        kinds[ti] += ct;
+    };
+
+    int meldCt = 4 - static_cast<int>(barks.size());
+    bool hasPair = false;
+    int misses = 0;
+    while (!hasPair && misses < MISS_LIMIT) {
+        int ti = rand.gen(34);
+        T34 t(ti);
+        if (meldCt == 0) {
+            hasPair = pool[ti] >= 2;
+            if (hasPair)
+                take(ti, 2);
+            else
+                misses++;
+        } else if (t.isNum() && t.val() <= 7 && rand.gen(4) != 0) {
+            if (pool[ti] > 0 && pool[ti + 1] > 0 && pool[ti + 2] > 0) {
+                take(ti, 1);
+                take(ti + 1, 1);
+                take(ti + 2, 1);
+                meldCt--;
+            } else {
+                misses++;
+            }
+        } else if (pool[ti] >= 3) {
+            take(ti, 3);
+            meldCt--;
+        } else {
+            misses++;
+        }
+    }
+
+    if (!hasPair)
+        return TileCount();
+
+    int drop = rand.gen(3 * (4 - static_cast<int>(barks.size())) + 2);
+    for (int ti = 0; drop >= 0; ti++) {
+        drop -= kinds[ti];
+        if (drop < 0)
+            kinds[ti]--;
+    }
+
+    TileCount res;
+    for (int ti = 0; ti < 34; ti++) {
+        T37 plain(ti);
+        for (int i = 0; i < kinds[ti]; i++) {
+            T37 t(plain);
+            if (plain.val() == 5 && plain.isNum()) {
+                int reds = mount.remainA(plain.toAka5()) - res.ct(plain.toAka5());
+                int blacks = mount.remainA(plain) - res.ct(plain);
+                if (rand.gen(reds + blacks) < reds)
+                    t = plain.toAka5();
+            }
+
+            res.inc(t, 1);
+        }
+    }
+
+    return Hand(res, barks).ready() ? res : TileCount();
+}
+
+} // namespace
+
+///
+/// \brief Fork a table as the view's owner imagines it
+///
+/// Closed hands and drawn tiles of the others go back to the mount,
+/// and skill effects on the mount are forgotten. Then all of them are
+/// dealt again out of that pool, which is exactly what the viewer cannot
+/// see, so no hand tells anything about the real hidden ones.
+/// Everything public (rivers, barks, points, etc.) is kept.
+///
+/// Hands under riichi are dealt first, as some ready hand. Plain rejection
+/// sampling would hardly ever hit a ready hand, so the shape is drawn meld
+/// by meld instead, which does not follow the exact posterior. On a pool
+/// too thin for that, the real hand is kept if it is still in the pool.
+/// Sutehai furiten follows the redealt waits, other furiten flags are kept.
+///
+Table::Table(const TableView &view,
+             const std::array<TableOperator*, 4> &operators,
+             const std::vector<TableObserver*> &observers,
+             uint32_t seed)
+    : TablePrivate(view.mTable)
+    , mOperators(operators)
+    , mObservers(observers)
+{
+    for (int w = 0; w < 4; w++)
+        mGirls[w].reset(view.mTable.mGirls[w]->clone());
+
+    subscribeGirls();
+
+    mRand.set(seed);
+    mMount.forget();
+
+    // copies, since waitMask() fills a cache and rollout threads
+    // may be forking the same view at once
+    const std::array<Hand, 4> origs = mHands;
+
+    for (int w = 0; w < 4; w++) {
+        if (Who(w) == view.mViewer)
+            continue;
+
+        mMount.returnA(origs[w].closed());
+        if (origs[w].hasDrawn()) {
+            TileCount drawn;
+            drawn.inc(origs[w].drawn(), 1);
+            mMount.returnA(drawn);
+        }
+    }
+
+    for (bool riichiPass : { true, false }) {
+        for (int w = 0; w < 4; w++) {
+            const Hand &orig = origs[w];
+            bool riichi = mRiichiHans[w] != 0 && orig.waitMask() != 0; // not between rounds
+            if (Who(w) == view.mViewer || riichi != riichiPass)
+                continue;
+
+            TileCount closed;
+            if (riichi)
+                closed = drawReady(mRand, mMount, orig.barks());
+            if (riichi && closed.sum() == 0 && mMount.affordA(orig.closed()))
+                closed = orig.closed();
+
+            if (closed.sum() > 0)
+                mMount.takeA(closed);
+            else
+                closed = mMount.dealA(mRand, orig.closed().sum());
+
+            Hand redealt(closed, orig.barks());
+            uint64_t waits = redealt.ready() ? redealt.waitMask() : 0;
+            mHands[w] = redealt;
+            mFuritens[w].sutehai = util::any(mRivers[w], [waits](const T37 &r) {
+                return (waits >> r.id34()) & 1;
+            });
+        }
+    }
+
+    for (int w = 0; w < 4; w++)
+        if (Who(w) != view.mViewer && origs[w].hasDrawn())
+            mHands[w].draw(mMount.dealA(mRand, 1).t37s13(true).at(0));
+}
+
 void Table::start()
 {
     for (auto ob : mObservers)
@@ -136,7 +327,7 @@ void Table::action(Who who, const Action &act)
         mChoicess[w] = mGirls[w]->forwardAction(*this, mMount, act);
         reactivate = mChoicess[w].mode() != Choices::Mode::WATCH;
     } else {
-        for (auto &g : mGirls)
+        for (Girl *g : mHookGirls[Girl::ON_INBOX])
             g->onInbox(who, act);
 
         if (act.act() == ActCode::PASS && mChoicess[w].can(ActCode::RON))
@@ -169,11 +360,11 @@ bool Table::check(Who who, const Action &action) const
         case AC::SWAP_OUT:
             return util::has(mHands[who.index()].closed().t37s13(), action.t37());
         case AC::SWAP_RIICHI:
-            return util::has(choices.drawn().swapRiichis, action.t37());
+            return util::has(choices.drawn().swapRiichis(), action.t37());
         case AC::ANKAN:
-            return util::has(choices.drawn().ankans, action.t34());
+            return util::has(choices.drawn().ankans(), action.t34());
         case AC::KAKAN:
-            return util::has(choices.drawn().kakans, action.barkId());
+            return util::has(choices.drawn().kakans(), action.barkId());
         default:
             return true;
         }
@@ -415,6 +606,11 @@ const Mount &Table::getMount() const
     return mMount;
 }
 
+const WaitEstimate &Table::getWaitEstimate() const
+{
+    return mWaitEstimate;
+}
+
 void Table::popUp(Who who) const
 {
     for (auto ob : mObservers)
@@ -546,7 +742,8 @@ void Table::nextRound()
 
     mChoicess[mDealer.index()].setDice();
     for (int i = 0; i < 4; i++)
-        mGirls[i]->onDice(mRand, *this, mChoicess[i]);
+        if (mGirls[i]->hooks().test(Girl::ON_DICE))
+            mGirls[i]->onDice(mRand, *this, mChoicess[i]);
 }
 
 void Table::clean()
@@ -562,6 +759,7 @@ void Table::clean()
     mLayPositions.fill(-1);
 
     mIppatsuFlags.reset();
+    mWaitEstimate = WaitEstimate();
 
     mToEstablishRiichi = false;
     mToFlip = false;
@@ -579,7 +777,7 @@ void Table::rollDice()
     int die2 = mRand.gen(6) + 1;
 
     if (beforeEast1()) {
-        for (auto &g : mGirls)
+        for (Girl *g : mHookGirls[Girl::ON_CHOOSE_FIRST_DEALER])
             g->onChooseFirstDealer(mRand, mInitDealer, die1, die2);
     }
 
@@ -616,6 +814,7 @@ void Table::deal()
 void Table::flip()
 {
     mMount.flipIndic(mRand);
+    mWaitEstimate.onVisible(mMount.getDrids().back());
 
     for (auto ob : mObservers)
         ob->onFlipped(*this);
@@ -631,29 +830,24 @@ void Table::tryDraw(Who who)
     int w = who.index();
 
     if (mMount.wallRemain() > 0) {
-        for (auto &g : mGirls)
+        for (Girl *g : mHookGirls[Girl::ON_DRAW])
             g->onDraw(*this, mMount, who, dead);
 
         T37 tile = dead ? mMount.deadPop(mRand) : mMount.wallPop(mRand);
         mHands[w].draw(tile);
 
-        Choices::ModeDrawn mode;
-
-        mode.swapOut = !riichiEstablished(who);
-        mode.tsumo = mHands[w].canTsumo(getPointInfo(who), mRule);
-        mode.kskp = noBarkYet() && mRivers[w].empty() && mHands[w].nine9();
-
-        if (mMount.wallRemain() >= 4
+        bool riichiOk = mMount.wallRemain() >= 4
                 && mPoints[w] >= 1000
-                && !riichiEstablished(who)) {
-            mHands[w].canRiichi(mode.swapRiichis, mode.spinRiichi);
-        }
+                && !riichiEstablished(who);
 
         // must be able to maintain king-14, and forbid 5th kan
-        if (mMount.wallRemain() > 0 && mMount.deadRemain() > int(mToFlip)) {
-            mHands[w].canAnkan(mode.ankans, riichiEstablished(who));
-            mHands[w].canKakan(mode.kakans);
-        }
+        bool kanOk = mMount.wallRemain() > 0 && mMount.deadRemain() > int(mToFlip);
+
+        // tsumo, riichi and kan choices are solved when first queried
+        Choices::ModeDrawn mode(mHands[w], getPointInfo(who), mRule,
+                                riichiOk, kanOk, riichiEstablished(who));
+        mode.swapOut = !riichiEstablished(who);
+        mode.kskp = noBarkYet() && mRivers[w].empty() && mHands[w].nine9();
 
         mChoicess[w].setDrawn(mode);
 
@@ -725,7 +919,7 @@ void Table::barkOut(Who who, const T37 &out)
 
 void Table::onDiscarded()
 {
-    for (auto &g : mGirls)
+    for (Girl *g : mHookGirls[Girl::ON_DISCARDED])
         g->onDiscarded(*this, mFocus.who());
 
     mIppatsuFlags.reset(mFocus.who().index());
@@ -745,10 +939,17 @@ void Table::onDiscarded()
         flip();
     }
 
-    mGenbutsuFlags[mFocus.who().index()].set(getFocusTile().id34());
-    for (int w = 0; w < 4; w++)
-        if (riichiEstablished(Who(w)))
-            mGenbutsuFlags[w].set(getFocusTile().id34());
+    T34 out = getFocusTile();
+    mGenbutsuFlags[mFocus.who().index()].set(out.id34());
+    mWaitEstimate.onVisible(getFocusTile());
+    mWaitEstimate.onDiscarded(mFocus.who());
+    mWaitEstimate.onGenbutsu(mFocus.who(), out);
+    for (int w = 0; w < 4; w++) {
+        if (riichiEstablished(Who(w))) {
+            mGenbutsuFlags[w].set(out.id34());
+            mWaitEstimate.onGenbutsu(Who(w), out);
+        }
+    }
 
     checkSutehaiFuriten();
     checkBarkRon();
@@ -781,8 +982,9 @@ bool Table::finishRiichi()
     mToEstablishRiichi = false;
     mRiichiHans[w] = noBarkYet() && mRivers[w].size() == 1 ? 2 : 1;
     mIppatsuFlags.set(w);
+    mWaitEstimate.onRiichiEstablished(mFocus.who());
 
-    for (auto &g : mGirls)
+    for (Girl *g : mHookGirls[Girl::ON_RIICHI_ESTABLISHED])
         g->onRiichiEstablished(*this, mFocus.who());
 
     for (auto ob : mObservers) {
@@ -816,6 +1018,7 @@ void Table::chii(Who who, ActCode dir, const T37 &out, bool showAka5)
                      : dir == M ? &Hand::chiiAsMiddle : &Hand::chiiAsRight;
 
     (mHands[who.index()].*pChii)(getFocusTile(), showAka5);
+    mWaitEstimate.onBarked(who, mHands[who.index()].barks().back());
 
     for (auto ob : mObservers)
         ob->onBarked(*this, who, mHands[who.index()].barks().back(), false);
@@ -829,6 +1032,7 @@ void Table::pon(Who who, const T37 &out, int showAka5)
 
     int layIndex = who.looksAt(mFocus.who());
     mHands[who.index()].pon(getFocusTile(), showAka5, layIndex);
+    mWaitEstimate.onBarked(who, mHands[who.index()].barks().back());
 
     for (auto ob : mObservers)
         ob->onBarked(*this, who, mHands[who.index()].barks().back(), false);
@@ -844,6 +1048,7 @@ void Table::daiminkan(Who who)
 
     int layIndex = who.looksAt(mFocus.who());
     mHands[who.index()].daiminkan(getFocusTile(), layIndex);
+    mWaitEstimate.onBarked(who, mHands[who.index()].barks().back());
 
     for (auto ob : mObservers)
         ob->onBarked(*this, who, mHands[who.index()].barks().back(), false);
@@ -880,6 +1085,7 @@ void Table::ankan(Who who, T34 tile)
     int w = who.index();
     bool spin = mHands[w].drawn() == tile;
     mHands[w].ankan(tile);
+    mWaitEstimate.onBarked(who, mHands[w].barks().back());
     mFocus.focusOnChankan(who, mHands[who.index()].barks().size() - 1);
 
     for (auto ob : mObservers)
@@ -908,6 +1114,7 @@ void Table::kakan(Who who, int barkId)
     mHands[w].kakan(barkId);
     mFocus.focusOnChankan(who, barkId);
     const M37 &kanMeld = mHands[who.index()].barks()[barkId];
+    mWaitEstimate.onVisible(kanMeld[3]);
 
     for (auto ob : mObservers)
         ob->onBarked(*this, who, kanMeld, spin);
@@ -945,7 +1152,8 @@ void Table::activate()
 
     for (int w = 0; w < 4; w++) {
         // fitering, extra-attaching, and/or global-forwarding
-        if (mChoicess[w].mode() != Choices::Mode::WATCH) {
+        if (mChoicess[w].mode() != Choices::Mode::WATCH
+                && mGirls[w]->hooks().test(Girl::ON_ACTIVATE)) {
             bool couldRon = mChoicess[w].can(ActCode::RON);
             mGirls[w]->onActivate(*this, mChoicess[w]);
             if (couldRon && !mChoicess[w].can(ActCode::RON))
@@ -1008,7 +1216,9 @@ void Table::checkChankan(bool only13)
         if (Who(w) == mFocus.who())
             continue;
 
-        if (mFuritens[w].none() && (!only13 || mHands[w].step13() == 0)) {
+        // cheap bit test first, most hands do not wait on the focus
+        bool waiting = (mHands[w].waitMask() >> getFocusTile().id34()) & 1;
+        if (waiting && mFuritens[w].none() && (!only13 || mHands[w].step13() == 0)) {
             Choices::ModeBark mode;
             mode.focus = getFocusTile();
             bool passiveDoujun = false;
@@ -1032,7 +1242,7 @@ void Table::checkBarkRon()
         mode.focus = focus;
 
         // ron
-        if (mFuritens[w].none()) {
+        if (mFuritens[w].none() && ((mHands[w].waitMask() >> focus.id34()) & 1)) {
             bool passiveDoujun = false;
             mode.ron = mHands[w].canRon(focus, getPointInfo(Who(w)), mRule, passiveDoujun);
             mFuritens[w].doujun = mFuritens[w].doujun || passiveDoujun;
@@ -1065,14 +1275,10 @@ void Table::checkSutehaiFuriten()
     if (!mHands[w].ready())
         return;
 
-    for (T34 t : mHands[w].effA()) {
-        if (util::any(mRivers[w], [t](const T37 &r) { return r == t; })) {
-            mFuritens[w].sutehai = true;
-            return;
-        }
-    }
-
-    mFuritens[w].sutehai = false;
+    uint64_t waits = mHands[w].waitMask();
+    mFuritens[w].sutehai = util::any(mRivers[w], [waits](const T37 &r) {
+        return (waits >> r.id34()) & 1;
+    });
 }
 
 void Table::passRon(Who who)
@@ -1123,7 +1329,7 @@ void Table::exhaustRound(RoundResult result, const std::vector<Who> &openers)
     }
 
     std::vector<Form> forms; // empty
-    for (auto &g : mGirls)
+    for (Girl *g : mHookGirls[Girl::ON_ROUND_ENDED])
         g->onRoundEnded(*this, result, openers, Who(), forms);
     for (auto ob : mObservers)
         ob->onRoundEnded(*this, result, openers, Who(), forms);
@@ -1170,7 +1376,7 @@ void Table::finishRound(const std::vector<Who> &openers_, Who gunner)
         }
     }
 
-    for (auto &g : mGirls) {
+    for (Girl *g : mHookGirls[Girl::ON_ROUND_ENDED]) {
         g->onRoundEnded(*this, isRon ? RoundResult::RON : RoundResult::TSUMO,
                         openers, gunner, forms);
     }
@@ -1254,6 +1460,20 @@ void Table::endTable()
         ob->onTableEnded(rank, scores);
 }
 
+///
+/// \brief List each hook's girls, so that plain girls are not dispatched
+///
+void Table::subscribeGirls()
+{
+    for (auto &girls : mHookGirls)
+        girls.clear();
+
+    for (auto &g : mGirls)
+        for (int h = 0; h < Girl::NUM_HOOKS; h++)
+            if (g->hooks().test(h))
+                mHookGirls[h].pushBack(g.get());
+}
+
 
 
 } // namespace saki
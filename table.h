@@ -9,6 +9,7 @@
 #include "tableoperator.h"
 #include "tableobserver.h"
 #include "tile_count.h"
+#include "wait_estimate.h"
 #include "rand.h"
 
 #include <memory>
@@ -102,6 +103,7 @@ protected:
 
     std::bitset<4> mIppatsuFlags;
     std::array<std::bitset<34>, 4> mGenbutsuFlags;
+    WaitEstimate mWaitEstimate;
 };
 
 
@@ -115,11 +117,22 @@ public:
                    const std::vector<TableObserver*> &observers,
                    RuleInfo rule, Who tempDealer);
 
+    explicit Table(const std::array<int, 4> &points,
+                   std::array<std::unique_ptr<Girl>, 4> girls,
+                   const std::array<TableOperator*, 4> &operators,
+                   const std::vector<TableObserver*> &observers,
+                   RuleInfo rule, Who tempDealer);
+
     explicit Table(const Table &orig,
                    const std::array<TableOperator*, 4> &operators,
                    const std::vector<TableObserver*> &observers,
                    Who toki, const Choices &clean);
 
+    explicit Table(const TableView &view,
+                   const std::array<TableOperator*, 4> &operators,
+                   const std::vector<TableObserver*> &observers,
+                   uint32_t seed);
+
     Table(const Table &copy) = delete;
     Table &operator=(const Table &assign) = delete;
 
@@ -158,6 +171,7 @@ public:
     PointInfo getPointInfo(Who who) const;
     const Choices &getChoices(Who who) const;
     const Mount &getMount() const;
+    const WaitEstimate &getWaitEstimate() const;
 
     void popUp(Who who) const;
 
@@ -198,9 +212,11 @@ private:
     void finishRound(const std::vector<Who> &openers, Who gunner);
     void endOrNext();
     void endTable();
+    void subscribeGirls();
 
 private:
     std::array<std::unique_ptr<Girl>, 4> mGirls;
+    std::array<util::Stactor<Girl *, 4>, Girl::NUM_HOOKS> mHookGirls; ///< in seat order
     std::array<TableOperator*, 4> mOperators;
     std::vector<TableObserver*> mObservers;
 };
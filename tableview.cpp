@@ -16,6 +16,11 @@ TableView::TableView(const Table &table, Who viewer, TableView::Mode mode)
 {
 }
 
+Who TableView::self() const
+{
+    return mViewer;
+}
+
 Action TableView::mySweep() const
 {
     return mTable.getChoices(mViewer).sweep();
@@ -71,6 +76,11 @@ const RuleInfo &TableView::getRuleInfo() const
     return mTable.getRuleInfo();
 }
 
+int TableView::wallRemain() const
+{
+    return mTable.getMount().wallRemain();
+}
+
 int TableView::getSelfWind(Who who) const
 {
     return mTable.getSelfWind(who);
@@ -126,6 +136,11 @@ bool TableView::inIppatsuCycle() const
     return mTable.inIppatsuCycle();
 }
 
+const WaitEstimate &TableView::waitEstimate() const
+{
+    return mTable.getWaitEstimate();
+}
+
 
 
 } // namespace saki
@@ -5,6 +5,7 @@
 #include "hand.h"
 #include "girl.h"
 #include "tablefocus.h"
+#include "wait_estimate.h"
 
 #include <vector>
 
@@ -32,6 +33,7 @@ public:
     explicit TableView(const Table &table, Who viewer, Mode mode);
     TableView(const TableView &copy) = default;
 
+    Who self() const;
     Action mySweep() const;
     const Choices &myChoices() const;
     const Girl &me() const;
@@ -44,6 +46,7 @@ public:
     const T37 &getFocusTile() const;
     const util::Stactor<T37, 5> &getDrids() const;
     const RuleInfo &getRuleInfo() const;
+    int wallRemain() const;
     int getSelfWind(Who who) const;
     int getRoundWind() const;
     TileCount visibleRemain() const;
@@ -57,8 +60,11 @@ public:
     bool isMenzen(Who who) const;
     bool isAllLast() const;
     bool inIppatsuCycle() const;
+    const WaitEstimate &waitEstimate() const;
 
 private:
+    friend class Table; // forking from a view
+
     const Table &mTable;
     const Who mViewer;
     const Mode mMode;
@@ -5,10 +5,24 @@
 #include "form_gb.h"
 #include "table.h"
 #include "ai.h"
+#include "ai_rollout.h"
+#include "danger.h"
+#include "discard_ev.h"
+#include "farm.h"
+#include "gen_index.h"
+#include "girls_util_toki.h"
+#include "gen_gb.h"
+#include "hand_enum.h"
+#include "rand.h"
+#include "replay_columns.h"
+#include "replay_json.h"
 #include "string_enum.h"
 #include "util.h"
 
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <sstream>
 #include <cstring>
 #include <cassert>
 
@@ -47,6 +61,26 @@ void testAll()
 //    testForm();
 //    testFormGb();
     testTable();
+    testGirlHooks();
+    testReplay();
+    testReplayLook();
+    testAiRollout();
+    testTableFork();
+    testDanger();
+    testDiscardEv();
+    testListCp();
+    testFarm();
+    testGenIndex();
+    testHandWaits();
+    testChoicesDrawn();
+    testFormWaits();
+    testFormText();
+    testTokiEvents();
+    testMountBatch();
+    testGenBatch();
+    testHandEnum();
+    testFanIndex();
+//    testFormGbSpeed();
 }
 
 void testUtil()
@@ -67,6 +101,11 @@ void testTileCount()
     TileCount tc { 1_m, 1_m, 1_m, 2_p, 2_p, 2_p, 3_s, 3_s, 3_s, 4_f, 4_f, 4_f, 1_y, 1_y };
     assert(tc.step4(0) == -1);
     assert(tc.step(0) == -1);
+
+    assert(T34("9m").dora() == T34("1m") && T34("1m").indicator() == T34("9m"));
+    assert(T34("4f").dora() == T34("1f") && T34("1y").indicator() == T34("3y"));
+    assert(T34("9s").isNum19() && !T34("1f").isNum19() && T34("1f").isYao());
+    assert(T34("8p") % T34("9p") && !(T34("9p") % T34("1s")));
 }
 
 void testHand()
@@ -123,6 +162,1304 @@ void testTable()
     }
 }
 
+namespace
+{
+
+///
+/// \brief Counts the draws and discards that reach her
+///
+/// The hooks are given by the test, so that a cleared bit
+/// can be checked to keep her overrides from being called.
+///
+class CountGirl : public Girl
+{
+public:
+    CountGirl(Who who, const Hooks &hooks, std::array<int, 2> &counts)
+        : Girl(who, Id::DOGE, hooks)
+        , mCounts(&counts)
+    {
+    }
+
+    GIRL_CTORS_CLONE_ONLY(CountGirl)
+
+    void onDraw(const Table &table, Mount &mount, Who who, bool rinshan) override
+    {
+        (void) table; (void) mount; (void) who; (void) rinshan;
+        (*mCounts)[0]++;
+    }
+
+    void onDiscarded(const Table &table, Who who) override
+    {
+        (void) table; (void) who;
+        (*mCounts)[1]++;
+    }
+
+private:
+    std::array<int, 2> *mCounts;
+};
+
+} // namespace
+
+void testGirlHooks()
+{
+    TestScope test("girl-hooks");
+
+    std::unique_ptr<Girl> doge(Girl::create(Who(0), 0));
+    std::unique_ptr<Girl> kuro(Girl::create(Who(1), int(Girl::Id::MATSUMI_KURO)));
+    std::unique_ptr<Girl> copy(kuro->clone());
+    assert(doge->hooks().none());
+    assert(kuro->hooks().count() == 2 && kuro->hooks().test(Girl::ON_DRAW)
+           && kuro->hooks().test(Girl::ON_DISCARDED));
+    assert(copy->hooks() == kuro->hooks());
+
+    // seat 0 subscribes both, seat 1 only discards, seats 2 and 3 none
+    Girl::Hooks both;
+    both.set(Girl::ON_DRAW);
+    both.set(Girl::ON_DISCARDED);
+    Girl::Hooks discardOnly;
+    discardOnly.set(Girl::ON_DISCARDED);
+    std::array<std::array<int, 2>, 4> counts {};
+    std::array<std::unique_ptr<Girl>, 4> girls;
+    girls[0].reset(new CountGirl(Who(0), both, counts[0]));
+    girls[1].reset(new CountGirl(Who(1), discardOnly, counts[1]));
+    girls[2].reset(new CountGirl(Who(2), Girl::Hooks(), counts[2]));
+    girls[3].reset(Girl::create(Who(3), 0));
+
+    std::array<std::unique_ptr<Ai>, 4> ais;
+    std::array<TableOperator*, 4> ops;
+    for (int w = 0; w < 4; w++) {
+        ais[w].reset(Ai::create(Who(w), Girl::Id::DOGE));
+        ops[w] = ais[w].get();
+    }
+
+    std::array<int, 4> points { 25000, 25000, 25000, 25000 };
+    Table table(points, std::move(girls), ops, std::vector<TableObserver*>(), RuleInfo(), Who(0));
+    table.start();
+
+    assert(counts[0][0] > 0 && counts[0][1] > 0);
+    assert(counts[1][0] == 0 && counts[1][1] == counts[0][1]);
+    assert(counts[2][0] == 0 && counts[2][1] == 0);
+}
+
+namespace
+{
+
+///
+/// \brief Play a table of four DOGE girls to the end, 'makeAi' seats the AIs
+/// \return The AIs, to look into them after the game
+///
+std::array<std::unique_ptr<Ai>, 4> playTable(const RuleInfo &rule,
+                                             const std::function<Ai *(Who)> &makeAi,
+                                             const std::vector<TableObserver*> &obs
+                                                 = std::vector<TableObserver*>())
+{
+    std::array<int, 4> points { 25000, 25000, 25000, 25000 };
+    std::array<int, 4> girlIds { 0, 0, 0, 0 };
+    std::array<std::unique_ptr<Ai>, 4> ais;
+    std::array<TableOperator*, 4> ops;
+    for (int w = 0; w < 4; w++) {
+        ais[w].reset(makeAi(Who(w)));
+        ops[w] = ais[w].get();
+    }
+
+    Table table(points, girlIds, ops, obs, rule, Who(0));
+    table.start();
+    return ais;
+}
+
+Ai *makeDoge(Who who)
+{
+    return Ai::create(who, Girl::Id::DOGE);
+}
+
+} // namespace
+
+void testReplay()
+{
+    TestScope test("replay", true);
+
+    Replay replay;
+    playTable(RuleInfo(), makeDoge, std::vector<TableObserver*> { &replay });
+
+    ReplayColumns cols = ReplayColumns::extract(replay);
+    assert(cols.size() > 0);
+    assert(cols.hands.size() == cols.size() * ReplayColumns::CELLS);
+    assert(cols.rivers.size() == cols.size() * ReplayColumns::SEATS * ReplayColumns::CELLS);
+
+    for (size_t r = 0; r < cols.size(); r++) {
+        int closed = 0;
+        for (int i = 0; i < ReplayColumns::CELLS; i++)
+            closed += cols.hands[r * ReplayColumns::CELLS + i];
+        assert(closed % 3 == (cols.drawns[r] >= 0 ? 1 : 2));
+    }
+
+    std::stringstream ss;
+    cols.write(ss);
+    ReplayColumns back;
+    bool readOk = back.read(ss);
+    assert(readOk);
+    (void) readOk;
+    assert(back.size() == cols.size());
+    assert(back.remains == cols.remains && back.outs == cols.outs);
+
+    std::ostringstream json;
+    ReplayJson::write(json, replay);
+    const std::string doc = json.str();
+    Replay parsed;
+    int parsedCt = 0;
+    for (int i = 0; i < 2; i++) // the second read refills a used replay
+        parsedCt += ReplayJson::read(doc.data(), doc.data() + doc.size(), parsed);
+    assert(parsedCt == 2);
+    (void) parsedCt;
+
+    std::ostringstream again;
+    ReplayJson::write(again, parsed);
+    assert(again.str() == doc);
+    assert(parsed.rounds.size() == replay.rounds.size());
+    TableSnap last = parsed.look(0, 1000);
+    TableSnap orig = replay.look(0, 1000);
+    for (int w = 0; w < 4; w++)
+        assert(last[w].barks.size() == orig[w].barks.size());
+    (void) last;
+    (void) orig;
+    for (size_t r = 0; r < replay.rounds.size(); r++) {
+        TableSnap back = parsed.look(static_cast<int>(r), 1000);
+        TableSnap recorded = replay.look(static_cast<int>(r), 1000);
+        assert(back.spells.size() == recorded.spells.size());
+        for (size_t i = 0; i < back.spells.size(); i++) {
+            assert(std::strcmp(back.spells[i].data(), recorded.spells[i].data()) == 0);
+            assert(std::strcmp(back.charges[i].data(), recorded.charges[i].data()) == 0);
+        }
+        (void) back;
+        (void) recorded;
+    }
+    bool cutOk = ReplayJson::read(doc.data(), doc.data() + doc.size() / 2, parsed);
+    assert(!cutOk);
+    (void) cutOk;
+
+    std::string foreign(doc);
+    foreign.insert(foreign.find('{') + 1, "\"aForeignKeyLongerThanAnyOfOurOwnKeys\":[1,{\"x\":2}],"
+                                          "\"bigForeign\":123456789012345678901234567890,");
+    bool foreignOk = ReplayJson::read(foreign.data(), foreign.data() + foreign.size(), parsed);
+    assert(foreignOk);
+    (void) foreignOk;
+
+    again.str("");
+    ReplayJson::write(again, parsed);
+    assert(again.str() == doc);
+
+    // own numbers out of their range are rejected, not wrapped
+    for (const char *big : { "4294967296", "99999999999999999999", "-1" }) {
+        std::string wide(doc);
+        size_t at = wide.find("\"seed\":") + 7;
+        wide.replace(at, wide.find_first_of(",}", at) - at, big);
+        bool wideOk = ReplayJson::read(wide.data(), wide.data() + wide.size(), parsed);
+        assert(!wideOk);
+        (void) wideOk;
+    }
+}
+
+namespace
+{
+
+///
+/// \brief A short round with an ankan from hand, an ankan of the drawn tile,
+///        and a kakan from hand, all with a drawn tile left to merge
+///
+Replay kanReplay()
+{
+    using In = Replay::In;
+    using Out = Replay::Out;
+    auto tiles = [](std::initializer_list<const char *> strs) {
+        std::array<T37, 13> res;
+        int i = 0;
+        for (const char *str : strs)
+            res[i++] = T37(str);
+        return res;
+    };
+
+    Replay replay;
+    replay.initPoints = { 25000, 25000, 25000, 25000 };
+    replay.rounds.emplace_back();
+    Replay::Round &round = replay.rounds.back();
+    round.round = 0;
+    round.extraRound = 0;
+    round.dealer = Who(0);
+    round.allLast = false;
+    round.deposit = 0;
+    round.state = 0;
+    round.die1 = 1;
+    round.die2 = 1;
+    round.resultPoints = replay.initPoints;
+    round.drids = { T37("1p"), T37("2p"), T37("3p"), T37("4p") };
+
+    std::array<Replay::Track, 4> &tracks = round.tracks;
+    tracks[0].init = tiles({ "1m", "1m", "1m", "1m", "2p", "2p", "2p",
+                             "9s", "1f", "2f", "3f", "4f", "1y" });
+    tracks[0].in = { Replay::InAct(In::DRAW, T37("3s")), Replay::InAct(In::DRAW, T37("2p")),
+                     Replay::InAct(In::DRAW, T37("9s")), Replay::InAct(In::DRAW, T37("3y")) };
+    tracks[0].out = { Replay::OutAct(Out::ANKAN, T37("1m")), Replay::OutAct(Out::ANKAN, T37("2p")),
+                      Replay::OutAct(Out::ADVANCE, T37("1f")), Replay::OutAct(Out::SPIN) };
+
+    tracks[1].init = tiles({ "1f", "1f", "1f", "1s", "2s", "4s", "5s",
+                             "6s", "7s", "8s", "2y", "2y", "9m" });
+    tracks[1].in = { Replay::InAct(In::PON, 0), Replay::InAct(In::DRAW, T37("9m")),
+                     Replay::InAct(In::DRAW, T37("3m")) };
+    tracks[1].out = { Replay::OutAct(Out::ADVANCE, T37("9m")), Replay::OutAct(Out::KAKAN, T37("1f")),
+                      Replay::OutAct(Out::SPIN) };
+
+    tracks[2].init = tiles({ "1p", "3p", "4p", "5p", "6p", "7p", "8p",
+                             "9p", "2m", "3m", "4m", "5m", "6m" });
+    tracks[2].in = { Replay::InAct(In::DRAW, T37("8m")) };
+    tracks[2].out = { Replay::OutAct(Out::SPIN) };
+
+    tracks[3].init = tiles({ "3p", "3p", "3p", "4p", "4p", "4p", "5p",
+                             "5p", "5p", "6p", "6p", "6p", "7p" });
+    tracks[3].in = { Replay::InAct(In::DRAW, T37("9p")) };
+    tracks[3].out = { Replay::OutAct(Out::SPIN) };
+
+    return replay;
+}
+
+void checkHand(const PlayerSnap &player, std::initializer_list<T37> t37s)
+{
+    auto expect = TileCount(t37s).t37s13(true);
+    assert(expect.size() == player.hand.size());
+    for (size_t i = 0; i < expect.size(); i++)
+        assert(expect[i] == player.hand[i] && expect[i].isAka5() == player.hand[i].isAka5());
+    (void) player;
+}
+
+void checkSameSnap(const TableSnap &a, const TableSnap &b)
+{
+    for (int w = 0; w < 4; w++) {
+        assert(a[w].hand.size() == b[w].hand.size());
+        assert(a[w].barks.size() == b[w].barks.size());
+        assert(a[w].river.size() == b[w].river.size());
+        for (size_t i = 0; i < a[w].hand.size(); i++)
+            assert(a[w].hand[i] == b[w].hand[i]);
+        for (size_t i = 0; i < a[w].river.size(); i++)
+            assert(a[w].river[i] == b[w].river[i]);
+    }
+
+    assert(a.whoDrawn == b.whoDrawn && a.wallRemain == b.wallRemain);
+    assert(a.deadRemain == b.deadRemain && a.drids.size() == b.drids.size());
+    (void) a;
+    (void) b;
+}
+
+} // namespace
+
+void testReplayLook()
+{
+    TestScope test("replay-look");
+
+    Replay replay = kanReplay();
+
+    // ankan of four in hand, the drawn 3s merges into the hand
+    TableSnap snap = replay.look(0, 2);
+    checkHand(snap[0], { T37("2p"), T37("2p"), T37("2p"), T37("9s"), T37("1f"), T37("2f"),
+                         T37("3f"), T37("4f"), T37("1y"), T37("3s") });
+    assert(snap[0].barks.size() == 1 && snap[0].barks[0].type() == M37::Type::ANKAN);
+    assert(!snap.whoDrawn.somebody());
+
+    // ankan of the drawn 2p with three in hand
+    snap = replay.look(0, 4);
+    checkHand(snap[0], { T37("9s"), T37("1f"), T37("2f"), T37("3f"), T37("4f"),
+                         T37("1y"), T37("3s") });
+    assert(snap[0].barks.size() == 2 && snap[0].barks[1].type() == M37::Type::ANKAN);
+    assert(snap.drids.size() == 3);
+
+    // kakan from hand, the drawn 9m merges into the hand
+    snap = replay.look(0, 16);
+    checkHand(snap[1], { T37("1s"), T37("2s"), T37("4s"), T37("5s"), T37("6s"),
+                         T37("7s"), T37("8s"), T37("2y"), T37("2y"), T37("9m") });
+    assert(snap[1].barks.size() == 1 && snap[1].barks[0].type() == M37::Type::KAKAN);
+    assert(snap[1].river.size() == 1 && snap[0].river.size() == 1);
+    assert(!snap.whoDrawn.somebody());
+
+    // a long turn then a short turn into the same snap
+    TableSnap reused;
+    replay.look(reused, 0, 18);
+    assert(reused[1].river.size() == 2 && reused.endOfRound == false);
+    for (int turn = 18; turn >= 0; turn--) {
+        replay.look(reused, 0, turn);
+        checkSameSnap(reused, replay.look(0, turn));
+    }
+    assert(reused[0].barks.empty() && reused[1].barks.empty());
+    assert(reused[0].river.empty() && reused[1].river.empty());
+    checkHand(reused[0], { T37("1m"), T37("1m"), T37("1m"), T37("1m"), T37("2p"), T37("2p"),
+                           T37("2p"), T37("9s"), T37("1f"), T37("2f"), T37("3f"), T37("4f"),
+                           T37("1y") });
+}
+
+namespace
+{
+
+///
+/// \brief AiRollout that records its search, and checks the greedy fallback
+///
+class RolloutCheckAi : public AiRollout
+{
+public:
+    RolloutCheckAi(Who who, const Budget &budget, bool mustFallBack)
+        : AiRollout(who, budget)
+        , mMustFallBack(mustFallBack)
+    {
+    }
+
+    int maxIterations() const
+    {
+        return mMaxIterations;
+    }
+
+protected:
+    Action think(const TableView &view, Limits &limits) override
+    {
+        Limits copy(limits);
+        Action greedy = Ai::think(view, copy);
+        Action res = AiRollout::think(view, limits);
+        assert(!mMustFallBack || res == greedy);
+        mMaxIterations = std::max(mMaxIterations, lastStats().iterations);
+        return res;
+    }
+
+private:
+    bool mMustFallBack;
+    int mMaxIterations = 0;
+};
+
+} // namespace
+
+void testAiRollout()
+{
+    TestScope test("ai-rollout");
+
+    RuleInfo rule;
+    rule.roundLimit = 1;
+
+    // the time limit is soft, a started pass of rollouts is finished
+    const long long slackMicros = 500 * 1000;
+
+    AiRollout::Budget budget;
+    budget.minRollouts = 1;
+    budget.maxRollouts = 1;
+    auto ais = playTable(rule, [&budget](Who who) -> Ai * {
+        if (who != Who(0))
+            return makeDoge(who);
+        Ai *ai = new RolloutCheckAi(who, budget, false);
+        ai->setTimeLimit(1000);
+        return ai;
+    });
+
+    const RolloutCheckAi &searched = static_cast<const RolloutCheckAi &>(*ais[0]);
+    assert(searched.maxIterations() > 0);
+    assert(searched.lastStats().micros <= 1000 * 1000 + slackMicros);
+    (void) searched;
+
+    // no time for the minimum rollouts, must always fall back to greedy
+    budget.minRollouts = 1000;
+    budget.maxRollouts = 1000;
+    ais = playTable(rule, [&budget](Who who) -> Ai * {
+        if (who != Who(0))
+            return makeDoge(who);
+        Ai *ai = new RolloutCheckAi(who, budget, true);
+        ai->setTimeLimit(1);
+        return ai;
+    });
+
+    assert(ais[0]->lastStats().micros <= 1000 + slackMicros);
+    (void) slackMicros;
+}
+
+namespace
+{
+
+TileCount hiddenOf(const Hand &hand)
+{
+    TileCount res(hand.closed());
+    if (hand.hasDrawn())
+        res.inc(hand.drawn(), 1);
+    return res;
+}
+
+///
+/// \brief Forks the table from seat 0's view at every draw, and checks the redeal
+///
+class ForkCheckOb : public TableObserver
+{
+public:
+    void onDrawn(const Table &table, Who who) override
+    {
+        (void) who;
+        TableView view = table.getView(Who(0));
+        std::array<TableOperator*, 4> ops { nullptr, nullptr, nullptr, nullptr };
+        std::vector<TableObserver*> obs;
+        Mount wall(table.getMount());
+        wall.forget();
+
+        for (uint32_t seed = 1; seed <= 4; seed++) {
+            Table fork(view, ops, obs, seed);
+
+            // the hidden tiles are only moved among the wall and the hands
+            for (const T37 &t : tiles37::ORDER37) {
+                int real = wall.remainA(t);
+                int forked = fork.getMount().remainA(t);
+                for (int w = 1; w < 4; w++) {
+                    real += hiddenOf(table.getHand(Who(w))).ct(t);
+                    forked += hiddenOf(fork.getHand(Who(w))).ct(t);
+                }
+
+                assert(forked == real);
+                assert(fork.getHand(Who(0)).closed().ct(t) == table.getHand(Who(0)).closed().ct(t));
+            }
+
+            for (int w = 1; w < 4; w++)
+                checkRedeal(table.getHand(Who(w)), fork.getHand(Who(w)), wall,
+                            table.riichiEstablished(Who(w)), w);
+        }
+    }
+
+    int riichiForks() const
+    {
+        return mRiichiForks;
+    }
+
+    int riichiRedeals() const
+    {
+        return mRiichiRedeals;
+    }
+
+    ///
+    /// \brief Redealt tiles that were not in the wall nor in the player's own hand
+    ///
+    int foreigns(Who who) const
+    {
+        return mForeigns[who.index()];
+    }
+
+private:
+    void checkRedeal(const Hand &orig, const Hand &hand, const Mount &wall, bool riichi, int w)
+    {
+        TileCount real(hiddenOf(orig));
+        TileCount dealt(hiddenOf(hand));
+        for (int ti = 0; ti < 34; ti++)
+            mForeigns[w] += dealt.ct(T34(ti)) > wall.remainA(T34(ti)) + real.ct(T34(ti));
+
+        if (!riichi || orig.waitMask() == 0) // not between rounds
+            return;
+
+        assert(Hand(hand.closed(), hand.barks()).ready());
+        auto origs = orig.closed().t37s13(true);
+        auto tiles = hand.closed().t37s13(true);
+        mRiichiForks++;
+        mRiichiRedeals += !std::equal(origs.begin(), origs.end(), tiles.begin());
+    }
+
+private:
+    int mRiichiForks = 0;
+    int mRiichiRedeals = 0;
+    std::array<int, 4> mForeigns {};
+};
+
+} // namespace
+
+void testTableFork()
+{
+    TestScope test("table-fork");
+
+    ForkCheckOb check;
+    RuleInfo rule;
+    rule.roundLimit = 2;
+    playTable(rule, makeDoge, std::vector<TableObserver*> { &check });
+
+    assert(check.riichiForks() == 0 || check.riichiRedeals() > 0);
+    for (int w = 1; w < 4; w++)
+        assert(check.foreigns(Who(w)) > 0);
+}
+
+namespace
+{
+
+///
+/// \brief DangerMap::chance() the slow way, recounting for each call
+///
+int slowChance(const TableView &view, Who tar, T34 t)
+{
+    if (view.genbutsu(tar, t))
+        return 0;
+
+    util::Stactor<T34, 5> waiters;
+    waiters.pushBack(t);
+    if (t.isNum()) {
+        int v = t.val();
+        if (v > 1)
+            waiters.pushBack(t.prev());
+        if (v > 2 && !(v >= 4 && view.genbutsu(tar, t.prev().pprev())))
+            waiters.pushBack(t.pprev());
+        if (v < 8 && !(v <= 6 && view.genbutsu(tar, t.next().nnext())))
+            waiters.pushBack(t.nnext());
+        if (v < 9)
+            waiters.pushBack(t.next());
+    }
+
+    return std::min(DangerMap::MAX_CHANCE, view.visibleRemain().ct(waiters));
+}
+
+///
+/// \brief Ai that checks DangerMap against slowChance() all along,
+///        and the incremental WaitEstimate against a rebuilt one
+///
+class DangerCheckAi : public Ai
+{
+public:
+    explicit DangerCheckAi(Who who) : Ai(who) { }
+
+protected:
+    Action think(const TableView &view, Limits &limits) override
+    {
+        util::Stactor<Who, 3> others;
+        for (int w = 0; w < 4; w++)
+            if (Who(w) != mSelf)
+                others.pushBack(Who(w));
+
+        Choices::Mode mode = view.myChoices().mode();
+        if (mode == Choices::Mode::DRAWN || mode == Choices::Mode::BARK)
+            assert(view.waitEstimate() == WaitEstimate(view));
+
+        DangerMap danger(view, others);
+        for (int r = 0; r < danger.rows(); r++) {
+            for (int ti = 0; ti < 34; ti++) {
+                T34 t(ti);
+                int slow = slowChance(view, others[r], t);
+                assert(danger.chance(r, t) == slow);
+                (void) slow;
+                assert(danger.chance(r, t) <= danger.waiterRemain(t));
+                assert(!danger.suji(r, t) || t.isNum());
+            }
+        }
+
+        return Ai::think(view, limits);
+    }
+};
+
+} // namespace
+
+void testDanger()
+{
+    TestScope test("danger");
+
+    RuleInfo rule;
+    rule.roundLimit = 4;
+    playTable(rule, [](Who who) -> Ai * { return new DangerCheckAi(who); });
+}
+
+namespace
+{
+
+///
+/// \brief Ai that evaluates all its discards by DiscardEv on the way
+///
+class DiscardEvCheckAi : public Ai
+{
+public:
+    explicit DiscardEvCheckAi(Who who) : Ai(who), mEv(2) { }
+
+protected:
+    Action think(const TableView &view, Limits &limits) override
+    {
+        const Choices &choices = view.myChoices();
+        if (choices.mode() == Choices::Mode::DRAWN && !view.riichiEstablished(mSelf)) {
+            for (const Action &out : listOuts(view, limits)) {
+                DiscardEv::Ev ev = mEv.evaluate(view, out);
+                assert(0.0 <= ev.agari && ev.agari <= ev.tenpai && ev.tenpai <= 1.0 + 1e-9);
+                assert(ev.gain >= 0.0);
+                bool ready = view.myHand().peekDiscard(out, &Hand::ready);
+                assert(!ready || ev.tenpai == 1.0);
+                (void) ready;
+
+                long long hits = mEv.hits();
+                DiscardEv::Ev again = mEv.evaluate(view, out);
+                assert(mEv.hits() == hits + 1);
+                assert(again.gain == ev.gain && again.agari == ev.agari);
+                (void) hits;
+                (void) ev;
+                (void) again;
+            }
+        }
+
+        return Ai::think(view, limits);
+    }
+
+private:
+    DiscardEv mEv;
+};
+
+} // namespace
+
+void testDiscardEv()
+{
+    TestScope test("discard-ev");
+
+    RuleInfo rule;
+    rule.roundLimit = 1;
+    playTable(rule, [](Who who) {
+        return who == Who(0) ? new DiscardEvCheckAi(who) : makeDoge(who);
+    });
+}
+
+namespace
+{
+
+///
+/// \brief Ai that checks listCpOptions() against canCp() and peekCp()
+///
+class CpCheckAi : public Ai
+{
+public:
+    explicit CpCheckAi(Who who) : Ai(who) { }
+
+protected:
+    Action think(const TableView &view, Limits &limits) override
+    {
+        using AC = ActCode;
+
+        const Choices &choices = view.myChoices();
+        if (choices.mode() == Choices::Mode::BARK) {
+            const Hand &hand = view.myHand();
+            const Choices::ModeBark &mode = choices.bark();
+            const T37 &pick = view.getFocusTile();
+
+            util::Stactor<Action, 44> expect;
+            for (const T37 &out : tiles37::ORDER37) {
+                if (hand.closed().ct(out) == 0)
+                    continue;
+                const bool ons[4] = { mode.chiiL, mode.chiiM, mode.chiiR, mode.pon };
+                const AC acs[4] = { AC::CHII_AS_LEFT, AC::CHII_AS_MIDDLE, AC::CHII_AS_RIGHT, AC::PON };
+                for (int i = 0; i < 4; i++) {
+                    Action act(acs[i], 2, out);
+                    if (ons[i] && hand.canCp(pick, act))
+                        expect.pushBack(act);
+                }
+            }
+
+            auto opts = listCpOptions(hand, mode, pick);
+            assert(opts.size() == expect.size());
+            for (size_t i = 0; i < opts.size(); i++) {
+                assert(opts[i].act == expect[i]);
+                assert(opts[i].step == hand.peekCp(pick, expect[i], &Hand::step));
+            }
+        }
+
+        return Ai::think(view, limits);
+    }
+};
+
+} // namespace
+
+void testListCp()
+{
+    TestScope test("list-cp");
+
+    RuleInfo rule;
+    rule.roundLimit = 4;
+    playTable(rule, [](Who who) -> Ai * { return new CpCheckAi(who); });
+}
+
+void testFarm()
+{
+    TestScope test("farm");
+
+    // batched steps against scalar ones, on random hands
+    Rand rand;
+    rand.set(12345);
+    StepBatch batch;
+    std::vector<TileCount> hands;
+    std::vector<int> barkCts;
+    for (int i = 0; i < 2000; i++) {
+        int barkCt = rand.gen(3);
+        int size = 13 - 3 * barkCt + rand.gen(2);
+        TileCount hand;
+        while (hand.sum() < size) {
+            T34 t(rand.gen(34));
+            if (hand.ct(t) < 4)
+                hand.inc(T37(t.id34()), 1);
+        }
+
+        batch.add(hand, barkCt);
+        hands.push_back(hand);
+        barkCts.push_back(barkCt);
+    }
+
+    batch.evaluate();
+    for (size_t i = 0; i < hands.size(); i++)
+        assert(batch.step(static_cast<int>(i)) == hands[i].step(barkCts[i]));
+
+    RuleInfo rule;
+    rule.roundLimit = 1;
+    Farm farm(8, rule, std::array<int, 4> { 0, 0, 0, 0 });
+    farm.run();
+
+    assert(farm.stats().decisions > 0);
+    assert(farm.stats().batches < farm.stats().decisions);
+    for (size_t i = 0; i < farm.size(); i++) {
+        const std::array<int, 4> &points = farm.table(static_cast<int>(i)).getPoints();
+        assert(points[0] + points[1] + points[2] + points[3] <= 100000);
+        (void) points;
+    }
+}
+
+void testGenIndex()
+{
+    TestScope test("gen-index");
+
+    Rand rand;
+    rand.set(54321);
+    RuleInfo rule;
+    GenIndex index(rule);
+
+    const int cases[][4] = { // fu, han, self wind, round wind
+        { 30, 1, 2, 1 }, { 40, 2, 1, 1 }, { 70, 1, 3, 2 }, { 90, 2, 2, 1 }, { 110, 1, 1, 1 }
+    };
+
+    for (const auto &c : cases) {
+        for (bool ron : { true, false }) {
+            if (c[0] == 110 && !ron)
+                continue; // rare enough to make the test slow
+            for (int i = 0; i < 8; i++) {
+                Gen gen = index.genForm4FuHan(rand, c[0], c[1], c[2], c[3], ron);
+                assert(gen.form.fu() == c[0] && gen.form.han() == c[1]);
+                (void) gen;
+            }
+            assert(index.bucketSize(c[0], c[1], c[2], c[3], ron) > 0);
+        }
+    }
+
+    for (int i = 0; i < 8; i++) {
+        Gen gen = index.genForm4Mangan(rand, 4, 2, 1, true);
+        assert(gen.form.han() == 4 && gen.form.gain() >= 8000);
+        (void) gen;
+    }
+
+    // a thin bucket keeps growing with use instead of freezing
+    GenIndex small(rule, 4);
+    small.genForm4FuHan(rand, 70, 1, 3, 2, true);
+    for (int i = 0; i < 64 && small.bucketSize(70, 1, 3, 2, true) < 4; i++)
+        small.genForm4FuHan(rand, 70, 1, 3, 2, true);
+    assert(small.bucketSize(70, 1, 3, 2, true) == 4);
+}
+
+namespace
+{
+
+void checkWaits(const Hand &hand)
+{
+    int barkCt = static_cast<int>(hand.barks().size());
+    uint64_t mask = hand.waitMask();
+
+    for (int ti = 0; ti < 34; ti++) {
+        T34 t(ti);
+        bool wait = hand.closed().peekDraw(t, &TileCount::step, barkCt) == -1;
+        assert(wait == static_cast<bool>((mask >> ti) & 1));
+        (void) wait;
+    }
+    (void) mask;
+
+    if (!hand.hasDrawn()) {
+        bool ready = hand.step7() == 0 || hand.step13() == 0
+                || (hand.step4() == 0
+                    && util::any(hand.effA(), [&hand](T34 t) { return hand.ct(t) < 4; }));
+        assert(hand.ready() == ready);
+        (void) ready;
+    }
+}
+
+} // namespace
+
+void testHandWaits()
+{
+    TestScope test("hand-waits");
+
+    Rand rand;
+    RuleInfo rule;
+
+    for (int round = 0; round < 100; round++) {
+        Hand hand = Gen::genForm4(rand, 30, 0, 30, 1, 1, rule, true).hand;
+        checkWaits(hand);
+
+        for (int turn = 0; turn < 12 && hand.barks().size() < 4; turn++) {
+            T37 in(rand.gen(34));
+            if (hand.ct(in) == 4)
+                continue;
+
+            if (hand.canPon(in) && rand.gen(4) == 0) {
+                hand.pon(in, 0, 0);
+                T37 out = hand.closed().t37s13()[0];
+                hand.barkOut(out);
+                checkWaits(hand);
+                continue;
+            }
+
+            hand.draw(in);
+            checkWaits(hand);
+
+            util::Stactor<T37, 13> outs = hand.closed().t37s13();
+            T37 out = outs[rand.gen(static_cast<int32_t>(outs.size()))];
+            uint64_t peeked = hand.peekSwap(out, &Hand::waitMask);
+            bool peekedReady = hand.peekSwap(out, &Hand::ready);
+            checkWaits(hand); // peek leaves the cache as it was
+
+            if (rand.gen(3) == 0) {
+                hand.spinOut();
+            } else {
+                hand.swapOut(out);
+                assert(hand.waitMask() == peeked && hand.ready() == peekedReady);
+            }
+            (void) peeked;
+            (void) peekedReady;
+
+            checkWaits(hand);
+        }
+    }
+}
+
+void testChoicesDrawn()
+{
+    TestScope test("choices-drawn");
+
+    Rand rand;
+    RuleInfo rule;
+    PointInfo info;
+    info.selfWind = 1;
+    info.roundWind = 1;
+
+    for (int round = 0; round < 100; round++) {
+        Gen gen = Gen::genForm4(rand, 30, 20, 30, 1, 1, rule, false);
+        Hand hand = gen.hand;
+        if (!hand.hasDrawn())
+            hand.draw(gen.pick);
+
+        bool riichied = rand.gen(4) == 0;
+        Choices::ModeDrawn mode(hand, info, rule, !riichied, true, riichied);
+
+        assert(mode.tsumo() == hand.canTsumo(info, rule));
+        assert(!mode.tsumo() || mode.mayTsumo());
+
+        util::Stactor<T37, 13> swaps;
+        bool spin = false;
+        if (!riichied)
+            hand.canRiichi(swaps, spin);
+        assert(mode.spinRiichi() == spin);
+        assert(mode.swapRiichis().size() == swaps.size());
+        assert(!(spin || !swaps.empty()) || mode.mayRiichi());
+
+        util::Stactor<T34, 3> ankans;
+        util::Stactor<int, 3> kakans;
+        hand.canAnkan(ankans, riichied);
+        hand.canKakan(kakans);
+        assert(mode.ankans().size() == ankans.size());
+        assert(mode.kakans().size() == kakans.size());
+
+        mode.banRiichi();
+        assert(!mode.spinRiichi() && mode.swapRiichis().empty());
+    }
+}
+
+void testFormWaits()
+{
+    TestScope test("form-waits");
+
+    Rand rand;
+    RuleInfo rule;
+
+    auto same = [](const Form &a, const Form &b) {
+        return a.yakus() == b.yakus() && a.fu() == b.fu() && a.han() == b.han()
+                && a.base() == b.base() && a.dora() == b.dora() && a.akadora() == b.akadora();
+    };
+
+    for (int round = 0; round < 100; round++) {
+        PointInfo info;
+        info.selfWind = 1 + rand.gen(4);
+        info.roundWind = 1 + rand.gen(2);
+        Gen gen = Gen::genForm4(rand, 30, 10, 40, info.selfWind, info.roundWind, rule, true);
+        const Hand &ready = gen.hand;
+        info.riichi = ready.isMenzen() ? rand.gen(2) : 0;
+
+        util::Stactor<T37, 5> drids { T37(rand.gen(34)), T37(rand.gen(34)) };
+        std::vector<Form::WaitScore> wss = Form::scoreWaits(ready, info, rule, drids);
+
+        util::Stactor<T34, 34> waits = ready.effA();
+        assert(wss.size() == waits.size());
+
+        int barkCt = static_cast<int>(ready.barks().size());
+        TileCount::Wait4Splits splits = ready.closed().splitWait4(barkCt);
+        for (T34 t : waits) {
+            if (ready.closed().peekDraw(t, &TileCount::step4, barkCt) != -1)
+                continue; // 7-pair wait only
+
+            TileCount::Explain4Closeds shared = TileCount::explain4(t, splits);
+            TileCount::Explain4Closeds alone = ready.closed().explain4(t);
+            assert(shared.size() == alone.size());
+            for (size_t i = 0; i < shared.size(); i++) {
+                assert(shared[i].pair == alone[i].pair);
+                assert(shared[i].triplets.size() == alone[i].triplets.size());
+                assert(std::equal(shared[i].triplets.begin(), shared[i].triplets.end(),
+                                  alone[i].triplets.begin()));
+                assert(std::equal(shared[i].sequences.begin(), shared[i].sequences.end(),
+                                  alone[i].sequences.begin(), alone[i].sequences.end()));
+            }
+        }
+
+        for (size_t i = 0; i < wss.size(); i++) {
+            const Form::WaitScore &ws = wss[i];
+            assert(ws.pick == waits[i]);
+
+            T37 pick(ws.pick.id34());
+            assert(same(ws.ron, Form(ready, pick, info, rule, drids)));
+
+            Hand full(ready);
+            full.draw(pick);
+            assert(same(ws.tsumo, Form(full, info, rule, drids)));
+        }
+    }
+    (void) same;
+}
+
+void testFormText()
+{
+    TestScope test("form-text");
+
+    Rand rand;
+    RuleInfo rule;
+
+    {
+        using namespace tiles37;
+        TileCount pinfu { 1_m, 2_m, 3_m, 2_p, 3_p, 4_p, 3_s, 4_s, 5_s, 4_s, 5_s, 7_s, 7_s };
+        TileCount orphans { 1_m, 1_m, 9_m, 1_p, 9_p, 1_s, 1_f, 2_f, 3_f, 4_f, 1_y, 2_y, 3_y };
+        PointInfo dealer;
+        dealer.selfWind = 1;
+        dealer.roundWind = 1;
+        dealer.extraRound = 2;
+        PointInfo south(dealer);
+        south.selfWind = 2;
+        south.extraRound = 1;
+
+        Form ron(Hand(pinfu), 6_s, dealer, rule);
+        assert(ron.spell() == "PnfNmi" && ron.charge() == "30Fu 1Han 2Hb   2100");
+
+        Hand full(pinfu);
+        full.draw(6_s);
+        Form tsumo(full, dealer, rule);
+        assert(tsumo.spell() == "Ptm" && tsumo.charge() == "20Fu 2Han 2Hb   900All");
+
+        Form yakuman(Hand(orphans), 9_s, south, rule);
+        assert(yakuman.spell() == "X13  " && yakuman.charge() == "1Hb   Ykm 32300");
+    }
+
+    for (int round = 0; round < 200; round++) {
+        PointInfo info;
+        info.selfWind = 1 + rand.gen(4);
+        info.roundWind = 1 + rand.gen(2);
+        info.extraRound = rand.gen(3);
+        Gen gen = Gen::genForm4(rand, 30, 10, 40, info.selfWind, info.roundWind, rule, true);
+        util::Stactor<T37, 5> drids { T37(rand.gen(34)) };
+
+        for (const Form::WaitScore &ws : Form::scoreWaits(gen.hand, info, rule, drids)) {
+            for (const Form *form : { &ws.ron, &ws.tsumo }) {
+                const std::string spell = form->spell();
+                const std::string charge = form->charge();
+
+                char buf[Form::SPELL_BUF];
+                assert(form->spell(buf, sizeof(buf)) == spell.size() && buf == spell);
+                assert(form->charge(buf, sizeof(buf)) == charge.size() && buf == charge);
+
+                char small[4];
+                assert(form->charge(small, sizeof(small)) == charge.size());
+                assert(charge.compare(0, 3, small) == 0);
+                (void) buf;
+                (void) small;
+
+                Form back(form->digest());
+                assert(back.spell() == spell && back.charge() == charge);
+                assert(back.yakus() == form->yakus() && back.gain() == form->gain());
+            }
+        }
+    }
+}
+
+void testTokiEvents()
+{
+    TestScope test("toki-events");
+
+    using namespace tiles37;
+    TokiEvents events;
+    events.emplace_back(new TokiEventDrawn(1_m));
+    events.emplace_back(new TokiEventDiscarded(2_p, true));
+    events.emplace_back(new TokiEventDiscarded(0_s, false, true));
+    events.emplace_back(new TokiEventFlipped(3_y));
+
+    const std::string expect = "DRAW 1m\nDISCARD *2p 0sRII\nKANDORAINDIC 3y";
+    assert(events.str(Who(0)) == expect);
+
+    char buf[8];
+    assert(events.str(buf, sizeof(buf), Who(0)) == expect.size());
+    assert(expect.compare(0, 7, buf) == 0);
+    (void) buf;
+}
+
+void testMountBatch()
+{
+    TestScope test("mount-batch");
+
+    Rand rand;
+    for (int round = 0; round < 50; round++) {
+        std::array<int, 34> deltas;
+        for (int ti = 0; ti < 34; ti++)
+            deltas[ti] = rand.gen(3) == 0 ? 0 : rand.gen(400) - 100;
+
+        Mount single(TileCount::AKADORA4);
+        Mount batch(TileCount::AKADORA4);
+        Mount::Exit exit = round % 2 == 0 ? Mount::WALL : Mount::DORA;
+        bool bSpace = round % 3 == 0;
+        for (int ti = 0; ti < 34; ti++)
+            single.power(exit, 0, T34(ti), deltas[ti], bSpace);
+        batch.powerBatch(exit, 0, deltas, bSpace);
+
+        uint32_t state = static_cast<uint32_t>(rand.gen(1 << 30));
+        Rand r1;
+        Rand r2;
+        r1.set(state);
+        r2.set(state);
+        for (int i = 0; i < 20; i++)
+            assert(single.wallPop(r1).looksSame(batch.wallPop(r2)));
+        single.flipIndic(r1);
+        batch.flipIndic(r2);
+        assert(single.getDrids().back().looksSame(batch.getDrids().back()));
+    }
+
+    // an all-zero batch powers nothing, not even superposing the slot
+    Mount idle(TileCount::AKADORA4);
+    Mount zeroed(TileCount::AKADORA4);
+    zeroed.powerBatch(Mount::WALL, 0, std::array<int, 34> {}, false);
+    Rand r1;
+    Rand r2;
+    r1.set(7);
+    r2.set(7);
+    for (int i = 0; i < 20; i++)
+        assert(idle.wallPop(r1).looksSame(zeroed.wallPop(r2)));
+    assert(r1.state() == r2.state());
+}
+
+void testGenBatch()
+{
+    TestScope test("gen-batch");
+
+    RuleInfo rule;
+    auto gen = [&rule](Rand &rand) {
+        return Gen::genForm4FuHan(rand, 30, 2, 2, 1, rule, true);
+    };
+
+    const size_t count = 3 * Gen::BATCH_CHUNK + 5;
+    std::vector<Gen> single = Gen::genBatch(12345, count, gen, 1);
+    std::vector<Gen> multi = Gen::genBatch(12345, count, gen, 3);
+    assert(single.size() == count && multi.size() == count);
+
+    for (size_t i = 0; i < count; i++) {
+        assert(single[i].form.fu() == 30 && single[i].form.han() == 2);
+        assert(single[i].pick == multi[i].pick);
+        for (int ti = 0; ti < 34; ti++)
+            assert(single[i].hand.closed().ct(T34(ti)) == multi[i].hand.closed().ct(T34(ti)));
+    }
+}
+
+void testHandEnum()
+{
+    TestScope test("hand-enum");
+
+    // every one-suit closed agari shape, checked by brute force
+    HandEnum::Options opt;
+    opt.suits = 1 << static_cast<int>(Suit::M);
+    opt.maxBarks = 0;
+    opt.score = false;
+    HandEnum mans = HandEnum::run(opt, 4);
+
+    using Cts = std::array<int, 9>;
+    std::vector<Cts> found;
+    for (size_t row = 0; row < mans.size(); row++) {
+        Hand hand = mans.ready(row);
+        hand.draw(T37(mans.picks[row]));
+        if (row % 97 == 0)
+            assert(hand.step() == -1);
+        Cts cts;
+        for (int v = 1; v <= 9; v++)
+            cts[v - 1] = hand.closed().ct(T34(Suit::M, v)) + (hand.drawn() == T34(Suit::M, v));
+        found.push_back(cts);
+    }
+
+    std::sort(found.begin(), found.end());
+    size_t rows = found.size();
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    // smallest tile first is either a triplet or a sequence head
+    std::function<bool(Cts &, int)> melds = [&melds](Cts &cts, int i) {
+        while (i < 9 && cts[i] == 0)
+            i++;
+        if (i == 9)
+            return true;
+        bool ok = false;
+        if (cts[i] >= 3) {
+            cts[i] -= 3;
+            ok = melds(cts, i);
+            cts[i] += 3;
+        }
+        if (!ok && i <= 6 && cts[i + 1] > 0 && cts[i + 2] > 0) {
+            cts[i]--, cts[i + 1]--, cts[i + 2]--;
+            ok = melds(cts, i);
+            cts[i]++, cts[i + 1]++, cts[i + 2]++;
+        }
+        return ok;
+    };
+
+    auto agari = [&melds](Cts cts) {
+        if (std::count(cts.begin(), cts.end(), 2) == 7)
+            return true;
+        for (int p = 0; p < 9; p++) {
+            if (cts[p] >= 2) {
+                cts[p] -= 2;
+                bool ok = melds(cts, 0);
+                cts[p] += 2;
+                if (ok)
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<Cts> brutes;
+    size_t picks = 0;
+    Cts cts {};
+    std::function<void(int, int)> brute = [&](int v, int left) {
+        if (v == 9) {
+            if (left == 0 && agari(cts)) {
+                brutes.push_back(cts);
+                picks += std::count_if(cts.begin(), cts.end(), [](int c) { return c > 0; });
+            }
+            return;
+        }
+        for (int c = 0; c <= 4 && c <= left; c++) {
+            cts[v] = c;
+            brute(v + 1, left - c);
+        }
+    };
+    brute(0, 14);
+
+    assert(found == brutes);
+    assert(rows == picks);
+    (void) rows;
+
+    // thirteen orphans, 13 shapes with 13 picks each, all yakuman
+    opt = HandEnum::Options();
+    opt.form4 = false;
+    opt.form7 = false;
+    HandEnum orphans = HandEnum::run(opt, 2);
+    assert(orphans.size() == 13 * 13);
+    for (size_t row = 0; row < orphans.size(); row++)
+        assert(orphans.hans[row] < 0 && orphans.fans[row] >= 88);
+
+    // scored with barks, threading does not change the table
+    opt = HandEnum::Options();
+    opt.suits = (1 << static_cast<int>(Suit::F)) | (1 << static_cast<int>(Suit::Y));
+    opt.maxBarks = 2;
+    opt.ron = true;
+    HandEnum single = HandEnum::run(opt, 1);
+    HandEnum multi = HandEnum::run(opt, 4);
+    std::stringstream ss1, ss2;
+    single.write(ss1);
+    multi.write(ss2);
+    assert(single.size() > 0 && ss1.str() == ss2.str());
+
+    HandEnum back;
+    bool readOk = back.read(ss1);
+    assert(readOk);
+    (void) readOk;
+    assert(back.size() == single.size() && back.fans == single.fans);
+}
+
+void testFanIndex()
+{
+    TestScope test("fan-index");
+
+    HandEnum::Options opt;
+    opt.suits = (1 << static_cast<int>(Suit::F)) | (1 << static_cast<int>(Suit::Y));
+    opt.maxBarks = 2;
+    FanIndex index(opt);
+    assert(index.size() > 0);
+
+    Rand rand;
+    rand.set(777);
+
+    int hit = 0;
+    for (int fan = 1; fan <= 400; fan++) {
+        if (index.countFan(fan) == 0)
+            continue;
+        hit++;
+        for (int i = 0; i < 4; i++)
+            assert(index.genFan(rand, fan).form.fan() == fan);
+    }
+    assert(hit > 1);
+
+    // two fans of a sampled hand, then only hands with both
+    FormGb::Fans some = index.genFan(rand, 88).form.fans();
+    assert(some.size() >= 2);
+    FormGb::Fans must { some[0], some[1] };
+    assert(index.countFans(must) > 0);
+    assert(index.countFans(must) <= index.countFans({ some[0] }));
+    for (int i = 0; i < 8; i++) {
+        GenGb gen = index.genFans(rand, must);
+        assert(util::has(gen.form.fans(), some[0]) && util::has(gen.form.fans(), some[1]));
+    }
+
+    assert(index.countFans({}) == index.size());
+    assert(index.genFans(rand, {}).form.fan() > 0);
+
+    // a prebuilt table, scored by HandEnum, indexes the same
+    FanIndex prebuilt(HandEnum::run(opt), opt);
+    assert(prebuilt.size() == index.size());
+    for (int fan = 1; fan <= 400; fan++)
+        assert(prebuilt.countFan(fan) == index.countFan(fan));
+}
+
+void testFormGbSpeed()
+{
+    TestScope test("form-gb-speed", true);
+
+    HandEnum::Options opt;
+    opt.suits = (1 << static_cast<int>(Suit::P)) | (1 << static_cast<int>(Suit::Y));
+    opt.maxBarks = 1;
+    opt.score = false;
+    HandEnum table = HandEnum::run(opt);
+
+    PointInfo info;
+    info.selfWind = 2;
+    info.roundWind = 1;
+
+    int forms = 0;
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t row = 0; row < table.size(); row += 997) {
+        Hand hand = table.ready(row);
+        hand.draw(T37(table.picks[row]));
+        FormGb form(hand, info, false);
+        assert(form.fan() == form.fanSet().fan());
+        sum += form.fan();
+        forms++;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    util::p("formgb", forms, "forms,", us / forms, "us/form, fan sum", sum);
+}
+
 void testFormGb()
 {
     TestScope test("form-gb", true);
@@ -155,5 +1492,3 @@ void testFormGb()
 
 
 } // namespace saki
-
-
@@ -30,6 +30,26 @@ void testHand();
 void testForm();
 void testFormGb();
 void testTable();
+void testGirlHooks();
+void testReplay();
+void testReplayLook();
+void testAiRollout();
+void testTableFork();
+void testDanger();
+void testDiscardEv();
+void testListCp();
+void testFarm();
+void testGenIndex();
+void testHandWaits();
+void testChoicesDrawn();
+void testFormWaits();
+void testFormText();
+void testTokiEvents();
+void testMountBatch();
+void testGenBatch();
+void testHandEnum();
+void testFanIndex();
+void testFormGbSpeed();
 
 
 
@@ -38,6 +38,68 @@ constexpr int _tid34(int val, Suit suit)
          : 9 * static_cast<int>(suit) + val - 1;
 }
 
+constexpr Suit _tsuit(int id34)
+{
+    return id34 < 9 ? Suit::M
+         : id34 < 18 ? Suit::P
+         : id34 < 27 ? Suit::S
+         : id34 < 31 ? Suit::F
+         : Suit::Y;
+}
+
+constexpr int _tval(int id34)
+{
+    return id34 < 27 ? id34 % 9 + 1 : id34 < 31 ? id34 - 27 + 1 : id34 - 31 + 1;
+}
+
+constexpr int _tperiod(int id34)
+{
+    return id34 < 27 ? 9 : id34 < 31 ? 4 : 3;
+}
+
+constexpr bool _tend(int id34)
+{
+    return _tval(id34) == 1 || _tval(id34) == 9;
+}
+
+///
+/// \brief Properties of a tile kind, looked up by id34 instead of computed
+///
+struct T34Info
+{
+    Suit suit;
+    int val;
+    int dora; ///< id34 of the dora when this tile is the indicator
+    int indicator; ///< id34 of the indicator when this tile is the dora
+    bool z;
+    bool yao;
+    bool num19;
+};
+
+constexpr T34Info _tinfo(int id34)
+{
+    return T34Info {
+        _tsuit(id34),
+        _tval(id34),
+        id34 - _tval(id34) + 1 + _tval(id34) % _tperiod(id34),
+        id34 - _tval(id34) + 1 + (_tval(id34) + _tperiod(id34) - 2) % _tperiod(id34),
+        id34 >= 27,
+        id34 >= 27 || _tend(id34),
+        id34 < 27 && _tend(id34)
+    };
+}
+
+constexpr T34Info T34_INFOS[34] {
+    _tinfo(0), _tinfo(1), _tinfo(2), _tinfo(3), _tinfo(4),
+    _tinfo(5), _tinfo(6), _tinfo(7), _tinfo(8),
+    _tinfo(9), _tinfo(10), _tinfo(11), _tinfo(12), _tinfo(13),
+    _tinfo(14), _tinfo(15), _tinfo(16), _tinfo(17),
+    _tinfo(18), _tinfo(19), _tinfo(20), _tinfo(21), _tinfo(22),
+    _tinfo(23), _tinfo(24), _tinfo(25), _tinfo(26),
+    _tinfo(27), _tinfo(28), _tinfo(29), _tinfo(30),
+    _tinfo(31), _tinfo(32), _tinfo(33)
+};
+
 class T34
 {
 public:
@@ -112,36 +174,12 @@ public:
 
     Suit suit() const
     {
-#ifndef NDEBUG
-        assert(mInitialized);
-#endif
-        if (0 <= mId34 && mId34 < 9)
-            return Suit::M;
-        if (9 <= mId34 && mId34 < 18)
-            return Suit::P;
-        if (18 <= mId34 && mId34 < 27)
-            return Suit::S;
-        if (27 <= mId34 && mId34 < 31)
-            return Suit::F;
-        if (31 <= mId34 && mId34 < 34)
-            return Suit::Y;
-
-        unreached("T34::suit(): invalid");
+        return info().suit;
     }
 
     int val() const
     {
-#ifndef NDEBUG
-        assert(mInitialized);
-#endif
-        if (0 <= mId34 && mId34 < 27)
-            return mId34 % 9 + 1;
-        if (27 <= mId34 && mId34 < 31)
-            return mId34 - 27 + 1;
-        if (31 <= mId34 && mId34 < 34)
-            return mId34 - 31 + 1;
-
-        unreached("T34::val(): invalid");
+        return info().val;
     }
 
     const char *str() const
@@ -160,7 +198,7 @@ public:
 
     bool isZ() const
     {
-        return suit() == Suit::F || suit() == Suit::Y;
+        return info().z;
     }
 
     bool isNum() const
@@ -170,12 +208,12 @@ public:
 
     bool isNum19() const
     {
-        return isNum() && (val() == 1 || val() == 9);
+        return info().num19;
     }
 
     bool isYao() const
     {
-        return isZ() || val() == 1 || val() == 9;
+        return info().yao;
     }
 
     bool isYakuhai(int selfWind, int roundWind) const
@@ -220,51 +258,45 @@ public:
 
     bool operator%(T34 dora) const
     {
-        // since max of val() ranges from 1 to period (not period - 1),
-        // there is nothing to worry about
-        return suit() == dora.suit() && val() % period() + 1 == dora.val();
+        return info().dora == dora.id34();
     }
 
     T34 prev() const
     {
         assert(isNum() && val() >= 2);
         assume_opt_out(isNum() && val() >= 2);
-        return T34(suit(), val() - 1);
+        return T34(id34() - 1);
     }
 
     T34 pprev() const
     {
         assert(isNum() && val() >= 3);
         assume_opt_out(isNum() && val() >= 3);
-        return T34(suit(), val() - 2);
+        return T34(id34() - 2);
     }
 
     T34 next() const
     {
         assert(isNum() && 1 <= val() && val() <= 8);
         assume_opt_out(isNum() && 1 <= val() && val() <= 8);
-        return T34(suit(), val() + 1);
+        return T34(id34() + 1);
     }
 
     T34 nnext() const
     {
         assert(isNum() && 1 <= val() && val() <= 7);
         assume_opt_out(isNum() && 1 <= val() && val() <= 7);
-        return T34(suit(), val() + 2);
+        return T34(id34() + 2);
     }
 
     T34 dora() const
     {
-        return T34(suit(), val() % period() + 1);
+        return T34(info().dora);
     }
 
     T34 indicator() const
     {
-        // first '-1': from 1-index to 0-index
-        // second '+period': prevent being minus
-        // third '-1': previou tile
-        // last '+1': from 0-index to 1-index
-        return T34(suit(), (val() - 1 + period() - 1) % period() + 1);
+        return T34(info().indicator);
     }
 
     Wait waitAsSequence(T34 pick) const
@@ -291,20 +323,9 @@ public:
     }
 
 private:
-    int period() const
-    {
-        switch (suit()) {
-        case Suit::M:
-        case Suit::P:
-        case Suit::S:
-            return 9;
-        case Suit::F:
-            return 4;
-        case Suit::Y:
-            return 3;
-        default:
-            unreached("T34::period");
-        }
+    const T34Info &info() const
+    {
+        return T34_INFOS[id34()];
     }
 
 private:
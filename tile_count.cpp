@@ -1,4 +1,5 @@
 #include "tile_count.h"
+#include "util.h"
 
 #include <algorithm>
 #include <cassert>
@@ -121,6 +122,17 @@ void TileCount::inc(const T37 &t, int delta)
         mAka5s[static_cast<int>(t.suit())] += delta;
 }
 
+TileCount &TileCount::operator+=(const TileCount &rhs)
+{
+    for (int ti = 0; ti < 34; ti++)
+        mCounts[ti] += rhs.mCounts[ti];
+
+    for (int s = 0; s < 3; s++)
+        mAka5s[s] += rhs.mAka5s[s];
+
+    return *this;
+}
+
 TileCount &TileCount::operator-=(const TileCount &rhs)
 {
     for (int ti = 0; ti < 34; ti++) {
@@ -319,14 +331,14 @@ bool TileCount::dislike4(T34 t) const
     return true; // nobody likes this tile
 }
 
-std::vector<TileCount::Explain4Closed> TileCount::explain4(T34 pick) const
+TileCount::Explain4Closeds TileCount::explain4(T34 pick) const
 {
     // no assertion. the result will be illegal if the input is illegal
 
     T34Delta guard(mutableCounts(), pick, 1);
     (void) guard;
 
-    std::vector<Explain4Closed> res;
+    Explain4Closeds res;
 
     // enumerate for all possible birdheads
     for (int ti = 0; ti < 34; ti++) {
@@ -337,7 +349,7 @@ std::vector<TileCount::Explain4Closed> TileCount::explain4(T34 pick) const
             T34 pick(ti);
             Explain4Closed exp(pick);
             if (decomposeBirdless4(exp, mCounts)) {
-                res.push_back(exp);
+                res.pushBack(exp);
 
                 // 111-222-333 --> 123-123-123
                 auto checkSequences = [](T34 l, T34 m, T34 r) -> bool {
@@ -347,27 +359,27 @@ std::vector<TileCount::Explain4Closed> TileCount::explain4(T34 pick) const
                     if (checkSequences(exp.triplets[0], exp.triplets[1], exp.triplets[2])) {
                         Explain4Closed exp2(pick);
                         if (exp.sequences.size() == 1 && exp.sequences[0] < exp.triplets[0])
-                            exp2.sequences.push_back(exp.sequences[0]); // keep ordered
+                            exp2.sequences.pushBack(exp.sequences[0]); // keep ordered
                         for (int i = 0; i < 3; i++)
-                            exp2.sequences.push_back(exp.triplets[0]);
+                            exp2.sequences.pushBack(exp.triplets[0]);
                         if (exp.sequences.size() == 1 && exp2.sequences.size() == 3)
-                            exp2.sequences.push_back(exp.sequences[0]); // keep ordered
-                        res.push_back(exp2);
+                            exp2.sequences.pushBack(exp.sequences[0]); // keep ordered
+                        res.pushBack(exp2);
                     }
                 } else if (exp.triplets.size() == 4) { // 4 tri --> 3 seq + 1 tri
                     if (checkSequences(exp.triplets[0], exp.triplets[1], exp.triplets[2])) {
                         Explain4Closed exp3(pick);
                         for (int i = 0; i < 3; i++)
-                            exp3.sequences.push_back(exp.triplets[0]);
-                        exp3.triplets.push_back(exp.triplets[3]);
-                        res.push_back(exp3);
+                            exp3.sequences.pushBack(exp.triplets[0]);
+                        exp3.triplets.pushBack(exp.triplets[3]);
+                        res.pushBack(exp3);
                     }
                     if (checkSequences(exp.triplets[1], exp.triplets[2], exp.triplets[3])) {
                         Explain4Closed exp4(pick);
-                        exp4.triplets.push_back(exp.triplets[0]);
+                        exp4.triplets.pushBack(exp.triplets[0]);
                         for (int i = 1; i < 4; i++)
-                            exp4.sequences.push_back(exp.triplets[1]);
-                        res.push_back(exp4);
+                            exp4.sequences.pushBack(exp.triplets[1]);
+                        res.pushBack(exp4);
                     }
                 }
             }
@@ -378,6 +390,100 @@ std::vector<TileCount::Explain4Closed> TileCount::explain4(T34 pick) const
     return res;
 }
 
+///
+/// \brief Every way to read this 13-tile closed part as waiting in 4-meld form
+///
+/// Decomposing once and completing the splits per pick with
+/// explain4(pick, splits) is cheaper than explain4(pick) for each wait.
+///
+TileCount::Wait4Splits TileCount::splitWait4(int barkCt) const
+{
+    Wait4Splits res;
+    std::array<int, 34> c(mCounts);
+    Wait4Split cur;
+    cur.rest = Wait4Split::NONE;
+    cur.hasPair = false;
+    splitWait4(c, 0, 4 - barkCt, cur, res);
+    return res;
+}
+
+///
+/// \brief Same as explain4(pick) on the split 13-tile part, in the same order
+///
+TileCount::Explain4Closeds TileCount::explain4(T34 pick, const Wait4Splits &splits)
+{
+    Explain4Closeds res;
+
+    auto sortedPush = [](util::Stactor<T34, 4> &heads, T34 head) {
+        heads.pushBack(head);
+        for (auto it = heads.end() - 1; it != heads.begin() && head < *(it - 1); --it)
+            std::iter_swap(it, it - 1);
+    };
+
+    auto same = [](const Explain4Closed &a, const Explain4Closed &b) {
+        return a.pair == b.pair
+                && std::equal(a.triplets.begin(), a.triplets.end(),
+                              b.triplets.begin(), b.triplets.end())
+                && std::equal(a.sequences.begin(), a.sequences.end(),
+                              b.sequences.begin(), b.sequences.end());
+    };
+
+    for (const Wait4Split &split : splits) {
+        Explain4Closed exp(split.pair);
+        exp.triplets = split.triplets;
+        exp.sequences = split.sequences;
+
+        T34 head = split.restHead;
+        switch (split.rest) {
+        case Wait4Split::NONE:
+            unreached("TileCount::explain4: uncut rest");
+        case Wait4Split::SINGLE:
+            if (!(pick == head))
+                continue;
+            exp.pair = pick;
+            break;
+        case Wait4Split::BUMP:
+            if (!(pick == head))
+                continue;
+            sortedPush(exp.triplets, pick);
+            break;
+        case Wait4Split::SIDE:
+            if (head.val() >= 2 && pick.id34() + 1 == head.id34())
+                sortedPush(exp.sequences, pick);
+            else if (head.val() <= 7 && pick.id34() == head.id34() + 2)
+                sortedPush(exp.sequences, head);
+            else
+                continue;
+            break;
+        case Wait4Split::CLAMP:
+            if (pick.id34() != head.id34() + 1)
+                continue;
+            sortedPush(exp.sequences, head);
+            break;
+        }
+
+        if (util::none(res, [&](const Explain4Closed &e) { return same(e, exp); }))
+            res.pushBack(exp);
+    }
+
+    // order of explain4(pick): by pair, then more triplets first,
+    // then the higher triplet first as in 111222333444 -> 123x3 444 before 111 234x3
+    auto before = [](const Explain4Closed &a, const Explain4Closed &b) {
+        if (!(a.pair == b.pair))
+            return a.pair < b.pair;
+        if (a.triplets.size() != b.triplets.size())
+            return a.triplets.size() > b.triplets.size();
+        return !a.triplets.empty() && b.triplets[0] < a.triplets[0];
+    };
+
+    // at most MAX_EXPLAIN4 entries, insertion sort
+    for (size_t i = 1; i < res.size(); i++)
+        for (size_t j = i; j > 0 && before(res[j], res[j - 1]); j--)
+            std::swap(res[j], res[j - 1]);
+
+    return res;
+}
+
 bool TileCount::onlyInTriplet(T34 pick, int barkCt) const
 {
     assert(step(barkCt) == 0); // this algo does not work when step is -1
@@ -578,6 +684,80 @@ int TileCount::cutSubmeld(int id34, int maxCut) const
     return maxWork;
 }
 
+///
+/// \brief Cut the lowest remaining tile in every possible way, see splitWait4()
+///
+void TileCount::splitWait4(std::array<int, 34> &c, int from, int meldCt,
+                           Wait4Split &cur, Wait4Splits &res)
+{
+    int melds = static_cast<int>(cur.triplets.size() + cur.sequences.size());
+    int ti = from;
+    while (ti < 34 && c[ti] == 0)
+        ti++;
+
+    if (ti == 34) {
+        bool single = cur.rest == Wait4Split::SINGLE && !cur.hasPair && melds == meldCt;
+        bool other = cur.rest > Wait4Split::SINGLE && cur.hasPair && melds + 1 == meldCt;
+        if (single || other)
+            res.push_back(cur);
+        return;
+    }
+
+    T34 t(ti);
+    bool seqable = t.isNum() && t.val() <= 7;
+
+    if (melds < meldCt && c[ti] >= 3) {
+        c[ti] -= 3;
+        cur.triplets.pushBack(t);
+        splitWait4(c, ti, meldCt, cur, res);
+        cur.triplets.popBack();
+        c[ti] += 3;
+    }
+
+    if (melds < meldCt && seqable && c[ti + 1] > 0 && c[ti + 2] > 0) {
+        c[ti]--;
+        c[ti + 1]--;
+        c[ti + 2]--;
+        cur.sequences.pushBack(t);
+        splitWait4(c, ti, meldCt, cur, res);
+        cur.sequences.popBack();
+        c[ti]++;
+        c[ti + 1]++;
+        c[ti + 2]++;
+    }
+
+    if (!cur.hasPair && c[ti] >= 2) {
+        c[ti] -= 2;
+        cur.hasPair = true;
+        cur.pair = t;
+        splitWait4(c, ti, meldCt, cur, res);
+        cur.hasPair = false;
+        c[ti] += 2;
+    }
+
+    if (cur.rest != Wait4Split::NONE)
+        return;
+
+    auto cutRest = [&](Wait4Split::Rest rest, int ti2, int ct) {
+        c[ti]--;
+        c[ti2] -= ct;
+        cur.rest = rest;
+        cur.restHead = t;
+        splitWait4(c, ti, meldCt, cur, res);
+        cur.rest = Wait4Split::NONE;
+        c[ti]++;
+        c[ti2] += ct;
+    };
+
+    cutRest(Wait4Split::SINGLE, ti, 0);
+    if (c[ti] >= 2)
+        cutRest(Wait4Split::BUMP, ti, 1);
+    if (t.isNum() && t.val() <= 8 && c[ti + 1] > 0)
+        cutRest(Wait4Split::SIDE, ti + 1, 1);
+    if (seqable && c[ti + 2] > 0)
+        cutRest(Wait4Split::CLAMP, ti + 2, 1);
+}
+
 bool TileCount::decomposeBirdless4(Explain4Closed &exp,
                                    const std::array<int, 34> &c) const
 {
@@ -589,17 +769,21 @@ bool TileCount::decomposeBirdless4(Explain4Closed &exp,
             return false;
 
         if (remain >= 3) {
-            exp.triplets.push_back(T34(tj));
+            if (exp.triplets.size() + exp.sequences.size() == 4)
+                return false; // more than 4 melds
+            exp.triplets.pushBack(T34(tj));
             remain -= 3;
         }
 
         if (remain > 0) {
             if (T34(tj).isZ() || T34(tj).val() > 7)
                 return false; // must be a floating tile
+            if (exp.triplets.size() + exp.sequences.size() + remain > 4)
+                return false; // more than 4 melds
             borrows[1] += remain;
             borrows[2] += remain;
             while (remain --> 0)
-                exp.sequences.push_back(T34(tj));
+                exp.sequences.pushBack(T34(tj));
         }
 
         borrows[0] = borrows[1];
@@ -22,12 +22,36 @@ public:
 
     struct Explain4Closed
     {
+        Explain4Closed() = default;
         explicit Explain4Closed(T34 p) : pair(p) { }
         T34 pair;
-        std::vector<T34> triplets;
-        std::vector<T34> sequences;
+        util::Stactor<T34, 4> triplets;
+        util::Stactor<T34, 4> sequences;
     };
 
+    /// max number of closed-part explanations, by enumerating all hands
+    static const size_t MAX_EXPLAIN4 = 4;
+    using Explain4Closeds = util::Stactor<Explain4Closed, MAX_EXPLAIN4>;
+
+    ///
+    /// \brief A 13-tile closed part as melds and a rest that one pick completes
+    ///
+    /// SINGLE is a lone tile and no pair, the other rests come with a pair.
+    /// NONE is only seen while cutting.
+    ///
+    struct Wait4Split
+    {
+        enum Rest { NONE, SINGLE, BUMP, SIDE, CLAMP };
+        Rest rest;
+        T34 restHead; ///< lowest tile of the rest
+        bool hasPair;
+        T34 pair;
+        util::Stactor<T34, 4> triplets;
+        util::Stactor<T34, 4> sequences;
+    };
+
+    using Wait4Splits = std::vector<Wait4Split>;
+
     TileCount();
     explicit TileCount(AkadoraCount fillMode);
     explicit TileCount(std::initializer_list<T37> t37s);
@@ -54,6 +78,7 @@ public:
 
     void inc(const T37 &t, int delta);
 
+    TileCount &operator+=(const TileCount &rhs);
     TileCount &operator-=(const TileCount &rhs);
 
     int step(int barkCt) const;
@@ -76,7 +101,9 @@ public:
 
     bool dislike4(T34 t) const;
 
-    std::vector<Explain4Closed> explain4(T34 pick) const;
+    Explain4Closeds explain4(T34 pick) const;
+    Wait4Splits splitWait4(int barkCt) const;
+    static Explain4Closeds explain4(T34 pick, const Wait4Splits &splits);
     bool onlyInTriplet(T34 pick, int barkCt) const;
 
     int sum(const std::vector<T34> &ts) const;
@@ -111,6 +138,8 @@ private:
     int cutMeld(int i, int maxCut) const;
     int cutSubmeld(int i, int maxCut) const;
     bool decomposeBirdless4(Explain4Closed &exp, const std::array<int, 34> &mCounts) const;
+    static void splitWait4(std::array<int, 34> &c, int from, int meldCt,
+                           Wait4Split &cur, Wait4Splits &res);
 
 private:
     std::array<int, 34> mCounts;
@@ -0,0 +1,180 @@
+#ifndef SAKI_UTIL_PARALLEL_H
+#define SAKI_UTIL_PARALLEL_H
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+
+
+namespace saki
+{
+
+
+
+namespace util
+{
+
+
+
+///
+/// \brief Number of workers to use when the caller does not care
+///
+inline int workerCount(int wanted = 0)
+{
+    if (wanted > 0)
+        return wanted;
+
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return hw > 0 ? hw : 1;
+}
+
+///
+/// \brief Call f(i) for each i in [0, n) on 'threads' workers
+///
+/// Indices are handed out one by one from a shared counter,
+/// so uneven jobs (e.g. long and short rounds) balance themselves.
+/// The calling thread takes part as one of the workers.
+///
+template<typename F>
+void parallelFor(size_t n, int threads, F f)
+{
+    threads = workerCount(threads);
+    if (static_cast<size_t>(threads) > n)
+        threads = static_cast<int>(n);
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < n; i++)
+            f(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto work = [&next, n, &f]() {
+        for (size_t i = next++; i < n; i = next++)
+            f(i);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(work);
+
+    work();
+
+    for (auto &th : pool)
+        th.join();
+}
+
+
+
+///
+/// \brief Call f(i) for each i in [0, n) on 'threads' workers, with range stealing
+///
+/// Each worker starts with a contiguous block of indices and takes them
+/// from the front. A worker that runs dry steals the back half of the
+/// largest remaining block. Neighboring indices thus stay on one worker,
+/// which suits jobs whose cost is correlated with the index.
+///
+template<typename F>
+void parallelForStealing(size_t n, int threads, F f)
+{
+    threads = workerCount(threads);
+    if (static_cast<size_t>(threads) > n)
+        threads = static_cast<int>(n);
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < n; i++)
+            f(i);
+        return;
+    }
+
+    struct Block
+    {
+        std::mutex mutex;
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<std::unique_ptr<Block>> blocks;
+    for (int t = 0; t < threads; t++) {
+        blocks.emplace_back(new Block);
+        blocks.back()->begin = n * t / threads;
+        blocks.back()->end = n * (t + 1) / threads;
+    }
+
+    auto popOwn = [&blocks](int t, size_t &i) {
+        Block &b = *blocks[t];
+        std::lock_guard<std::mutex> lock(b.mutex);
+        if (b.begin == b.end)
+            return false;
+        i = b.begin++;
+        return true;
+    };
+
+    auto steal = [&blocks, threads](int t) {
+        int victim = -1;
+        size_t most = 0;
+        for (int v = 0; v < threads; v++) {
+            if (v == t)
+                continue;
+            std::lock_guard<std::mutex> lock(blocks[v]->mutex);
+            size_t left = blocks[v]->end - blocks[v]->begin;
+            if (left > most) {
+                most = left;
+                victim = v;
+            }
+        }
+
+        if (victim < 0)
+            return false;
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(blocks[victim]->mutex);
+            Block &b = *blocks[victim];
+            size_t left = b.end - b.begin;
+            if (left == 0)
+                return true; // lost the race, look again
+            end = b.end;
+            begin = b.end - (left + 1) / 2;
+            b.end = begin;
+        }
+
+        std::lock_guard<std::mutex> lock(blocks[t]->mutex);
+        blocks[t]->begin = begin;
+        blocks[t]->end = end;
+        return true;
+    };
+
+    auto work = [&](int t) {
+        size_t i;
+        do {
+            while (popOwn(t, i))
+                f(i);
+        } while (steal(t));
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(work, t);
+
+    work(0);
+
+    for (auto &th : pool)
+        th.join();
+}
+
+
+
+} // namespace util
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_UTIL_PARALLEL_H
@@ -0,0 +1,188 @@
+#include "wait_estimate.h"
+#include "tableview.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+
+namespace saki
+{
+
+
+
+WaitEstimate::WaitEstimate()
+{
+    mVisibles.fill(0);
+    mRiverCts.fill(0);
+    mBarkCts.fill(0);
+
+    for (int w = 0; w < 4; w++) {
+        mSums[w] = 0;
+        for (int ti = 0; ti < 34; ti++) {
+            mWeights[w][ti] = static_cast<int16_t>(calcWeight(w, T34(ti)));
+            mSums[w] += mWeights[w][ti];
+        }
+    }
+}
+
+///
+/// \brief Build from scratch, gives the same result as the updates
+///
+WaitEstimate::WaitEstimate(const TableView &view)
+    : WaitEstimate()
+{
+    for (const T37 &t : view.getDrids())
+        onVisible(t);
+
+    for (int w = 0; w < 4; w++) {
+        Who who(w);
+        for (const T37 &t : view.getRiver(who)) {
+            onVisible(t);
+            onDiscarded(who);
+        }
+
+        for (const M37 &m : view.getBarks(who))
+            onBarked(who, m);
+
+        for (int ti = 0; ti < 34; ti++)
+            if (view.genbutsu(who, T34(ti)))
+                onGenbutsu(who, T34(ti));
+
+        if (view.riichiEstablished(who))
+            onRiichiEstablished(who);
+    }
+}
+
+bool WaitEstimate::operator==(const WaitEstimate &that) const
+{
+    return mWeights == that.mWeights && mSums == that.mSums
+            && mVisibles == that.mVisibles && mGenbutsus == that.mGenbutsus
+            && mRiverCts == that.mRiverCts && mBarkCts == that.mBarkCts
+            && mRiichis == that.mRiichis;
+}
+
+///
+/// \brief A tile becomes face-up to everyone (discard, bark, indicator)
+///
+void WaitEstimate::onVisible(const T37 &t)
+{
+    mVisibles[t.id34()]++;
+    for (int w = 0; w < 4; w++)
+        updateNear(w, t, 2);
+}
+
+void WaitEstimate::onGenbutsu(Who who, T34 t)
+{
+    int w = who.index();
+    if (mGenbutsus[w].test(t.id34()))
+        return;
+
+    mGenbutsus[w].set(t.id34());
+    updateNear(w, t, 3);
+}
+
+void WaitEstimate::onDiscarded(Who who)
+{
+    mRiverCts[who.index()]++;
+}
+
+///
+/// \brief Count the bark and show its tiles, except the one from the river
+///
+/// For kakan, call it with the bark before the added tile is shown,
+/// and call onVisible() for the added tile instead.
+///
+void WaitEstimate::onBarked(Who who, const M37 &bark)
+{
+    mBarkCts[who.index()]++;
+
+    const auto &ts = bark.tiles();
+    for (int i = 0; i < static_cast<int>(ts.size()); i++)
+        if (i != bark.layIndex())
+            onVisible(ts[i]);
+}
+
+void WaitEstimate::onRiichiEstablished(Who who)
+{
+    mRiichis.set(who.index());
+}
+
+int WaitEstimate::tenpaiRate(Who who) const
+{
+    int w = who.index();
+    if (mRiichis.test(w))
+        return 1000;
+
+    int r = mRiverCts[w];
+    switch (mBarkCts[w]) {
+    case 0:
+        return std::min(400, 25 * r);
+    case 1:
+        return r > 12 ? std::min(900, 600 + 50 * (r - 13)) : 30 * r;
+    default:
+        return r > 5 ? std::min(900, 500 + 40 * (r - 6)) : 80 * r;
+    }
+}
+
+///
+/// \brief Rate that 't' is among the waits of 'who'
+///
+int WaitEstimate::waitRate(Who who, T34 t) const
+{
+    int w = who.index();
+    if (mSums[w] == 0)
+        return 0;
+
+    return tenpaiRate(who) * mWeights[w][t.id34()] / mSums[w];
+}
+
+int WaitEstimate::weight(Who who, T34 t) const
+{
+    return mWeights[who.index()][t.id34()];
+}
+
+///
+/// \brief Recompute weights of tiles within 'reach' of 't' in the suit
+///
+void WaitEstimate::updateNear(int w, T34 t, int reach)
+{
+    int lo = t.isNum() ? std::max(1, t.val() - reach) : t.val();
+    int hi = t.isNum() ? std::min(9, t.val() + reach) : t.val();
+    for (int v = lo; v <= hi; v++) {
+        T34 u(t.suit(), v);
+        int next = calcWeight(w, u);
+        mSums[w] += next - mWeights[w][u.id34()];
+        mWeights[w][u.id34()] = static_cast<int16_t>(next);
+    }
+}
+
+int WaitEstimate::calcWeight(int w, T34 t) const
+{
+    auto left = [this](T34 u) { return std::max(0, 4 - int(mVisibles[u.id34()])); };
+    auto block = [&left](T34 a, T34 b) { return std::min(left(a), left(b)); };
+
+    if (left(t) == 0 || mGenbutsus[w].test(t.id34()))
+        return 0;
+
+    int res = left(t); // tanki and shanpon
+    if (!t.isNum())
+        return res;
+
+    int v = t.val();
+    const std::bitset<34> &gen = mGenbutsus[w];
+
+    // ryanmen cut by suji, penchan cannot be
+    if (v >= 3 && !(v >= 4 && gen.test(t.id34() - 3)))
+        res += 2 * block(t.pprev(), t.prev());
+    if (v <= 7 && !(v <= 6 && gen.test(t.id34() + 3)))
+        res += 2 * block(t.next(), t.nnext());
+    if (2 <= v && v <= 8)
+        res += block(t.prev(), t.next()); // kanchan
+
+    return res;
+}
+
+
+
+} // namespace saki
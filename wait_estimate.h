@@ -0,0 +1,71 @@
+#ifndef SAKI_WAIT_ESTIMATE_H
+#define SAKI_WAIT_ESTIMATE_H
+
+#include "meld.h"
+#include "who.h"
+
+#include <array>
+#include <bitset>
+
+
+
+namespace saki
+{
+
+
+
+class TableView;
+
+///
+/// \brief Public-information guess of each player's tenpai and waits
+///
+/// Maintained by Table event by event, so queries are O(1) and an
+/// update only touches the few tiles whose weights it can change.
+/// Rates are in per-mille.
+///
+/// The wait weight of a tile counts the blocks, still possible by the
+/// visible tiles, that can wait on it, cut by genbutsu and suji.
+/// The tenpai rate is a rough function of river length and barks.
+///
+class WaitEstimate
+{
+public:
+    WaitEstimate();
+    explicit WaitEstimate(const TableView &view);
+    WaitEstimate(const WaitEstimate &copy) = default;
+    WaitEstimate &operator=(const WaitEstimate &assign) = default;
+    ~WaitEstimate() = default;
+
+    bool operator==(const WaitEstimate &that) const;
+
+    void onVisible(const T37 &t);
+    void onGenbutsu(Who who, T34 t);
+    void onDiscarded(Who who);
+    void onBarked(Who who, const M37 &bark);
+    void onRiichiEstablished(Who who);
+
+    int tenpaiRate(Who who) const;
+    int waitRate(Who who, T34 t) const;
+    int weight(Who who, T34 t) const;
+
+private:
+    void updateNear(int w, T34 t, int reach);
+    int calcWeight(int w, T34 t) const;
+
+private:
+    std::array<std::array<int16_t, 34>, 4> mWeights;
+    std::array<int, 4> mSums;
+    std::array<int8_t, 34> mVisibles;
+    std::array<std::bitset<34>, 4> mGenbutsus;
+    std::array<int, 4> mRiverCts;
+    std::array<int, 4> mBarkCts;
+    std::bitset<4> mRiichis;
+};
+
+
+
+} // namespace saki
+
+
+
+#endif // SAKI_WAIT_ESTIMATE_H